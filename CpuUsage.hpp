@@ -0,0 +1,55 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+// 当前进程已消耗的 CPU 时间（用户态 + 内核态，单位秒）
+inline double process_cpu_seconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit_time, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit_time, &kernel, &user))
+        return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    // FILETIME 单位为 100ns
+    return (double)(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+#endif
+}
+
+// 调用线程已消耗的 CPU 时间（单位秒）
+inline double thread_cpu_seconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit_time, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit_time, &kernel, &user))
+        return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0.0;
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
@@ -0,0 +1,159 @@
+#include "DecodeBudget.hpp"
+
+// 放大超过该比例才视为放大，窗口尺寸的细微变化不触发
+#define ENLARGE_RATIO 1.2
+
+const char *decode_tier_name(DecodeTier tier)
+{
+    switch (tier)
+    {
+    case DecodeTier::Full:
+        return "full";
+    case DecodeTier::Reduced:
+        return "reduced";
+    case DecodeTier::KeyOnly:
+        return "keyframes";
+    case DecodeTier::Paused:
+        return "paused";
+    default:
+        return "unknown";
+    }
+}
+
+double decode_tier_weight(DecodeTier tier)
+{
+    switch (tier)
+    {
+    case DecodeTier::Full:
+        return 1.0;
+    case DecodeTier::Reduced:
+        return 0.5;
+    case DecodeTier::KeyOnly:
+        // 关键帧比 P 帧大得多，按 1 秒 GOP 取一个偏保守的值
+        return 0.15;
+    default:
+        return 0.0;
+    }
+}
+
+static DecodeTier cheaper(DecodeTier a, DecodeTier b)
+{
+    return (int)a > (int)b ? a : b;
+}
+
+DecodeBudget::DecodeBudget(const DecodeBudgetOptions &options)
+    : options_(options)
+{
+}
+
+void DecodeBudget::reset(int streams, const DecodeBudgetOptions &options)
+{
+    options_ = options;
+    entries_.assign(streams > 0 ? streams : 0, Entry());
+    stats_ = DecodeBudgetStats();
+}
+
+DecodeTier DecodeBudget::ceiling(int stream) const
+{
+    const Entry &entry = entries_[stream];
+    if (!entry.visible)
+        return DecodeTier::Paused;
+    if (entry.area < options_.keyframe_area)
+        return DecodeTier::KeyOnly;
+    if (entry.area < options_.full_area)
+        return DecodeTier::Reduced;
+    return DecodeTier::Full;
+}
+
+DecodeTier DecodeBudget::tier(int stream) const
+{
+    return cheaper(ceiling(stream), entries_[stream].limit);
+}
+
+double DecodeBudget::total_weight() const
+{
+    double weight = 0.0;
+    for (int i = 0; i < size(); ++i)
+        weight += decode_tier_weight(tier(i));
+    return weight;
+}
+
+bool DecodeBudget::set_tile(int stream, bool visible, double area)
+{
+    if (stream < 0 || stream >= size())
+        return false;
+
+    Entry &entry = entries_[stream];
+    DecodeTier before = tier(stream);
+    bool enlarged = visible && (!entry.visible || area > entry.area * ENLARGE_RATIO);
+    entry.visible = visible;
+    entry.area = area;
+    // 放大的流不等下一次评估，直接去掉预算限制
+    if (enlarged && entry.limit != DecodeTier::Full)
+    {
+        entry.limit = DecodeTier::Full;
+        stats_.enlargements++;
+    }
+    return enlarged && (int)tier(stream) < (int)before;
+}
+
+bool DecodeBudget::evaluate(double cores_used)
+{
+    stats_.evaluations++;
+    stats_.last_cores = cores_used;
+    double weight = total_weight();
+    if (options_.core_budget <= 0.0 || weight <= 0.0)
+        return false;
+
+    // 一路全帧率解码的估计占用
+    double unit = cores_used / weight;
+    bool changed = false;
+
+    if (cores_used > options_.core_budget)
+    {
+        // 按估计节省的占用一次降够，从最小的可见格子开始
+        double projected = cores_used;
+        while (projected > options_.core_budget)
+        {
+            int victim = -1;
+            for (int i = 0; i < size(); ++i)
+            {
+                if (entries_[i].visible && (int)tier(i) < (int)DecodeTier::KeyOnly &&
+                    (victim < 0 || entries_[i].area < entries_[victim].area))
+                    victim = i;
+            }
+            if (victim < 0)
+                break;
+
+            DecodeTier before = tier(victim);
+            entries_[victim].limit = (DecodeTier)((int)before + 1);
+            projected -= (decode_tier_weight(before) - decode_tier_weight(tier(victim))) * unit;
+            stats_.demotions++;
+            changed = true;
+        }
+        return changed;
+    }
+
+    // 有余量时每次只恢复一级，避免在预算边缘来回切换
+    int candidate = -1;
+    for (int i = 0; i < size(); ++i)
+    {
+        if (entries_[i].visible && (int)entries_[i].limit > (int)ceiling(i) &&
+            (candidate < 0 || entries_[i].area > entries_[candidate].area))
+            candidate = i;
+    }
+    if (candidate < 0)
+        return false;
+
+    Entry &entry = entries_[candidate];
+    DecodeTier before = tier(candidate);
+    DecodeTier limit = (DecodeTier)((int)entry.limit - 1);
+    DecodeTier after = cheaper(ceiling(candidate), limit);
+    double projected = cores_used + (decode_tier_weight(after) - decode_tier_weight(before)) * unit;
+    if (projected > options_.core_budget * options_.headroom)
+        return false;
+
+    entry.limit = limit;
+    stats_.promotions++;
+    return after != before;
+}
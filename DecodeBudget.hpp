@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 解码档位，按开销从高到低排列
+enum class DecodeTier
+{
+    Full,    // 全帧率解码
+    Reduced, // 解码后隔帧丢弃（解码器支持时同时跳过非参考帧）
+    KeyOnly, // 只解关键帧：可寻址源用 TRICKMODE_KEY_UNITS 寻址，直播源在解码器前丢弃非关键帧
+    Paused,  // 不解码：可寻址源暂停管道，直播源在解码器前丢弃全部数据（保持连接）
+    Count
+};
+
+const char *decode_tier_name(DecodeTier tier);
+// 相对全帧率的估计解码开销
+double decode_tier_weight(DecodeTier tier);
+
+struct DecodeBudgetOptions
+{
+    double core_budget = 0.0;              // 解码允许占用的核数，<= 0 时只按可见性与格子大小分档
+    double full_area = 320.0 * 180.0;      // 格子面积（像素）不小于它才全帧率解码
+    double keyframe_area = 160.0 * 90.0;   // 格子面积小于它只解关键帧
+    double headroom = 0.8;                 // 升级后的估计占用不超过预算的该比例才升级
+};
+
+struct DecodeBudgetStats
+{
+    uint64_t evaluations = 0;
+    uint64_t promotions = 0;   // 因预算余量升级的次数
+    uint64_t demotions = 0;    // 因超出预算降级的次数
+    uint64_t enlargements = 0; // 格子放大后立即升级的次数
+    double last_cores = 0.0;   // 最近一次测得的占用
+};
+
+// 大量摄像头的解码预算调度。每路的档位取两者中较低的一个：
+//   上限：由可见性和屏幕上的格子面积决定（看不见的暂停，小格子不需要全帧率）；
+//   预算限制：测得的核占用超出预算时，从最小的可见格子开始逐级降级，有余量时从最大的格子开始逐级恢复。
+// 可见流最低降到只解关键帧，不会因预算被暂停。被放大的流立即恢复到上限，由之后的评估降级其他流。
+// 所有调用都在同一线程（渲染线程）上
+class DecodeBudget
+{
+public:
+    explicit DecodeBudget(const DecodeBudgetOptions &options = DecodeBudgetOptions());
+
+    void reset(int streams, const DecodeBudgetOptions &options);
+
+    // 布局、窗口尺寸或可见性变化后调用，area 为格子在屏幕上的像素面积。
+    // 返回 true 表示该流被放大（可见或面积变大），档位已经立即提升
+    bool set_tile(int stream, bool visible, double area);
+    // 按测得的核占用调整各路的预算限制，返回是否有流的档位变化
+    bool evaluate(double cores_used);
+
+    DecodeTier tier(int stream) const;
+    DecodeTier ceiling(int stream) const;
+    int size() const { return (int)entries_.size(); }
+    const DecodeBudgetOptions &options() const { return options_; }
+    const DecodeBudgetStats &stats() const { return stats_; }
+
+private:
+    struct Entry
+    {
+        bool visible = false;
+        double area = 0.0;
+        DecodeTier limit = DecodeTier::Full; // 预算限制，Full 表示不限制
+    };
+
+    double total_weight() const;
+
+    DecodeBudgetOptions options_;
+    std::vector<Entry> entries_;
+    DecodeBudgetStats stats_;
+};
@@ -0,0 +1,222 @@
+#include "DecodeTierGate.hpp"
+
+#include <cstring>
+#include <iostream>
+
+static bool is_video_decoder(GstElement *element)
+{
+    GstElementFactory *factory = gst_element_get_factory(element);
+    const gchar *klass = factory ? gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS) : nullptr;
+    return klass && strstr(klass, "Decoder") && strstr(klass, "Video");
+}
+
+DecodeTierGate::DecodeTierGate()
+    : pipeline_(nullptr), element_added_id_(0), decoder_(nullptr), tier_((int)DecodeTier::Full),
+      promoted_at_us_(0), seekable_(-1), trickmode_(false), pipeline_tier_(DecodeTier::Full), applied_tier_(DecodeTier::Full), need_keyframe_(false), reduced_phase_(0),
+      decoded_(0), dropped_before_(0), dropped_after_(0), promotions_(0),
+      promote_latency_max_us_(0), promote_latency_sum_us_(0)
+{
+}
+
+DecodeTierGate::~DecodeTierGate()
+{
+    detach();
+}
+
+void DecodeTierGate::attach(GstElement *pipeline)
+{
+    detach();
+    pipeline_ = GST_ELEMENT(gst_object_ref(pipeline));
+    // decodebin / uridecodebin 在协商后才创建解码器
+    element_added_id_ = g_signal_connect(pipeline_, "deep-element-added", G_CALLBACK(deep_element_added), this);
+
+    // 管道描述中直接写出的解码器已经存在
+    GstIterator *it = gst_bin_iterate_recurse(GST_BIN(pipeline_));
+    gst_iterator_foreach(it, existing_element, this);
+    gst_iterator_free(it);
+}
+
+void DecodeTierGate::detach()
+{
+    if (!pipeline_)
+        return;
+    g_signal_handler_disconnect(pipeline_, element_added_id_);
+    element_added_id_ = 0;
+    GstElement *decoder = decoder_.exchange(nullptr);
+    if (decoder)
+        gst_object_unref(decoder);
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    gst_object_unref(pipeline_);
+    pipeline_ = nullptr;
+    seekable_ = -1;
+    trickmode_ = false;
+    pipeline_tier_ = DecodeTier::Full;
+}
+
+void DecodeTierGate::existing_element(const GValue *value, gpointer data)
+{
+    deep_element_added(nullptr, nullptr, GST_ELEMENT(g_value_get_object(value)), data);
+}
+
+void DecodeTierGate::deep_element_added(GstBin *bin, GstBin *sub_bin, GstElement *element, gpointer data)
+{
+    DecodeTierGate *gate = static_cast<DecodeTierGate *>(data);
+    if (!is_video_decoder(element))
+        return;
+
+    // 只控制第一个视频解码器
+    GstElement *expected = nullptr;
+    if (!gate->decoder_.compare_exchange_strong(expected, GST_ELEMENT(gst_object_ref(element))))
+    {
+        gst_object_unref(element);
+        return;
+    }
+
+    GstPad *sink = gst_element_get_static_pad(element, "sink");
+    GstPad *src = gst_element_get_static_pad(element, "src");
+    if (sink)
+    {
+        gst_pad_add_probe(sink, GST_PAD_PROBE_TYPE_BUFFER, decoder_sink_probe, gate, nullptr);
+        gst_object_unref(sink);
+    }
+    if (src)
+    {
+        gst_pad_add_probe(src, GST_PAD_PROBE_TYPE_BUFFER, decoder_src_probe, gate, nullptr);
+        gst_object_unref(src);
+    }
+    std::cout << "Decode tiers controlling " << GST_OBJECT_NAME(element) << std::endl;
+}
+
+GstPadProbeReturn DecodeTierGate::decoder_sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    DecodeTierGate *gate = static_cast<DecodeTierGate *>(data);
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    DecodeTier tier = gate->tier();
+
+    if (tier != gate->applied_tier_)
+    {
+        // skip-frame（gst-libav）：1 跳过非参考帧
+        GstElement *decoder = gate->decoder_.load(std::memory_order_acquire);
+        if (decoder && g_object_class_find_property(G_OBJECT_GET_CLASS(decoder), "skip-frame"))
+            g_object_set(decoder, "skip-frame", tier == DecodeTier::Reduced ? 1 : 0, nullptr);
+        gate->applied_tier_ = tier;
+    }
+
+    // 丢过压缩帧之后参考链断开，必须等下一个关键帧
+    bool delta = GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (tier == DecodeTier::Paused || (delta && (tier == DecodeTier::KeyOnly || gate->need_keyframe_)))
+    {
+        gate->need_keyframe_ = true;
+        gate->dropped_before_.fetch_add(1, std::memory_order_relaxed);
+        return GST_PAD_PROBE_DROP;
+    }
+    if (!delta)
+        gate->need_keyframe_ = false;
+
+    // 恢复请求之后第一个能完整解码的帧
+    if ((int)tier <= (int)DecodeTier::Reduced)
+    {
+        gint64 requested = gate->promoted_at_us_.exchange(0, std::memory_order_relaxed);
+        if (requested)
+        {
+            uint64_t latency = (uint64_t)(g_get_monotonic_time() - requested);
+            gate->promotions_.fetch_add(1, std::memory_order_relaxed);
+            gate->promote_latency_sum_us_.fetch_add(latency, std::memory_order_relaxed);
+            uint64_t max = gate->promote_latency_max_us_.load(std::memory_order_relaxed);
+            if (latency > max)
+                gate->promote_latency_max_us_.store(latency, std::memory_order_relaxed);
+        }
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn DecodeTierGate::decoder_src_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    DecodeTierGate *gate = static_cast<DecodeTierGate *>(data);
+    gate->decoded_.fetch_add(1, std::memory_order_relaxed);
+    // 降帧率：隔帧丢弃，后面的缩放、转换和上传都减半
+    if (gate->tier() == DecodeTier::Reduced && (gate->reduced_phase_++ & 1))
+    {
+        gate->dropped_after_.fetch_add(1, std::memory_order_relaxed);
+        return GST_PAD_PROBE_DROP;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+bool DecodeTierGate::query_seekable()
+{
+    if (seekable_ < 0)
+    {
+        // 预卷之前查询不到，下次再试
+        GstQuery *query = gst_query_new_seeking(GST_FORMAT_TIME);
+        if (gst_element_query(pipeline_, query))
+        {
+            gboolean seekable = FALSE;
+            gst_query_parse_seeking(query, nullptr, &seekable, nullptr, nullptr);
+            seekable_ = seekable ? 1 : 0;
+        }
+        gst_query_unref(query);
+    }
+    return seekable_ > 0;
+}
+
+void DecodeTierGate::set_tier(DecodeTier tier)
+{
+    // 探针立即按新档位丢帧
+    DecodeTier previous = (DecodeTier)tier_.exchange((int)tier, std::memory_order_relaxed);
+    if ((int)previous >= (int)DecodeTier::KeyOnly && (int)tier <= (int)DecodeTier::Reduced)
+        promoted_at_us_.store(g_get_monotonic_time(), std::memory_order_relaxed);
+    apply_pipeline_tier();
+}
+
+void DecodeTierGate::reapply()
+{
+    apply_pipeline_tier();
+}
+
+// 直播源完全由探针处理；可寻址源让解复用器少读数据，并由 sink 同步限速。
+// pipeline_tier_ 只在状态切换和寻址都完成后才更新，预卷前查询不到是否可寻址时保持未应用
+void DecodeTierGate::apply_pipeline_tier()
+{
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    DecodeTier tier = this->tier();
+    if (!pipeline_ || tier == pipeline_tier_ || !query_seekable())
+        return;
+    if (tier == DecodeTier::Paused)
+    {
+        gst_element_set_state(pipeline_, GST_STATE_PAUSED);
+        pipeline_tier_ = tier;
+        return;
+    }
+    if (pipeline_tier_ == DecodeTier::Paused)
+        gst_element_set_state(pipeline_, GST_STATE_PLAYING);
+
+    bool key_only = tier == DecodeTier::KeyOnly;
+    if (key_only != trickmode_)
+    {
+        gint64 position = 0;
+        if (!gst_element_query_position(pipeline_, GST_FORMAT_TIME, &position))
+            return;
+        // 从当前位置之后的关键帧开始，退出关键帧模式时最多跳过一个 GOP
+        int flags = GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_AFTER;
+        if (key_only)
+            flags |= GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS;
+        if (!gst_element_seek(pipeline_, 1.0, GST_FORMAT_TIME, (GstSeekFlags)flags,
+                              GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, -1))
+            return;
+        trickmode_ = key_only;
+    }
+    pipeline_tier_ = tier;
+}
+
+DecodeGateStats DecodeTierGate::stats() const
+{
+    DecodeGateStats stats;
+    stats.decoded = decoded_.load(std::memory_order_relaxed);
+    stats.dropped_before = dropped_before_.load(std::memory_order_relaxed);
+    stats.dropped_after = dropped_after_.load(std::memory_order_relaxed);
+    stats.promotions = promotions_.load(std::memory_order_relaxed);
+    stats.promote_latency_max_ms = promote_latency_max_us_.load(std::memory_order_relaxed) / 1000.0;
+    stats.promote_latency_sum_ms = promote_latency_sum_us_.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
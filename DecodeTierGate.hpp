@@ -0,0 +1,79 @@
+#pragma once
+#include "gst/gst.h"
+
+#include "DecodeBudget.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// 解码档位执行统计
+struct DecodeGateStats
+{
+    uint64_t decoded;             // 解码器输出的帧
+    uint64_t dropped_before;      // 在解码器前丢弃的压缩帧
+    uint64_t dropped_after;       // 降帧率档位在解码后丢弃的帧
+    uint64_t promotions;          // 从只解关键帧 / 暂停恢复解码的次数
+    double promote_latency_max_ms; // 恢复请求到第一个关键帧进入解码器
+    double promote_latency_sum_ms;
+};
+
+// 把 DecodeBudget 的档位作用到一条管道上。
+// 通过 deep-element-added 找到（decodebin 等内部的）视频解码器，在它的 sink/src pad 上挂探针：
+//   直播源：只解关键帧时丢弃 DELTA_UNIT，暂停时全部丢弃；恢复后丢到下一个关键帧为止，所以最多一个 GOP
+//   可寻址源：只解关键帧用 TRICKMODE_KEY_UNITS 寻址（解复用器只送关键帧），暂停时管道进入 PAUSED
+//   降帧率：解码器有 skip-frame 属性时跳过非参考帧，解码后隔帧丢弃，省去缩放、转换和上传
+// set_tier 可以在任意线程调用，探针只读原子变量
+class DecodeTierGate
+{
+public:
+    DecodeTierGate();
+    ~DecodeTierGate();
+
+    DecodeTierGate(const DecodeTierGate &) = delete;
+    DecodeTierGate &operator=(const DecodeTierGate &) = delete;
+
+    // 在管道创建后、启动前调用
+    void attach(GstElement *pipeline);
+    void detach();
+
+    void set_tier(DecodeTier tier);
+    // 预卷完成（ASYNC_DONE）时调用：预卷前请求的档位此时才能作用到可寻址管道
+    void reapply();
+    DecodeTier tier() const { return (DecodeTier)tier_.load(std::memory_order_relaxed); }
+    // 是否找到了视频解码器
+    bool has_decoder() const { return decoder_.load(std::memory_order_acquire) != nullptr; }
+
+    DecodeGateStats stats() const;
+
+private:
+    bool query_seekable();
+    void apply_pipeline_tier();
+    static void existing_element(const GValue *value, gpointer data);
+    static void deep_element_added(GstBin *bin, GstBin *sub_bin, GstElement *element, gpointer data);
+    static GstPadProbeReturn decoder_sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+    static GstPadProbeReturn decoder_src_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+
+    GstElement *pipeline_;
+    gulong element_added_id_;
+    std::atomic<GstElement *> decoder_;
+    std::atomic<int> tier_;
+    std::atomic<gint64> promoted_at_us_; // 恢复请求的单调时间，0 表示没有等待中的恢复
+    // 以下由 pipeline_mutex_ 保护（set_tier 与 reapply 可能在不同线程）
+    std::mutex pipeline_mutex_;
+    int seekable_;              // -1 未知
+    bool trickmode_;            // 可寻址源当前是否处于关键帧寻址模式
+    DecodeTier pipeline_tier_;  // 已经作用到管道状态与寻址的档位
+
+    // 以下只在解码器的流线程上使用
+    DecodeTier applied_tier_;
+    bool need_keyframe_;
+    uint32_t reduced_phase_;
+
+    std::atomic<uint64_t> decoded_;
+    std::atomic<uint64_t> dropped_before_;
+    std::atomic<uint64_t> dropped_after_;
+    std::atomic<uint64_t> promotions_;
+    std::atomic<uint64_t> promote_latency_max_us_;
+    std::atomic<uint64_t> promote_latency_sum_us_;
+};
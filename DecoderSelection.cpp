@@ -0,0 +1,154 @@
+#include "DecoderSelection.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+static bool parse_rank(const std::string &text, int &rank)
+{
+    static const std::pair<const char *, int> names[] = {
+        {"none", GST_RANK_NONE}, {"marginal", GST_RANK_MARGINAL}, {"secondary", GST_RANK_SECONDARY}, {"primary", GST_RANK_PRIMARY}};
+    size_t sign = text.find_first_of("+-");
+    std::string base = text.substr(0, sign);
+    char *end = nullptr;
+    rank = (int)std::strtol(base.c_str(), &end, 10);
+    if (base.empty() || *end != '\0')
+    {
+        bool found = false;
+        for (const auto &name : names)
+        {
+            if (base == name.first)
+            {
+                rank = name.second;
+                found = true;
+            }
+        }
+        if (!found)
+            return false;
+    }
+    if (sign != std::string::npos)
+    {
+        int offset = (int)std::strtol(text.c_str() + sign, &end, 10);
+        if (*end != '\0')
+            return false;
+        rank += offset;
+    }
+    return rank >= 0;
+}
+
+bool parse_decoder_ranks(const std::string &spec, DecoderRankPolicy &policy)
+{
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        size_t colon = item.find(':');
+        int rank = 0;
+        if (colon == std::string::npos || colon == 0 || !parse_rank(item.substr(colon + 1), rank))
+        {
+            std::cerr << "Invalid decoder rank \"" << item << "\", expected factory:rank" << std::endl;
+            return false;
+        }
+        policy.ranks.push_back({item.substr(0, colon), rank});
+    }
+    return true;
+}
+
+static bool has_thread_property(GstElementFactory *factory)
+{
+    GType type = gst_element_factory_get_element_type(factory);
+    if (!type)
+        return false;
+    GObjectClass *klass = (GObjectClass *)g_type_class_ref(type);
+    bool threaded = g_object_class_find_property(klass, "max-threads") || g_object_class_find_property(klass, "threads") ||
+                    g_object_class_find_property(klass, "n-threads");
+    g_type_class_unref(klass);
+    return threaded;
+}
+
+int apply_decoder_ranks(const DecoderRankPolicy &policy)
+{
+    int changed = 0;
+    if (policy.prefer_threaded)
+    {
+        GList *decoders = gst_element_factory_list_get_elements(
+            GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO, GST_RANK_MARGINAL);
+        for (GList *item = decoders; item; item = item->next)
+        {
+            // 元素类型只有插件加载后才有
+            GstPluginFeature *feature = gst_plugin_feature_load(GST_PLUGIN_FEATURE(item->data));
+            if (!feature)
+                continue;
+            if (gst_plugin_feature_get_rank(feature) < GST_RANK_PRIMARY + 1 && has_thread_property(GST_ELEMENT_FACTORY(feature)))
+            {
+                gst_plugin_feature_set_rank(feature, GST_RANK_PRIMARY + 1);
+                std::cout << "Decoder rank: " << gst_plugin_feature_get_name(feature) << " -> " << GST_RANK_PRIMARY + 1
+                          << " (threaded)" << std::endl;
+                changed++;
+            }
+            gst_object_unref(feature);
+        }
+        gst_plugin_feature_list_free(decoders);
+    }
+
+    for (const auto &rank : policy.ranks)
+    {
+        GstElementFactory *factory = ElementFactoryCache::instance().find(rank.first);
+        if (!factory)
+        {
+            std::cerr << "Decoder rank: no element " << rank.first << std::endl;
+            continue;
+        }
+        gst_plugin_feature_set_rank(GST_PLUGIN_FEATURE(factory), (guint)rank.second);
+        std::cout << "Decoder rank: " << rank.first << " -> " << rank.second << std::endl;
+        changed++;
+    }
+    return changed;
+}
+
+ElementSpec select_demuxer(const std::string &caps_string)
+{
+    ElementSpec spec;
+    GstCaps *caps = caps_string.empty() ? nullptr : gst_caps_from_string(caps_string.c_str());
+    if (!caps)
+        return spec;
+    GList *demuxers = gst_element_factory_list_get_elements(GST_ELEMENT_FACTORY_TYPE_DEMUXER, GST_RANK_MARGINAL);
+    GList *matching = gst_element_factory_list_filter(demuxers, caps, GST_PAD_SINK, FALSE);
+    matching = g_list_sort(matching, (GCompareFunc)gst_plugin_feature_rank_compare_func);
+    if (matching)
+    {
+        spec.factory = gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(matching->data));
+        spec.name = "dec";
+    }
+    gst_plugin_feature_list_free(matching);
+    gst_plugin_feature_list_free(demuxers);
+    gst_caps_unref(caps);
+    return spec;
+}
+
+SourceProfile auto_file_profile(const MediaInfo *media)
+{
+    SourceProfile profile = source_profile(SourceKind::File);
+    const char *decoder = ElementFactoryCache::instance().find("decodebin3") ? "decodebin3" : "decodebin";
+    bool has_audio = media && media->has_audio;
+    ElementSpec demuxer = media ? select_demuxer(media->container_caps) : ElementSpec();
+    profile.video_chain.clear();
+    profile.audio_chain.clear();
+    if (!demuxer.factory.empty())
+    {
+        // 容器已知：分离器直接接在源后面（拉模式，不经过 typefind），每路的 caps 由分离器给出
+        profile.name = "file (demuxer from discovery)";
+        profile.demuxer = demuxer;
+        profile.video_chain = {{decoder}};
+        if (has_audio)
+            profile.audio_chain = {{decoder}, {"audioconvert"}, {"audioresample"}, {"autoaudiosink"}};
+    }
+    else
+    {
+        profile.name = "file (auto-plugged)";
+        profile.demuxer = {decoder, "dec"};
+        if (has_audio)
+            profile.audio_chain = {{"audioconvert"}, {"audioresample"}, {"autoaudiosink"}};
+    }
+    return profile;
+}
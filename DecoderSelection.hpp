@@ -0,0 +1,31 @@
+#pragma once
+#include "gst/gst.h"
+
+#include "MediaDiscovery.hpp"
+#include "PipelineBuilder.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// 解码器 rank 策略：decodebin3/parsebin 按 rank 在候选中选择，这里只调整注册表中的 rank
+struct DecoderRankPolicy
+{
+    std::vector<std::pair<std::string, int>> ranks; // 指定工厂的 rank，最后应用
+    // 有线程数属性（max-threads/threads/n-threads）的视频解码器至少排到 primary + 1，
+    // 同一格式有多个软件解码器时选多线程的；要用硬件解码器时再用 ranks 把它排到更高
+    bool prefer_threaded = false;
+};
+
+// "factory:rank,factory:rank"，rank 为数字或 none/marginal/secondary/primary，可带 +N/-N
+bool parse_decoder_ranks(const std::string &spec, DecoderRankPolicy &policy);
+// 应用到注册表，返回修改的工厂数（prefer_threaded 需要加载解码器插件以检查属性）
+int apply_decoder_ranks(const DecoderRankPolicy &policy);
+
+// 能处理 caps 的 rank 最高的分离器，没有返回空 factory
+ElementSpec select_demuxer(const std::string &caps);
+
+// 本地文件的自动配置：探测结果中的容器有分离器时直接用它（管道中不再 typefind），
+// 每路再由 decodebin3 选择解析器和解码器；没有探测结果或基本流时由 decodebin3 自己 typefind。
+// 只在有音频时接音频分支。没有 decodebin3 时退回 decodebin
+SourceProfile auto_file_profile(const MediaInfo *media);
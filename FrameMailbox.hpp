@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// 帧邮箱计数快照
+struct FrameCounters
+{
+    uint64_t produced;    // 生产者发布的帧数
+    uint64_t consumed;    // 消费者取走的帧数
+    uint64_t overwritten; // 未被取走就被新帧覆盖的帧数
+};
+
+// 三缓冲“最新帧优先”邮箱
+// 生产者独占 back 槽，消费者独占 front 槽，中间槽通过一次原子交换在两者之间传递。
+// 双方都不会阻塞对方：生产者总是立即发布，消费者只拿到最新的一帧。
+template <typename T>
+class FrameMailbox
+{
+public:
+    FrameMailbox()
+        : front_(0), back_(1), middle_(2)
+    {
+    }
+
+    FrameMailbox(const FrameMailbox &) = delete;
+    FrameMailbox &operator=(const FrameMailbox &) = delete;
+
+    // 生产者：当前可写的槽
+    T &back() { return slots_[back_]; }
+
+    // 生产者：发布 back 槽，返回 true 表示覆盖了一帧尚未被取走的数据
+    bool publish()
+    {
+        uint8_t previous = middle_.exchange(back_ | kDirty, std::memory_order_acq_rel);
+        back_ = previous & kIndexMask;
+        produced_.fetch_add(1, std::memory_order_relaxed);
+        if (previous & kDirty)
+        {
+            overwritten_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // 消费者：有新帧时交换到 front 槽并返回 true
+    bool acquire()
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & kDirty))
+            return false;
+
+        uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & kIndexMask;
+        consumed_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 消费者：当前持有的槽
+    T &front() { return slots_[front_]; }
+
+    // 是否有尚未取走的新帧（任意线程）
+    bool has_new() const
+    {
+        return (middle_.load(std::memory_order_acquire) & kDirty) != 0;
+    }
+
+    // 三个槽，用于初始化或清理（只能在双方都停止时调用）
+    T &slot(int index) { return slots_[index]; }
+    static constexpr int slot_count() { return 3; }
+
+    FrameCounters counters() const
+    {
+        return {produced_.load(std::memory_order_relaxed),
+                consumed_.load(std::memory_order_relaxed),
+                overwritten_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    static constexpr uint8_t kDirty = 0x80;
+    static constexpr uint8_t kIndexMask = 0x03;
+
+    T slots_[3];
+    uint8_t front_;              // 仅消费者访问
+    uint8_t back_;               // 仅生产者访问
+    std::atomic<uint8_t> middle_; // 中间槽索引 | kDirty
+
+    std::atomic<uint64_t> produced_{0};
+    std::atomic<uint64_t> consumed_{0};
+    std::atomic<uint64_t> overwritten_{0};
+};
@@ -0,0 +1,114 @@
+#include "FramePacing.hpp"
+
+#include <cmath>
+#include <fstream>
+
+FramePacing::FramePacing(size_t max_records)
+    : max_records_(max_records)
+{
+    reset(1e6 / 60.0, 1);
+}
+
+void FramePacing::reset(double nominal_period_us, int swap_interval)
+{
+    swap_interval_ = swap_interval;
+    period_us_ = nominal_period_us > 0.0 ? nominal_period_us : 1e6 / 60.0;
+    content_period_us_ = 0.0;
+    has_swap_ = false;
+    has_frame_ = false;
+    records_.clear();
+    summary_ = PacingSummary();
+    swap_total_us_ = 0.0;
+}
+
+void FramePacing::record(Clock::time_point start, Clock::time_point end, bool new_frame)
+{
+    if (!has_swap_)
+        origin_ = start;
+
+    // 交换间隔不为 0 时交换结束对齐 vblank，用来细化刷新周期（与呈现调度器相同的估计方式）
+    if (has_swap_ && swap_interval_ != 0)
+    {
+        double interval_us = std::chrono::duration<double, std::micro>(end - last_swap_).count();
+        double vblanks = std::round(interval_us / period_us_);
+        if (vblanks >= 1.0 && vblanks <= 8.0)
+        {
+            double measured = interval_us / vblanks;
+            if (std::fabs(measured - period_us_) < period_us_ * 0.25)
+                period_us_ += (measured - period_us_) * 0.05;
+        }
+    }
+
+    double block_us = std::chrono::duration<double, std::micro>(end - start).count();
+    summary_.swaps++;
+    swap_total_us_ += block_us;
+    if (block_us > summary_.swap_max_us)
+        summary_.swap_max_us = block_us;
+    // 正常情况下最多等待一个周期，更久说明目标 vblank 已经错过
+    if (swap_interval_ != 0 && block_us > period_us_)
+        summary_.missed_vblanks += (uint64_t)std::floor(block_us / period_us_);
+
+    SwapRecord entry;
+    entry.start_us = std::chrono::duration<double, std::micro>(start - origin_).count();
+    entry.end_us = std::chrono::duration<double, std::micro>(end - origin_).count();
+    entry.new_frame = new_frame;
+    if (new_frame)
+    {
+        summary_.new_frames++;
+        if (has_frame_)
+        {
+            // 上一帧停留的 vblank 数，超出内容节奏允许的部分计为重复帧（24fps@60Hz 允许 3 个）
+            double held_us = std::chrono::duration<double, std::micro>(end - last_frame_).count();
+            int held = (int)std::lround(held_us / period_us_);
+            double expected = content_period_us_ > 0.0 ? content_period_us_ / period_us_ : 1.0;
+            int allowed = (int)std::ceil(expected - 0.05);
+            if (allowed < 1)
+                allowed = 1;
+            if (held > allowed)
+                summary_.repeated_frames += held - allowed;
+            entry.vblanks = held;
+            summary_.held_histogram[held < 1 ? 1 : (held > 5 ? 5 : held)]++;
+        }
+        last_frame_ = end;
+        has_frame_ = true;
+    }
+    if (records_.size() < max_records_)
+        records_.push_back(entry);
+
+    last_swap_ = end;
+    has_swap_ = true;
+}
+
+PacingSummary FramePacing::summary() const
+{
+    PacingSummary result = summary_;
+    result.refresh_period_us = period_us_;
+    result.content_period_us = content_period_us_;
+    result.swap_avg_us = summary_.swaps ? swap_total_us_ / summary_.swaps : 0.0;
+    return result;
+}
+
+bool FramePacing::write_csv(const std::string &path) const
+{
+    std::ofstream file(path);
+    if (!file)
+        return false;
+    file << "start_us,end_us,new_frame,vblanks\n";
+    for (const SwapRecord &entry : records_)
+        file << entry.start_us << ',' << entry.end_us << ',' << (entry.new_frame ? 1 : 0) << ',' << entry.vblanks << '\n';
+    return (bool)file;
+}
+
+const char *swap_interval_name(SwapInterval interval)
+{
+    switch (interval)
+    {
+    case SwapInterval::Immediate:
+        return "0 (no vsync)";
+    case SwapInterval::Vsync:
+        return "1 (vsync)";
+    case SwapInterval::Adaptive:
+        return "adaptive";
+    }
+    return "unknown";
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 交换间隔：0 不等待 vblank，1 垂直同步，Adaptive 在错过 vblank 时立即交换（需要 *_swap_control_tear）
+enum class SwapInterval
+{
+    Immediate = 0,
+    Vsync = 1,
+    Adaptive = -1
+};
+
+// 一次 glfwSwapBuffers 的记录（时间相对于第一次交换开始）
+struct SwapRecord
+{
+    double start_us = 0.0;
+    double end_us = 0.0;
+    bool new_frame = false; // false 表示暴露/尺寸变化的重绘
+    int vblanks = 0;        // 上一个新帧在屏幕上停留的 vblank 数（仅新帧）
+};
+
+// 帧节奏汇总
+struct PacingSummary
+{
+    uint64_t swaps = 0;
+    uint64_t new_frames = 0;
+    double refresh_period_us = 0.0; // 由交换间隔测得（交换间隔为 0 时为标称值）
+    double content_period_us = 0.0; // 来自 caps 的帧率，0 表示未知
+    double swap_avg_us = 0.0;       // glfwSwapBuffers 平均阻塞时间
+    double swap_max_us = 0.0;
+    uint64_t missed_vblanks = 0;    // 交换阻塞超过一个周期，错过了目标 vblank
+    uint64_t repeated_frames = 0;   // 超出内容节奏、多显示了一次旧帧的 vblank 数
+    uint64_t held_histogram[6] = {}; // 新帧停留 1..5 个 vblank 的次数，[5] 为 5 个以上，[0] 未使用
+};
+
+// 记录每次交换的开始/结束时间，估计刷新周期，统计错过的 vblank 和重复帧。
+// 只在渲染线程上调用
+class FramePacing
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit FramePacing(size_t max_records = 1 << 18);
+
+    void reset(double nominal_period_us, int swap_interval);
+    // 内容帧周期（1e6 * fps_d / fps_n），用于判断重复帧；0 表示未知，按每帧一个 vblank 计算
+    void set_content_period_us(double period_us) { content_period_us_ = period_us; }
+    void record(Clock::time_point start, Clock::time_point end, bool new_frame);
+
+    PacingSummary summary() const;
+    const std::vector<SwapRecord> &records() const { return records_; }
+    // 每次交换一行：start_us,end_us,new_frame,vblanks
+    bool write_csv(const std::string &path) const;
+
+private:
+    size_t max_records_;
+    int swap_interval_;
+    double period_us_;
+    double content_period_us_;
+    bool has_swap_;
+    Clock::time_point origin_;
+    Clock::time_point last_swap_;
+    Clock::time_point last_frame_;
+    bool has_frame_;
+    std::vector<SwapRecord> records_; // 超过 max_records_ 后不再记录，汇总仍然累计
+    PacingSummary summary_;
+    double swap_total_us_;
+};
+
+// 交换间隔的可读名称
+const char *swap_interval_name(SwapInterval interval);
@@ -0,0 +1,83 @@
+#include "FrameScheduler.hpp"
+
+#include <cmath>
+
+// 连续丢帧的上限，避免在持续过载时一帧都不显示
+#define MAX_CONSECUTIVE_DROPS 4
+
+FrameScheduler::FrameScheduler(double nominal_period_us, double late_drop_us)
+{
+    reset(nominal_period_us, late_drop_us);
+}
+
+void FrameScheduler::reset(double nominal_period_us, double late_drop_us)
+{
+    period_us_ = nominal_period_us > 0.0 ? nominal_period_us : 1e6 / 60.0;
+    late_drop_us_ = late_drop_us;
+    has_swap_ = false;
+    consecutive_drops_ = 0;
+    stats_ = ScheduleStats();
+}
+
+void FrameScheduler::on_swap_complete(Clock::time_point when)
+{
+    if (has_swap_)
+    {
+        // 两次交换之间可能隔了多个 vblank，按最接近的整数倍折算成单个周期
+        double interval_us = std::chrono::duration<double, std::micro>(when - last_swap_).count();
+        double vblanks = std::round(interval_us / period_us_);
+        if (vblanks >= 1.0 && vblanks <= 8.0)
+        {
+            double measured = interval_us / vblanks;
+            // 偏差太大的间隔（窗口拖动、合成器卡顿）不参与估计
+            if (std::fabs(measured - period_us_) < period_us_ * 0.25)
+                period_us_ += (measured - period_us_) * 0.05;
+        }
+    }
+    last_swap_ = when;
+    has_swap_ = true;
+}
+
+FrameScheduler::Clock::time_point FrameScheduler::next_vblank(Clock::time_point now) const
+{
+    if (!has_swap_)
+        return now;
+
+    // 紧接在交换之后调用时，下一次 vblank 是再过一个周期
+    double elapsed_us = std::chrono::duration<double, std::micro>(now - last_swap_).count();
+    double vblanks = elapsed_us > 0.0 ? std::floor(elapsed_us / period_us_) + 1.0 : 1.0;
+    return last_swap_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(vblanks * period_us_));
+}
+
+FrameScheduler::Decision FrameScheduler::decide(Clock::time_point due, Clock::time_point now)
+{
+    Clock::time_point vblank = next_vblank(now);
+    // 正值表示在下一次 vblank 显示时已经迟到
+    double lateness_us = std::chrono::duration<double, std::micro>(vblank - due).count();
+
+    if (late_drop_us_ >= 0.0 && lateness_us > late_drop_us_ && consecutive_drops_ < MAX_CONSECUTIVE_DROPS)
+    {
+        consecutive_drops_++;
+        stats_.dropped_late++;
+        return Decision::Drop;
+    }
+    // 到期时间离之后的 vblank 更近
+    if (-lateness_us > period_us_ * 0.5)
+    {
+        stats_.waited++;
+        return Decision::Wait;
+    }
+
+    consecutive_drops_ = 0;
+    return Decision::Present;
+}
+
+void FrameScheduler::record_present(Clock::time_point intended, Clock::time_point actual)
+{
+    double deviation_us = std::chrono::duration<double, std::micro>(actual - intended).count();
+    stats_.presented++;
+    stats_.judder_sum_us += deviation_us;
+    stats_.judder_sq_sum_us += deviation_us * deviation_us;
+    if (std::fabs(deviation_us) > stats_.judder_max_us)
+        stats_.judder_max_us = std::fabs(deviation_us);
+}
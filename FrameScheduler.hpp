@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// 呈现调度统计
+struct ScheduleStats
+{
+    uint64_t presented = 0;       // 按计划呈现的帧
+    uint64_t waited = 0;          // 因未到期而推迟到后续 vblank 的次数
+    uint64_t dropped_late = 0;    // 超过迟到阈值被丢弃的帧
+    double judder_sum_us = 0.0;   // 实际显示时间 - 期望显示时间（有符号）之和
+    double judder_sq_sum_us = 0.0;
+    double judder_max_us = 0.0;   // 最大绝对偏差
+};
+
+// 渲染端的呈现调度器：根据测得的交换间隔预测下一次 vblank，
+// 把每帧安排在离它的到期时间最近的 vblank 上，迟到过多的帧按策略丢弃。
+// 所有调用都在渲染线程上。
+class FrameScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Decision
+    {
+        Present, // 下一次 vblank 最接近到期时间，现在提交
+        Wait,    // 更晚的 vblank 更接近，等待
+        Drop     // 迟到超过阈值，丢弃
+    };
+
+    // nominal_period_us：显示器标称刷新周期；late_drop_us < 0 表示从不丢帧
+    explicit FrameScheduler(double nominal_period_us = 1e6 / 60.0, double late_drop_us = -1.0);
+
+    void reset(double nominal_period_us, double late_drop_us);
+
+    // 每次交换完成后调用（包括重复帧），用来估计刷新周期与 vblank 相位
+    void on_swap_complete(Clock::time_point when);
+    // now 之后的下一次 vblank 预测
+    Clock::time_point next_vblank(Clock::time_point now) const;
+    // 对到期时间为 due 的帧做出决定
+    Decision decide(Clock::time_point due, Clock::time_point now);
+    // 记录一帧的期望显示时间与实际显示时间（交换完成）
+    void record_present(Clock::time_point intended, Clock::time_point actual);
+
+    double refresh_period_us() const { return period_us_; }
+    const ScheduleStats &stats() const { return stats_; }
+
+private:
+    double period_us_;
+    double late_drop_us_;
+    bool has_swap_;
+    Clock::time_point last_swap_;
+    int consecutive_drops_;
+    ScheduleStats stats_;
+};
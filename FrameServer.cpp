@@ -0,0 +1,278 @@
+#include "FrameServer.hpp"
+#include "PipelineBuilder.hpp"
+#include "StreamSync.hpp"
+#include "VideoFormat.hpp"
+
+#include <cstring>
+#include <iostream>
+
+FrameServer::FrameServer()
+    : pipeline_(nullptr), appsink_(nullptr), bus_(nullptr), loop_(nullptr), accept_source_(0),
+      caps_(nullptr), frames_written_(0), frames_rejected_(0), ring_rebuilds_(0)
+{
+    gst_video_info_init(&info_);
+}
+
+FrameServer::~FrameServer()
+{
+    stop();
+}
+
+bool FrameServer::initialize(const std::string &source, const FrameServerOptions &options)
+{
+    options_ = options;
+    if (options_.slots < 3 || options_.slots > SHARED_RING_MAX_SLOTS)
+    {
+        std::cerr << "Frame server needs 3.." << SHARED_RING_MAX_SLOTS << " slots" << std::endl;
+        return false;
+    }
+
+    gst_init(nullptr, nullptr);
+    if (!create_pipeline(source))
+        return false;
+    // 环在第一帧到达、知道帧大小之后才创建，监听先开始
+    if (!ring_.listen(options_.path))
+        return false;
+    std::cout << "Serving frames on " << options_.path << std::endl;
+    return true;
+}
+
+bool FrameServer::create_pipeline(const std::string &source)
+{
+    // 源地址只作为属性值，不拼进 gst_parse_launch 字符串；源有多个动态 pad 时只接视频
+    PipelineBuilder builder("frame-server");
+    if (source.empty() || source == "test" || source.compare(0, 5, "test:") == 0)
+    {
+        std::string pattern = source.size() > 5 ? source.substr(5) : "smpte";
+        builder.add(ElementSpec{"videotestsrc", "", {{"is-live", "true"}, {"pattern", pattern}}});
+        builder.add_caps("video/x-raw,width=1280,height=720");
+    }
+    else if (source.find("rtsp://") == 0)
+    {
+        builder.branch(builder.add(ElementSpec{"rtspsrc", "", {{"location", source}, {"latency", "0"}}}), "video/");
+        builder.add("decodebin");
+    }
+    else
+    {
+        // 本地文件转换成 URI，其余交给 uridecodebin 自动选择
+        std::string uri = source;
+        if (source.find("://") == std::string::npos)
+        {
+            gchar *file_uri = gst_filename_to_uri(source.c_str(), nullptr);
+            if (file_uri)
+            {
+                uri = file_uri;
+                g_free(file_uri);
+            }
+        }
+        builder.branch(builder.add(ElementSpec{"uridecodebin", "", {{"uri", uri}}}), "video/");
+    }
+    builder.add("queue");
+    builder.add("videoconvert");
+    builder.add("appsink", "sink");
+    std::cout << "Frame server pipeline: " << builder.description() << std::endl;
+
+    PipelineTiming timing;
+    pipeline_ = builder.finish(timing);
+    if (!pipeline_)
+    {
+        std::cerr << "Failed to create pipeline: " << builder.error() << std::endl;
+        return false;
+    }
+
+    appsink_ = gst_bin_get_by_name(GST_BIN(pipeline_), "sink");
+    if (!appsink_)
+    {
+        std::cerr << "Failed to get appsink element" << std::endl;
+        return false;
+    }
+    // 格式与渲染端直接解码时一致；按时钟同步，读端只需取最新帧
+    GstCaps *sink_caps = gst_caps_from_string(appsink_video_caps(options_.native_yuv, GL_RGBA));
+    gst_app_sink_set_caps(GST_APP_SINK(appsink_), sink_caps);
+    gst_caps_unref(sink_caps);
+    g_object_set(appsink_, "emit-signals", FALSE, "sync", TRUE, "max-buffers", 1, "drop", TRUE, nullptr);
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = appsink_new_sample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(appsink_), &callbacks, this, nullptr);
+
+    bus_ = gst_element_get_bus(pipeline_);
+    gst_bus_add_watch(bus_, bus_callback, this);
+    return true;
+}
+
+GstFlowReturn FrameServer::appsink_new_sample(GstAppSink *sink, gpointer data)
+{
+    FrameServer *server = static_cast<FrameServer *>(data);
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (!sample)
+        return GST_FLOW_ERROR;
+    server->write_sample(sample);
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+// 把一帧写进环：各平面按原始步长依次存放，这是像素在本机内存中唯一的一次拷贝
+void FrameServer::write_sample(GstSample *sample)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+    if (!buffer || !caps)
+    {
+        frames_rejected_++;
+        return;
+    }
+    // caps 只在重新协商时变化，字符串随帧发布给读端
+    if (caps != caps_)
+    {
+        gchar *caps_string = gst_caps_to_string(caps);
+        bool fits = strlen(caps_string) < SHARED_RING_CAPS_SIZE;
+        if (fits && gst_video_info_from_caps(&info_, caps))
+        {
+            gst_caps_replace(&caps_, caps);
+            caps_string_ = caps_string;
+        }
+        else
+        {
+            std::cerr << "Frame server cannot publish caps " << caps_string << std::endl;
+            gst_caps_replace(&caps_, nullptr);
+        }
+        g_free(caps_string);
+        if (!caps_)
+        {
+            frames_rejected_++;
+            return;
+        }
+    }
+
+    GstVideoFrame vframe;
+    if (!gst_video_frame_map(&vframe, &info_, buffer, GST_MAP_READ))
+    {
+        frames_rejected_++;
+        return;
+    }
+    SharedFrameInfo info;
+    info.n_planes = GST_VIDEO_FRAME_N_PLANES(&vframe);
+    size_t total = 0;
+    for (guint i = 0; i < info.n_planes; ++i)
+    {
+        // 支持的格式中平面 i 的首个分量就是分量 i
+        info.stride[i] = GST_VIDEO_FRAME_PLANE_STRIDE(&vframe, i);
+        info.offset[i] = total;
+        total += (size_t)info.stride[i] * GST_VIDEO_FRAME_COMP_HEIGHT(&vframe, i);
+    }
+    info.size = (uint32_t)total;
+    info.pts = (int64_t)sample_running_time(sample);
+
+    std::lock_guard<std::mutex> lock(ring_mutex_);
+    if (!ring_.header() || total > ring_.slot_size())
+    {
+        // 帧变大后重建环：已连接的读端断开，重连后拿到新的 memfd
+        ring_.disconnect_readers();
+        if (!ring_.create(total, options_.slots))
+        {
+            gst_video_frame_unmap(&vframe);
+            frames_rejected_++;
+            return;
+        }
+        ring_rebuilds_++;
+        std::cout << "Frame ring: " << ring_.slot_count() << " slots of " << ring_.slot_size() << " bytes" << std::endl;
+    }
+
+    // 读者持有所有槽位时最多等待 write_timeout_ms，超时由环计为丢弃
+    uint8_t *slot = ring_.begin_write(total, options_.write_timeout_ms);
+    if (slot)
+    {
+        for (guint i = 0; i < info.n_planes; ++i)
+            memcpy(slot + info.offset[i], GST_VIDEO_FRAME_PLANE_DATA(&vframe, i),
+                   (size_t)info.stride[i] * GST_VIDEO_FRAME_COMP_HEIGHT(&vframe, i));
+        ring_.commit_write(info, caps_string_.c_str());
+        frames_written_++;
+    }
+    gst_video_frame_unmap(&vframe);
+}
+
+gboolean FrameServer::accept_timeout(gpointer data)
+{
+    FrameServer *server = static_cast<FrameServer *>(data);
+    std::lock_guard<std::mutex> lock(server->ring_mutex_);
+    server->ring_.accept_readers();
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean FrameServer::bus_callback(GstBus *bus, GstMessage *msg, gpointer data)
+{
+    FrameServer *server = static_cast<FrameServer *>(data);
+    switch (GST_MESSAGE_TYPE(msg))
+    {
+    case GST_MESSAGE_EOS:
+        std::cout << "Frame server reached end of stream" << std::endl;
+        g_main_loop_quit(server->loop_);
+        break;
+    case GST_MESSAGE_ERROR:
+    {
+        GError *error = nullptr;
+        gchar *debug = nullptr;
+        gst_message_parse_error(msg, &error, &debug);
+        std::cerr << "Frame server error: " << error->message << std::endl;
+        g_error_free(error);
+        g_free(debug);
+        g_main_loop_quit(server->loop_);
+        break;
+    }
+    default:
+        break;
+    }
+    return TRUE;
+}
+
+void FrameServer::run()
+{
+    if (!pipeline_)
+        return;
+    loop_ = g_main_loop_new(nullptr, FALSE);
+    // 新读端随时可能连接，每 100ms 把 memfd 交给它们
+    accept_source_ = g_timeout_add(100, accept_timeout, this);
+    gst_element_set_state(pipeline_, GST_STATE_PLAYING);
+    g_main_loop_run(loop_);
+    gst_element_set_state(pipeline_, GST_STATE_NULL);
+    g_source_remove(accept_source_);
+    accept_source_ = 0;
+    g_main_loop_unref(loop_);
+    loop_ = nullptr;
+    print_stats();
+}
+
+void FrameServer::print_stats()
+{
+    std::cout << "=== Frame server ===" << std::endl;
+    std::cout << "Frames written:      " << frames_written_ << " (" << frames_rejected_ << " rejected, "
+              << ring_rebuilds_ << " ring builds)" << std::endl;
+    if (const SharedRingHeader *header = ring_.header())
+        std::cout << "Ring:                " << header->published.load() << " published, " << header->dropped.load()
+                  << " dropped by back-pressure, " << header->reclaimed.load() << " slots reclaimed" << std::endl;
+}
+
+void FrameServer::stop()
+{
+    if (pipeline_)
+        gst_element_set_state(pipeline_, GST_STATE_NULL);
+    if (bus_)
+    {
+        gst_bus_remove_watch(bus_);
+        gst_object_unref(bus_);
+        bus_ = nullptr;
+    }
+    if (appsink_)
+    {
+        gst_object_unref(appsink_);
+        appsink_ = nullptr;
+    }
+    if (pipeline_)
+    {
+        gst_object_unref(pipeline_);
+        pipeline_ = nullptr;
+    }
+    gst_caps_replace(&caps_, nullptr);
+    std::lock_guard<std::mutex> lock(ring_mutex_);
+    ring_.close();
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "gst/gst.h"
+#include "gst/video/video.h"
+#include "gst/app/gstappsink.h"
+
+#include "SharedFrameRing.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 帧服务选项
+struct FrameServerOptions
+{
+    std::string path;        // 读端连接的 Unix 域套接字路径
+    int slots = 4;           // 环中的槽位数（最新帧 + 读者持有的帧 + 正在写的帧）
+    bool native_yuv = true;  // 与渲染端相同：透传 NV12/I420/YUY2，颜色转换留给读端的着色器
+    int write_timeout_ms = 40; // 所有槽位都被读者持有时写端最多等待的时间，超时丢弃这一帧
+};
+
+// 解码一次、多进程渲染：本进程解码视频源，每帧写进共享内存帧环一次，
+// 任意个渲染进程（GstOpenGLPlayer 的 "shm:PATH" 源）映射同一块内存直接上传纹理，不再各自解码。
+// 帧按解码输出的平面和步长原样存放，caps 随帧发布
+class FrameServer
+{
+public:
+    FrameServer();
+    ~FrameServer();
+
+    FrameServer(const FrameServer &) = delete;
+    FrameServer &operator=(const FrameServer &) = delete;
+
+    bool initialize(const std::string &source, const FrameServerOptions &options);
+    // 播放到结束或出错
+    void run();
+    void stop();
+
+private:
+    bool create_pipeline(const std::string &source);
+    static GstFlowReturn appsink_new_sample(GstAppSink *sink, gpointer data);
+    static gboolean bus_callback(GstBus *bus, GstMessage *msg, gpointer data);
+    static gboolean accept_timeout(gpointer data);
+    void write_sample(GstSample *sample);
+    void print_stats();
+
+    FrameServerOptions options_;
+    GstElement *pipeline_;
+    GstElement *appsink_;
+    GstBus *bus_;
+    GMainLoop *loop_;
+    guint accept_source_;
+
+    // 流线程写帧、主循环接受读端连接，两者都要访问环
+    std::mutex ring_mutex_;
+    SharedFrameRing ring_;
+
+    // 只在流线程上使用：最近一次的 caps 及其解析结果
+    GstCaps *caps_;
+    GstVideoInfo info_;
+    std::string caps_string_;
+
+    uint64_t frames_written_;
+    uint64_t frames_rejected_;
+    uint64_t ring_rebuilds_;
+};
@@ -0,0 +1,149 @@
+#include "GLContextBridge.hpp"
+
+#include <iostream>
+
+#if GST_GL_HAVE_PLATFORM_EGL
+#include "gst/gl/egl/gstgldisplay_egl.h"
+// 只需要 glfwGetEGLDisplay，不引入 EGL 头文件
+#define GLFW_EXPOSE_NATIVE_EGL
+#define GLFW_NATIVE_INCLUDE_NONE
+typedef void *EGLDisplay;
+typedef void *EGLContext;
+typedef void *EGLSurface;
+#include "GLFW/glfw3native.h"
+#endif
+
+#define GST_GL_APP_CONTEXT_TYPE "gst.gl.app_context"
+
+GLContextBridge::GLContextBridge()
+    : display_(nullptr), context_(nullptr)
+{
+}
+
+GLContextBridge::~GLContextBridge()
+{
+    destroy();
+}
+
+bool GLContextBridge::wrap_current(GLFWwindow *window)
+{
+    destroy();
+
+    // 按 GLFW 实际使用的上下文 API 选择平台，display 必须与上下文属于同一个原生连接
+    GstGLPlatform platform = GST_GL_PLATFORM_NONE;
+    if (glfwGetWindowAttrib(window, GLFW_CONTEXT_CREATION_API) == GLFW_EGL_CONTEXT_API)
+    {
+#if GST_GL_HAVE_PLATFORM_EGL
+        platform = GST_GL_PLATFORM_EGL;
+        display_ = GST_GL_DISPLAY(gst_gl_display_egl_new_with_egl_display((gpointer)glfwGetEGLDisplay()));
+#endif
+    }
+    else
+    {
+#if defined(_WIN32)
+        platform = GST_GL_PLATFORM_WGL;
+#elif defined(__APPLE__)
+        platform = GST_GL_PLATFORM_CGL;
+#else
+        platform = GST_GL_PLATFORM_GLX;
+#endif
+        display_ = gst_gl_display_new();
+    }
+    return wrap_current_platform(platform);
+}
+
+bool GLContextBridge::wrap_current_egl(void *egl_display)
+{
+    destroy();
+#if GST_GL_HAVE_PLATFORM_EGL
+    display_ = GST_GL_DISPLAY(gst_gl_display_egl_new_with_egl_display((gpointer)egl_display));
+    return wrap_current_platform(GST_GL_PLATFORM_EGL);
+#else
+    (void)egl_display;
+    std::cerr << "GStreamer GL was built without EGL" << std::endl;
+    return false;
+#endif
+}
+
+// display_ 已经创建，包装本线程上 platform 的当前上下文
+bool GLContextBridge::wrap_current_platform(GstGLPlatform platform)
+{
+    if (!display_)
+    {
+        std::cerr << "No GstGLDisplay for the current GL platform" << std::endl;
+        return false;
+    }
+
+    guintptr handle = gst_gl_context_get_current_gl_context(platform);
+    GstGLAPI api = gst_gl_context_get_current_gl_api(platform, nullptr, nullptr);
+    if (!handle || api == GST_GL_API_NONE)
+    {
+        std::cerr << "No current GL context to wrap" << std::endl;
+        destroy();
+        return false;
+    }
+
+    context_ = gst_gl_context_new_wrapped(display_, handle, platform, api);
+    if (!context_)
+    {
+        std::cerr << "Failed to wrap GL context" << std::endl;
+        destroy();
+        return false;
+    }
+
+    // 包装的上下文需要在本线程激活并查询一次版本信息
+    GError *error = nullptr;
+    gst_gl_context_activate(context_, TRUE);
+    if (!gst_gl_context_fill_info(context_, &error))
+    {
+        std::cerr << "Failed to query wrapped GL context: " << (error ? error->message : "unknown") << std::endl;
+        g_clear_error(&error);
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+void GLContextBridge::destroy()
+{
+    if (context_)
+    {
+        gst_gl_context_activate(context_, FALSE);
+        gst_object_unref(context_);
+        context_ = nullptr;
+    }
+    if (display_)
+    {
+        gst_object_unref(display_);
+        display_ = nullptr;
+    }
+}
+
+bool GLContextBridge::handle_need_context(GstMessage *msg)
+{
+    const gchar *context_type = nullptr;
+    if (!context_ || !gst_message_parse_context_type(msg, &context_type))
+        return false;
+
+    GstContext *context = nullptr;
+    if (g_strcmp0(context_type, GST_GL_DISPLAY_CONTEXT_TYPE) == 0)
+    {
+        context = gst_context_new(GST_GL_DISPLAY_CONTEXT_TYPE, TRUE);
+        gst_context_set_gl_display(context, display_);
+    }
+    else if (g_strcmp0(context_type, GST_GL_APP_CONTEXT_TYPE) == 0)
+    {
+        // GL 元素创建的上下文会与这个上下文共享纹理
+        context = gst_context_new(GST_GL_APP_CONTEXT_TYPE, TRUE);
+        GstStructure *structure = gst_context_writable_structure(context);
+        gst_structure_set(structure, "context", GST_TYPE_GL_CONTEXT, context_, nullptr);
+    }
+    else
+    {
+        return false;
+    }
+
+    gst_element_set_context(GST_ELEMENT(GST_MESSAGE_SRC(msg)), context);
+    gst_context_unref(context);
+    return true;
+}
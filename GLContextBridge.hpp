@@ -0,0 +1,35 @@
+#pragma once
+#include "gst/gst.h"
+#include "gst/gl/gl.h"
+
+#include "GLFW/glfw3.h"
+
+// 把播放器的 GLFW 上下文包装成 GstGLContext，并通过 need-context 交给管道中的 GL 元素。
+// 上游元素创建的上下文与它共享对象，GstGLMemory 中的纹理可以直接在渲染线程绑定。
+class GLContextBridge
+{
+public:
+    GLContextBridge();
+    ~GLContextBridge();
+
+    GLContextBridge(const GLContextBridge &) = delete;
+    GLContextBridge &operator=(const GLContextBridge &) = delete;
+
+    // 在 window 的上下文为当前上下文的线程上调用（需要先 gst_init）
+    bool wrap_current(GLFWwindow *window);
+    // 无窗口模式：当前上下文是在 egl_display 上直接创建的 EGL 上下文
+    bool wrap_current_egl(void *egl_display);
+    void destroy();
+
+    // 在总线同步回调中调用：应答 GL display / app context 请求，返回 true 表示已处理
+    bool handle_need_context(GstMessage *msg);
+
+    GstGLContext *context() const { return context_; }
+    GstGLDisplay *display() const { return display_; }
+
+private:
+    bool wrap_current_platform(GstGLPlatform platform);
+
+    GstGLDisplay *display_;
+    GstGLContext *context_;
+};
@@ -1,21 +1,34 @@
 #include "GstOpenGLPlayer.hpp"
+#include "gl_utils.hpp"
+#include "CpuUsage.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 
-extern GLuint create_shader_program();
 extern const unsigned int *get_screen_quad_indices();
 extern const float *get_screen_quad_vertices();
 GstOpenGLPlayer::GstOpenGLPlayer(int width, int height)
     : window_width_(width), window_height_(height),
-      window_(nullptr), vao_(0), vbo_(0), ebo_(0),
-      shader_program_(0), texture_id_(0),
-      texture_width_(0), texture_height_(0),
-      pipeline_(nullptr), appsink_(nullptr), bus_(nullptr),
-      is_running_(false), has_new_frame_(false)
+      window_(nullptr), fbo_(0), fbo_texture_(0), framebuffer_width_(width), framebuffer_height_(height), vao_(0), vbo_(0), ebo_(0),
+      shader_programs_(), plane_textures_(),
+      texture_generation_(0), texture_width_(0), texture_height_(0), upload_format_(GL_RGBA),
+      has_negotiated_info_(false),
+      gl_sample_(nullptr), gl_texture_(0),
+      persistent_buffer_(0), persistent_region_(nullptr),
+      pipeline_(nullptr), appsink_(nullptr), bus_(nullptr), ring_caps_(nullptr), duration_ns(0), textoverlay(nullptr),
+      run_cpu_seconds_(0.0), run_wall_seconds_(0.0),
+      redraw_pending_(true), render_cpu_seconds_(0.0), applied_swap_interval_(1),
+      scheduled_sample_(nullptr), has_scheduled_due_(false),
+      upload_window_(nullptr), upload_running_(false), upload_seconds_(0.0), upload_cpu_seconds_(0.0),
+      source_generation_(0), presented_generation_(0), switch_pending_(false), switch_warm_(false), switch_prerolled_(false), frames_since_switch_(0),
+      is_running_(false)
 {
 }
 
 GstOpenGLPlayer::~GstOpenGLPlayer()
 {
-    stop();
+    shutdown();
 }
 void GstOpenGLPlayer::createTestImage()
 {
@@ -44,7 +57,7 @@ void GstOpenGLPlayer::createTestImage()
         }
     }
 }
-bool GstOpenGLPlayer::create_window()
+bool GstOpenGLPlayer::create_window(bool visible)
 {
     // 初始化 GLFW
     if (!glfwInit())
@@ -52,23 +65,41 @@ bool GstOpenGLPlayer::create_window()
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return false;
     }
+    // 窗口提示必须在 glfwInit 之后设置，之前的设置会被忽略
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
     // 设置OpenGL版本和配置
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);                 // OpenGL主版本3
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);                 // OpenGL次版本3
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); // 核心模式
+#if !defined(_WIN32) && !defined(__APPLE__)
+    // GstGLMemory 模式使用 EGL 上下文，便于与 GStreamer 的 GL 元素共享（也可运行在 Mesa 软件 EGL 上）
+    if (options_.upload == TextureUpload::GLMemory)
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
     // 创建窗口
     window_ = glfwCreateWindow(window_width_, window_height_, "GStreamer + OpenGL Video Player", nullptr, nullptr);
-    glfwSwapInterval(1); // 启用垂直同步
     if (!window_)
     {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
         return false;
     }
+    if (options_.upload_thread)
+    {
+        // 上传线程的共享上下文：不可见的 1x1 窗口，与主窗口共享纹理、缓冲和同步对象
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        upload_window_ = glfwCreateWindow(1, 1, "upload", nullptr, window_);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (!upload_window_)
+        {
+            std::cerr << "Failed to create shared upload context, uploading on the render thread" << std::endl;
+            options_.upload_thread = false;
+        }
+    }
 
     glfwMakeContextCurrent(window_); // 设置为当前上下文
-    glfwSwapInterval(1);             // 启用垂直同步
+    apply_swap_interval();
 
     // 初始化 GLAD
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) // 初始化GLAD（加载OpenGL函数指针)
@@ -76,19 +107,180 @@ bool GstOpenGLPlayer::create_window()
         std::cerr << "Failed to initialize GLAD" << std::endl;
         return false;
     }
-    glViewport(0, 0, window_width_, window_height_);
+    load_gl_extensions((GLADloadproc)glfwGetProcAddress);
+    // 高 DPI 下帧缓冲像素与窗口坐标不同
+    glfwGetFramebufferSize(window_, &framebuffer_width_, &framebuffer_height_);
+    glViewport(0, 0, framebuffer_width_, framebuffer_height_);
+
+    // 暴露和尺寸变化只标记重绘，由渲染循环统一处理
+    glfwSetWindowUserPointer(window_, this);
+    glfwSetFramebufferSizeCallback(window_, framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window_, window_refresh_callback);
+    glfwSetKeyCallback(window_, key_callback);
     return true;
 }
 
-bool GstOpenGLPlayer::init_opengl()
+// 无窗口模式：创建 EGL 离屏上下文，没有 EGL 时退回不可见的 GLFW 窗口
+bool GstOpenGLPlayer::create_offscreen()
+{
+    if (!offscreen_.create())
+    {
+        std::cout << "EGL offscreen context unavailable, using a hidden window" << std::endl;
+        if (!create_window(false))
+            return false;
+        glfwSwapInterval(0);
+        applied_swap_interval_ = 0;
+        return true;
+    }
+
+    offscreen_.make_current();
+    if (!gladLoadGLLoader((GLADloadproc)OffscreenContext::get_proc_address))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    load_gl_extensions((GLADloadproc)OffscreenContext::get_proc_address);
+    applied_swap_interval_ = 0;
+    std::cout << "Headless rendering: " << offscreen_.kind() << ", " << glGetString(GL_RENDERER) << std::endl;
+
+    if (options_.upload_thread && !upload_offscreen_.create(&offscreen_))
+    {
+        std::cerr << "Failed to create shared upload context, uploading on the render thread" << std::endl;
+        options_.upload_thread = false;
+    }
+    return true;
+}
+
+// 无窗口模式的绘制目标：窗口大小的 RGBA8 颜色附件，创建后一直保持绑定
+bool GstOpenGLPlayer::create_render_target()
 {
-    // 创建着色器程序
-    shader_program_ = create_shader_program();
+    glGenTextures(1, &fbo_texture_);
+    glBindTexture(GL_TEXTURE_2D, fbo_texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, window_width_, window_height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    if (!shader_program_)
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fbo_texture_, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
     {
-        std::cerr << "Failed to create program" << std::endl;
+        std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+        return false;
+    }
+    framebuffer_width_ = window_width_;
+    framebuffer_height_ = window_height_;
+    glViewport(0, 0, window_width_, window_height_);
+    return true;
+}
+
+// 把 FBO 当前内容写成二进制 PPM（自上而下）
+bool GstOpenGLPlayer::write_snapshot(const std::string &path)
+{
+    if (!fbo_)
         return false;
+    std::vector<uint8_t> pixels((size_t)window_width_ * window_height_ * 3);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, window_width_, window_height_, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    fprintf(file, "P6\n%d %d\n255\n", window_width_, window_height_);
+    size_t row_bytes = (size_t)window_width_ * 3;
+    for (int y = window_height_ - 1; y >= 0; --y)
+        fwrite(pixels.data() + (size_t)y * row_bytes, 1, row_bytes, file);
+    return fclose(file) == 0;
+}
+
+bool GstOpenGLPlayer::render_should_close()
+{
+    if (options_.headless && options_.headless_frames > 0 &&
+        pacing_.summary().new_frames >= (uint64_t)options_.headless_frames)
+        return true;
+    return window_ && glfwWindowShouldClose(window_);
+}
+
+void GstOpenGLPlayer::poll_events()
+{
+    if (window_)
+        glfwPollEvents();
+}
+
+// 阻塞到新帧到达或超时；有窗口时同时处理窗口事件
+void GstOpenGLPlayer::wait_events(double timeout_seconds)
+{
+    if (window_)
+    {
+        glfwWaitEventsTimeout(timeout_seconds);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_cv_.wait_for(lock, std::chrono::duration<double>(timeout_seconds),
+                      [this]
+                      { return mailbox_.has_new() || uploaded_.has_new() || !is_running_; });
+}
+
+// 由 appsink 线程或上传线程调用，唤醒阻塞在 wait_events 中的渲染线程
+void GstOpenGLPlayer::wake_render_loop()
+{
+    if (window_)
+    {
+        glfwPostEmptyEvent();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_one();
+}
+
+void GstOpenGLPlayer::framebuffer_size_callback(GLFWwindow *window, int width, int height)
+{
+    GstOpenGLPlayer *player = static_cast<GstOpenGLPlayer *>(glfwGetWindowUserPointer(window));
+    // 视口在每帧绘制时按黑边重新计算，视频纹理和中间纹理都不重新分配；无窗口模式的 FBO 尺寸固定
+    if (!player->options_.headless)
+    {
+        player->framebuffer_width_ = width;
+        player->framebuffer_height_ = height;
+    }
+    player->redraw_pending_ = true;
+}
+
+void GstOpenGLPlayer::window_refresh_callback(GLFWwindow *window)
+{
+    GstOpenGLPlayer *player = static_cast<GstOpenGLPlayer *>(glfwGetWindowUserPointer(window));
+    player->redraw_pending_ = true;
+}
+
+// 切换源：N/→ 下一个，P/← 上一个，1~9 直接选择
+void GstOpenGLPlayer::key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+    GstOpenGLPlayer *player = static_cast<GstOpenGLPlayer *>(glfwGetWindowUserPointer(window));
+    if (action != GLFW_PRESS || player->sources_.size() < 2)
+        return;
+    if (key == GLFW_KEY_N || key == GLFW_KEY_RIGHT)
+        player->switch_source(player->adjacent_source(1));
+    else if (key == GLFW_KEY_P || key == GLFW_KEY_LEFT)
+        player->switch_source(player->adjacent_source(-1));
+    else if (key >= GLFW_KEY_1 && key <= GLFW_KEY_9 && (size_t)(key - GLFW_KEY_1) < player->sources_.size())
+        player->switch_source(player->sources_[key - GLFW_KEY_1]);
+}
+
+bool GstOpenGLPlayer::init_opengl()
+{
+    // 创建各像素格式的着色器程序
+    for (int i = 0; i < (int)VideoShader::Count; ++i)
+    {
+        shader_programs_[i] = create_video_shader_program((VideoShader)i);
+        if (!shader_programs_[i])
+        {
+            std::cerr << "Failed to create program" << std::endl;
+            return false;
+        }
     }
 
     // 创建 VAO, VBO, EBO
@@ -117,34 +309,110 @@ bool GstOpenGLPlayer::init_opengl()
 
     glBindVertexArray(0);
 
-    // 创建纹理
-    glGenTextures(1, &texture_id_);
-    glBindTexture(GL_TEXTURE_2D, texture_id_);
-
-    // 设置纹理参数
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // 无窗口模式的绘制目标
+    if (options_.headless && !create_render_target())
+        return false;
+    if (scaler_.init(options_.scale_filter))
+        std::cout << "Scaler: " << scale_filter_name(options_.scale_filter) << std::endl;
+    else
+        options_.scale_filter = ScaleFilter::Bilinear;
 
-    // 初始化为黑色纹理
+    // 初始化为黑色 RGBA 纹理
     texture_width_ = 640;
     texture_height_ = 480;
     texture_data_.resize(texture_width_ * texture_height_ * 4, 0);
     // createTestImage();
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture_width_, texture_height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture_data_.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glUniform1i(glGetUniformLocation(shader_program_, "videoTexture"), 0);
-    glUseProgram(shader_program_);
+    texture_layout_.format = GST_VIDEO_FORMAT_RGBA;
+    texture_layout_.width = texture_width_;
+    texture_layout_.height = texture_height_;
+    texture_layout_.n_planes = 1;
+    texture_layout_.planes[0].width = texture_width_;
+    texture_layout_.planes[0].height = texture_height_;
+    allocate_plane_textures(texture_layout_);
+    glBindTexture(GL_TEXTURE_2D, plane_textures_[0]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture_width_, texture_height_, GL_RGBA, GL_UNSIGNED_BYTE, texture_data_.data());
+    upload_format_ = preferred_rgba_upload_format();
+
+    // 脏块比较需要读取客户端内存，只用于直接上传；上传线程轮换多组纹理，与上一帧副本对不上
+    if (options_.dirty_tiles)
+    {
+        if (options_.upload == TextureUpload::Direct && !options_.upload_thread)
+        {
+            for (TileDiff &tiles : tile_diffs_)
+                tiles = TileDiff(options_.tile_size);
+            std::cout << "Dirty-tile upload: " << options_.tile_size << "px tiles, " << tile_diff_simd_name() << std::endl;
+        }
+        else
+        {
+            std::cout << "Dirty-tile upload requires direct upload on the render thread, disabled" << std::endl;
+            options_.dirty_tiles = false;
+        }
+    }
+
+    // 创建 PBO 环
+    if (options_.upload == TextureUpload::Pbo && !pbo_ring_.init(options_.pbo_count))
+    {
+        std::cerr << "Failed to create PBO ring, falling back to direct upload" << std::endl;
+        options_.upload = TextureUpload::Direct;
+    }
+
+    // 创建持久映射区域（没有扩展时区域为空，缓冲池全部使用系统内存）
+    if (options_.upload == TextureUpload::PersistentPool)
+        create_persistent_region();
     glBindTexture(GL_TEXTURE_2D, 0);
 
     return true;
 }
 
-bool GstOpenGLPlayer::initialize(const std::string &video_source)
+bool GstOpenGLPlayer::initialize(const std::string &video_source, const PlayerOptions &options)
 {
-    // 初始化 window
-    if (!create_window())
+    options_ = options;
+    // 共享帧源：没有管道和 sample，渲染线程按刷新周期从帧环取最新帧，直接从共享映射上传
+    if (video_source.find("shm:") == 0)
+    {
+        frame_ring_path_ = video_source.substr(4);
+        if (options_.upload != TextureUpload::Direct && options_.upload != TextureUpload::Pbo)
+        {
+            std::cout << "Shared frame source uploads directly or through PBOs" << std::endl;
+            options_.upload = TextureUpload::Direct;
+        }
+        if (options_.pts_schedule || options_.upload_thread || options_.net_clock_port > 0 || !options_.net_clock.empty())
+            std::cout << "PTS scheduling, upload thread and network clock are not used with a shared frame source" << std::endl;
+        options_.handoff = FrameHandoff::Copy;
+        options_.delivery = SampleDelivery::Pull;
+        options_.pts_schedule = false;
+        options_.upload_thread = false;
+        options_.net_clock_port = 0;
+        options_.net_clock.clear();
+    }
+    // 持久映射缓冲与 GstGLMemory 都由 sample 持有，必须走零拷贝交接
+    if (options_.upload == TextureUpload::PersistentPool || options_.upload == TextureUpload::GLMemory)
+        options_.handoff = FrameHandoff::ZeroCopy;
+    // PTS 调度由渲染线程决定何时取下一帧
+    if (options_.pts_schedule)
+        options_.delivery = SampleDelivery::Pull;
+    // 上传线程消费推送来的帧；GstGLMemory 没有上传，PTS 调度在渲染线程上取帧
+    if (options_.upload_thread)
+    {
+        if (options_.upload == TextureUpload::GLMemory || options_.pts_schedule)
+        {
+            std::cout << "Upload thread is not used with GL memory or PTS scheduling" << std::endl;
+            options_.upload_thread = false;
+        }
+        else if (options_.delivery == SampleDelivery::Pull)
+        {
+            options_.delivery = SampleDelivery::Callbacks;
+        }
+    }
+
+    if (!crop_is_valid(options_.crop))
+    {
+        std::cerr << "Invalid crop rectangle" << std::endl;
+        return false;
+    }
+
+    // 初始化 window（无窗口模式创建离屏上下文）
+    if (options_.headless ? !create_offscreen() : !create_window())
     {
         std::cerr << "Failed to initialize window" << std::endl;
         return false;
@@ -159,12 +427,50 @@ bool GstOpenGLPlayer::initialize(const std::string &video_source)
     // 初始化 GStreamer
     gst_init(nullptr, nullptr);
 
+    // 把 GLFW（或离屏 EGL）上下文交给 GStreamer 的 GL 元素共享
+    if (options_.upload == TextureUpload::GLMemory &&
+        !(offscreen_.valid() ? gl_bridge_.wrap_current_egl(offscreen_.egl_display()) : gl_bridge_.wrap_current(window_)))
+    {
+        std::cerr << "Failed to share GL context with GStreamer" << std::endl;
+        return false;
+    }
+
+    // 可切换的源：启动源和预热源，共享帧源没有管道，不能切换；
+    // 网络时钟下各节点共用一个固定的 base time，新源从 0 开始的时间戳无法与其他节点对齐，同样不能切换
+    bool net_clock = options_.net_clock_port > 0 || !options_.net_clock.empty();
+    if (frame_ring_path_.empty() && net_clock && !options_.prewarm_sources.empty())
+    {
+        std::cout << "Source switching is not available with a network clock" << std::endl;
+        current_source_ = video_source;
+        sources_.push_back(video_source);
+    }
+    else if (frame_ring_path_.empty())
+    {
+        current_source_ = video_source;
+        sources_.push_back(video_source);
+        for (const std::string &source : options_.prewarm_sources)
+        {
+            if (std::find(sources_.begin(), sources_.end(), source) == sources_.end())
+                sources_.push_back(source);
+        }
+        pipeline_pool_.set_capacity((size_t)std::max(options_.pipeline_pool_size, 0));
+    }
+    else if (!options_.prewarm_sources.empty())
+    {
+        std::cout << "Source switching is not available with a shared frame source" << std::endl;
+    }
+
     // 创建 GStreamer 管道
-    if (!create_pipeline(video_source))
+    if (frame_ring_path_.empty() && !create_pipeline(video_source))
     {
         std::cerr << "Failed to create GStreamer pipeline" << std::endl;
         return false;
     }
+    if (net_clock && !setup_net_clock())
+    {
+        std::cerr << "Failed to set up network clock" << std::endl;
+        return false;
+    }
 
     is_running_ = true;
     return true;
@@ -172,86 +478,319 @@ bool GstOpenGLPlayer::initialize(const std::string &video_source)
 
 bool GstOpenGLPlayer::create_pipeline(const std::string &source)
 {
-    std::string pipeline_str;
+    GstElement *pipeline = build_pipeline(source, pipeline_timing_);
+    if (!pipeline)
+        return false;
+    attach_pipeline(pipeline);
+    return true;
+}
 
-    if (source.empty() || source == "test")
+// 构建并配置一条播放管道（appsink 的 caps、投递方式、探针和 GL 上下文应答），不接入总线监视，
+// 返回的管道归调用者所有；初始管道和预热管道都由这里构建
+GstElement *GstOpenGLPlayer::build_pipeline(const std::string &source, PipelineTiming &timing)
+{
+    // 元素逐个创建并链接，源地址只作为属性值，不再拼进 gst_parse_launch 字符串
+    SourceKind kind = source_kind(source);
+    SourceProfile profile = source_profile(kind);
+    if (kind == SourceKind::Test && source.size() > 5)
+        profile.source.properties = {{"pattern", source.substr(5)}};
+    if (kind == SourceKind::File)
     {
-        // 测试视频源
-        pipeline_str = "videotestsrc pattern=snow ! "
-                       "video/x-raw,width=640,height=480 ! "
-                       "queue ! appsink name=sink emit-signals=true sync=false";
+        // 按探测结果选择分离器和音频分支，文件没有变化时直接用缓存
+        MediaDiscoveryCache discovery;
+        MediaInfo media;
+        bool known = discovery.lookup(source, media);
+        discovery_stats_ = discovery.stats();
+        if (known)
+        {
+            std::cout << "Media: " << media.container_caps << ", " << media.width << "x" << media.height << " @ "
+                      << media.fps_n << "/" << media.fps_d << (media.has_audio ? ", audio" : ", no audio") << " ("
+                      << (discovery_stats_.cached ? "cached" : "probed") << " in " << discovery_stats_.elapsed_ms
+                      << " ms)" << std::endl;
+        }
+        profile = auto_file_profile(known ? &media : nullptr);
     }
-    else if (source.find("rtsp://") == 0 || source.find("rtmp://") == 0)
+    PipelineBuilder builder("player");
+    builder.add_profile(profile, source);
+    // GstGLMemory：上传和颜色转换在 GL 元素中完成，appsink 直接收到纹理
+    if (options_.upload == TextureUpload::GLMemory)
     {
-        // 网络流
-        pipeline_str = "rtspsrc location=" + source + " latency=0 ! "
-                                                      "rtph264depay ! h264parse ! avdec_h264 ! "
-                                                      "videoconvert ! video/x-raw,format=RGBA ! "
-                                                      "queue ! appsink name=sink emit-signals=true sync=false";
+        builder.add("glupload");
+        builder.add("glcolorconvert");
     }
-    else if (source.find("http://") == 0 || source.find("https://") == 0)
+    builder.add(ElementSpec{"appsink", "sink", {{"sync", profile.sync ? "true" : "false"}}});
+    std::cout << "Creating " << profile.name << " pipeline: " << builder.description() << std::endl;
+
+    GstElement *pipeline = builder.finish(timing);
+    if (!pipeline)
     {
-        // HTTP 流
-        pipeline_str = "souphttpsrc location=" + source + " ! "
-                                                          "decodebin ! videoconvert ! video/x-raw,format=RGBA ! "
-                                                          "queue ! appsink name=sink emit-signals=true sync=false";
+        std::cerr << "Failed to create pipeline: " << builder.error() << std::endl;
+        return nullptr;
     }
-    else
+    std::cout << "Pipeline built in " << timing.build_ms << " ms (" << timing.elements << " elements)" << std::endl;
+
+    // 获取 appsink
+    GstElement *appsink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    if (!appsink)
     {
-        // 本地文件
-        // pipeline_str = "filesrc location=" + source + " ! "
-        //                                               "decodebin ! videoconvert ! "
-        //                                               "video/x-raw,format=RGBA ! "
-        //                                               "queue ! myelement ! appsink name=sink emit-signals=true sync=true";
-        // pipeline_str = "filesrc location=" + source + " ! "
-        //                                               "decodebin name=dec ! "
-        //                                               "queue ! videoconvert ! video/x-raw,format=RGBA ! appsink name=sink emit-signals=true sync=true ";
+        std::cerr << "Failed to get appsink element" << std::endl;
+        gst_object_unref(pipeline);
+        return nullptr;
+    }
+
+    // appsink 直接接受解码器输出的 YUV，videoconvert 只在上游格式不在列表中时才真正转换
+    GstCaps *sink_caps = gst_caps_from_string(options_.upload == TextureUpload::GLMemory
+                                                  ? "video/x-raw(memory:GLMemory),format=(string)RGBA,texture-target=(string)2D"
+                                                  : appsink_video_caps(options_.native_yuv, upload_format_));
+    gst_app_sink_set_caps(GST_APP_SINK(appsink), sink_caps);
+    gst_caps_unref(sink_caps);
 
-        pipeline_str = "filesrc location=" + source + " ! "
-                                                      "matroskademux name=dec ! "
-                                                      "queue ! vorbisdec ! audioresample ! autoaudiosink dec. !"
-                                                      "queue ! vp8dec ! videoconvert ! myelement ! textoverlay name=overlay font-desc=\"Sans Bold 10\" ! video/x-raw,format=RGBA ! appsink name=sink emit-signals=true sync=true";
-        // pipeline_str = "filesrc location=" + source + " ! "
-        //                                               "qtdemux name=dec "
-        //                                               "dec.video_0  ! queue ! decodebin ! videoconvert ! video/x-raw,format=RGBA ! appsink name=sink emit-signals=true sync=true";
+    // 设置 appsink 属性
+    gboolean emit_signals = options_.delivery == SampleDelivery::Signal;
+    g_object_set(appsink, "emit-signals", emit_signals, "max-buffers", 1, "drop", TRUE, nullptr);
+    // PTS 调度：时间由渲染端掌握，appsink 不再同步；不丢帧，队列满时反压上游
+    if (options_.pts_schedule)
+        g_object_set(appsink, "sync", FALSE, "max-buffers", 3, "drop", FALSE, nullptr);
+
+    switch (options_.delivery)
+    {
+    case SampleDelivery::Signal:
+        // 连接新样本信号
+        g_signal_connect(appsink, "new-sample", G_CALLBACK(new_sample_callback), this);
+        break;
+    case SampleDelivery::Callbacks:
+    {
+        // 直接回调，省去每帧一次 GObject 信号发射
+        GstAppSinkCallbacks callbacks = {};
+        callbacks.new_sample = appsink_new_sample;
+        gst_app_sink_set_callbacks(GST_APP_SINK(appsink), &callbacks, this, nullptr);
+        break;
+    }
+    case SampleDelivery::Pull:
+        // 由 run() 主动拉取
+        break;
     }
-    std::cout << "Creating pipeline: " << pipeline_str << std::endl;
 
-    GError *error = nullptr;
-    pipeline_ = gst_parse_launch(pipeline_str.c_str(), &error);
+    // 跟踪 caps 事件，区分重新协商与重复发送的相同 caps
+    GstPad *caps_pad = gst_element_get_static_pad(appsink, "sink");
+    gst_pad_add_probe(caps_pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, caps_event_probe, this, nullptr);
+    gst_object_unref(caps_pad);
 
-    if (error)
+    // 在 appsink 一侧应答 ALLOCATION 查询，向上游提供持久映射缓冲池
+    if (options_.upload == TextureUpload::PersistentPool)
     {
-        std::cerr << "Failed to create pipeline: " << error->message << std::endl;
-        g_error_free(error);
-        return false;
+        GstPad *sink_pad = gst_element_get_static_pad(appsink, "sink");
+        gst_pad_add_probe(sink_pad, GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM, allocation_query_probe, this, nullptr);
+        gst_object_unref(sink_pad);
     }
+    gst_object_unref(appsink);
 
-    if (!pipeline_)
+    // need-context 在流线程中同步发出，必须用同步回调应答（预热的管道在 PAUSED 时就会请求）
+    if (gl_bridge_.context())
     {
-        std::cerr << "Pipeline is null" << std::endl;
-        return false;
+        GstBus *bus = gst_element_get_bus(pipeline);
+        gst_bus_set_sync_handler(bus, bus_sync_handler, this, nullptr);
+        gst_object_unref(bus);
     }
+    return pipeline;
+}
 
-    // 获取 appsink
+// 把管道设为当前播放的管道（接管引用）：取 appsink 和叠加文字元素，接入总线监视
+void GstOpenGLPlayer::attach_pipeline(GstElement *pipeline)
+{
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    pipeline_ = pipeline;
     appsink_ = gst_bin_get_by_name(GST_BIN(pipeline_), "sink");
-    if (!appsink_)
+    textoverlay = gst_bin_get_by_name(GST_BIN(pipeline_), "overlay");
+    duration_ns = 0;
+    // 获取总线并连接消息回调
+    bus_ = gst_element_get_bus(pipeline_);
+    gst_bus_add_watch(bus_, bus_callback, this);
+}
+
+// 取下当前管道（引用交给调用者），之后它的总线消息不再处理
+GstElement *GstOpenGLPlayer::detach_pipeline()
+{
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    if (bus_)
     {
-        std::cerr << "Failed to get appsink element" << std::endl;
-        return false;
+        gst_bus_remove_watch(bus_);
+        gst_object_unref(bus_);
+        bus_ = nullptr;
+    }
+    if (appsink_)
+    {
+        gst_object_unref(appsink_);
+        appsink_ = nullptr;
+    }
+    if (textoverlay)
+    {
+        gst_object_unref(textoverlay);
+        textoverlay = nullptr;
     }
+    GstElement *pipeline = pipeline_;
+    pipeline_ = nullptr;
+    return pipeline;
+}
 
-    // 设置 appsink 属性
-    g_object_set(appsink_, "emit-signals", TRUE, "max-buffers", 1, "drop", TRUE, nullptr);
+// 为其余可切换的源构建管道并放进池中预卷（不等待预卷完成）
+void GstOpenGLPlayer::warm_sources()
+{
+    if (sources_.size() < 2 || pipeline_pool_.capacity() == 0)
+        return;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string &source : sources_)
+    {
+        if (source == current_source_ || pipeline_pool_.contains(source))
+            continue;
+        if (pipeline_pool_.size() >= pipeline_pool_.capacity())
+            break;
+        PipelineTiming timing;
+        GstElement *pipeline = build_pipeline(source, timing);
+        if (pipeline)
+            pipeline_pool_.put(source, pipeline, timing);
+    }
+    std::cout << "Pre-warmed " << pipeline_pool_.size() << " pipeline(s) in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms"
+              << std::endl;
+}
 
-    // 连接新样本信号
-    g_signal_connect(appsink_, "new-sample", G_CALLBACK(new_sample_callback), this);
+// 请求切换（任意线程），由渲染线程在下一次循环中执行
+void GstOpenGLPlayer::switch_source(const std::string &source)
+{
+    {
+        std::lock_guard<std::mutex> lock(switch_mutex_);
+        requested_source_ = source;
+        requested_at_ = std::chrono::steady_clock::now();
+    }
+    wake_render_loop();
+}
 
-    // 获取总线并连接消息回调
-    bus_ = gst_element_get_bus(pipeline_);
+// 源列表中相对当前源的第 offset 个（循环）
+const std::string &GstOpenGLPlayer::adjacent_source(int offset) const
+{
+    size_t index = std::find(sources_.begin(), sources_.end(), current_source_) - sources_.begin();
+    size_t count = sources_.size();
+    return sources_[(index + count + offset % (int)count) % count];
+}
 
-    gst_bus_add_watch(bus_, bus_callback, this);
+void GstOpenGLPlayer::process_switch()
+{
+    std::string source;
+    std::chrono::steady_clock::time_point requested_at;
+    {
+        std::lock_guard<std::mutex> lock(switch_mutex_);
+        source.swap(requested_source_);
+        requested_at = requested_at_;
+    }
+    if (source.empty() || source == current_source_ || !pipeline_)
+        return;
+    if (net_clock_.active())
+    {
+        std::cerr << "Cannot switch to " << source << " while following a network clock" << std::endl;
+        return;
+    }
+    if (!switch_pipeline(source, requested_at))
+        std::cerr << "Failed to switch to " << source << ", keeping " << current_source_ << std::endl;
+}
+
+// 交换当前管道：窗口、GL 资源、纹理和邮箱中的最后一帧都保留，新源第一帧上传前屏幕上仍是旧画面
+bool GstOpenGLPlayer::switch_pipeline(const std::string &source, std::chrono::steady_clock::time_point requested_at)
+{
+    PipelineTiming timing;
+    bool prerolled = false;
+    GstElement *next = pipeline_pool_.take(source, 2 * GST_SECOND, timing, prerolled);
+    bool warm = next != nullptr;
+    if (!next)
+        next = build_pipeline(source, timing);
+    if (!next)
+        return false;
+
+    // 旧管道先停到 READY：等它的流线程退出后新管道才开始推帧，邮箱始终只有一个生产者
+    GstElement *previous = detach_pipeline();
+    gst_element_set_state(previous, GST_STATE_READY);
+    if (scheduled_sample_)
+    {
+        gst_sample_unref(scheduled_sample_);
+        scheduled_sample_ = nullptr;
+    }
+    source_generation_++;
+    attach_pipeline(next);
+    gst_element_set_state(pipeline_, GST_STATE_PLAYING);
+
+    // 旧源回到池中重新预卷，切回时同样不需要重建
+    pipeline_pool_.put(current_source_, previous, pipeline_timing_);
+    std::cout << "Switching to " << source << " (" << (warm ? (prerolled ? "pre-warmed" : "pre-warmed, prerolling") : "cold")
+              << ")" << std::endl;
+    current_source_ = source;
+    pipeline_timing_ = timing;
+    switch_pending_ = true;
+    switch_start_ = requested_at;
+    switch_warm_ = warm;
+    switch_prerolled_ = prerolled;
+    return true;
+}
+
+// 一帧交换完成：新源的第一帧结束切换计时；按帧数自动切换时在这里发出下一次请求
+void GstOpenGLPlayer::source_presented(uint64_t generation, std::chrono::steady_clock::time_point swap_end)
+{
+    // 新源的帧已经上屏后不应再出现更早的源
+    if (generation < presented_generation_)
+    {
+        switch_stats_.stale++;
+        return;
+    }
+    presented_generation_ = generation;
+    // 切换前旧源留在邮箱中的帧
+    if (generation != source_generation_.load())
+        return;
+    if (switch_pending_)
+    {
+        double ms = std::chrono::duration<double, std::milli>(swap_end - switch_start_).count();
+        switch_stats_.switches++;
+        switch_stats_.warm += switch_warm_ ? 1 : 0;
+        switch_stats_.prerolled += switch_prerolled_ ? 1 : 0;
+        switch_stats_.total_ms += ms;
+        switch_stats_.last_ms = ms;
+        switch_stats_.max_ms = std::max(switch_stats_.max_ms, ms);
+        std::cout << "Switched to " << current_source_ << " in " << ms << " ms (request to first frame)" << std::endl;
+        switch_pending_ = false;
+        frames_since_switch_ = 0;
+    }
+    frames_since_switch_++;
+    if (options_.switch_every_frames > 0 && frames_since_switch_ == options_.switch_every_frames && sources_.size() > 1)
+        switch_source(adjacent_source(1));
+}
 
+bool GstOpenGLPlayer::setup_net_clock()
+{
+    if (options_.net_clock_port > 0)
+    {
+        if (!net_clock_.serve(options_.net_clock_port))
+            return false;
+        std::cout << "Network clock published on port " << net_clock_.port() << ", base time " << net_clock_.base_time()
+                  << std::endl;
+        std::cout << "Start nodes with --net-clock=<this host>:" << net_clock_.port() << " --base-time=" << net_clock_.base_time()
+                  << std::endl;
+    }
+    else
+    {
+        std::string host;
+        int port = 0;
+        if (!NetClockSync::parse_address(options_.net_clock, host, port))
+        {
+            std::cerr << "Invalid network clock address: " << options_.net_clock << std::endl;
+            return false;
+        }
+        if (!net_clock_.follow(host, port, options_.net_base_time))
+            return false;
+        std::cout << "Following network clock " << host << ":" << port << ", offset " << net_clock_.offset_ms() << " ms"
+                  << std::endl;
+    }
+    net_clock_.apply(pipeline_);
+    // 各节点在共同时钟上按 PTS 呈现：appsink 同步到时钟（PTS 调度时由渲染端按同一时钟决定）
+    if (!options_.pts_schedule)
+        g_object_set(appsink_, "sync", TRUE, nullptr);
     return true;
 }
 
@@ -267,60 +806,178 @@ GstFlowReturn GstOpenGLPlayer::new_sample_callback(GstElement *sink, gpointer da
         return GST_FLOW_ERROR;
     }
 
-    // 获取 buffer
-    GstBuffer *buffer = gst_sample_get_buffer(sample);
-    GstCaps *caps = gst_sample_get_caps(sample);
+    player->handle_sample(sample);
+    return GST_FLOW_OK;
+}
 
-    if (buffer && caps)
+GstFlowReturn GstOpenGLPlayer::appsink_new_sample(GstAppSink *sink, gpointer data)
+{
+    GstOpenGLPlayer *player = static_cast<GstOpenGLPlayer *>(data);
+
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (!sample)
     {
-        // 解析视频信息
-        GstVideoInfo info;
-        gst_video_info_from_caps(&info, caps);
+        g_printerr("Failed to pull sample\n");
+        return GST_FLOW_ERROR;
+    }
 
-        int width = GST_VIDEO_INFO_WIDTH(&info);
-        int height = GST_VIDEO_INFO_HEIGHT(&info);
+    player->handle_sample(sample);
+    return GST_FLOW_OK;
+}
 
-        // 映射 buffer
-        GstMapInfo map;
-        if (gst_buffer_map(buffer, &map, GST_MAP_READ))
-        {
-            // std::lock_guard<std::mutex> lock(player->texture_mutex_);
-            // 检查纹理尺寸是否需要更新
-            if (width != player->texture_width_ || height != player->texture_height_)
-            {
-                player->texture_width_ = width;
-                player->texture_height_ = height;
-                player->texture_data_.resize(width * height * 4);
-            }
+// 应答 ALLOCATION 查询：每次协商都提供一个新的缓冲池，所有缓冲池共享同一块持久映射区域
+GstPadProbeReturn GstOpenGLPlayer::allocation_query_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    GstOpenGLPlayer *player = static_cast<GstOpenGLPlayer *>(data);
+    GstQuery *query = GST_PAD_PROBE_INFO_QUERY(info);
+    if (GST_QUERY_TYPE(query) != GST_QUERY_ALLOCATION || !player->persistent_region_)
+        return GST_PAD_PROBE_OK;
 
-            // 复制数据（假设数据是 RGBA 格式）
-            size_t data_size = map.size;
-            size_t expected_size = width * height * 4;
+    GstCaps *caps = nullptr;
+    gboolean need_pool = FALSE;
+    gst_query_parse_allocation(query, &caps, &need_pool);
 
-            if (data_size >= expected_size)
-            {
-                memcpy(player->texture_data_.data(), map.data, expected_size);
-                player->has_new_frame_ = true;
-            }
-            gst_buffer_unmap(buffer, &map);
-        }
+    GstVideoInfo video_info;
+    if (!caps || !gst_video_info_from_caps(&video_info, caps))
+        return GST_PAD_PROBE_OK;
+
+    if (need_pool)
+    {
+        guint size = (guint)GST_VIDEO_INFO_SIZE(&video_info);
+        GstBufferPool *pool = gst_persistent_buffer_pool_new(player->persistent_region_);
+        GstStructure *config = gst_buffer_pool_get_config(pool);
+        gst_buffer_pool_config_set_params(config, caps, size, 2, 0);
+        gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+        if (gst_buffer_pool_set_config(pool, config))
+            gst_query_add_allocation_pool(query, pool, size, 2, 0);
+        gst_object_unref(pool);
     }
+    gst_query_add_allocation_meta(query, GST_VIDEO_META_API_TYPE, nullptr);
 
-    gst_sample_unref(sample);
-    return GST_FLOW_OK;
+    return GST_PAD_PROBE_HANDLED;
 }
 
-gboolean GstOpenGLPlayer::bus_callback(GstBus *bus, GstMessage *msg, gpointer data)
+// caps 事件：只在 GstVideoInfo 真正变化时计为一次重新协商
+GstPadProbeReturn GstOpenGLPlayer::caps_event_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data)
 {
     GstOpenGLPlayer *player = static_cast<GstOpenGLPlayer *>(data);
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+    if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS)
+        return GST_PAD_PROBE_OK;
+
+    GstCaps *caps = nullptr;
+    GstVideoInfo video_info;
+    gst_event_parse_caps(event, &caps);
+    if (!caps || !gst_video_info_from_caps(&video_info, caps))
+        return GST_PAD_PROBE_OK;
+
+    player->stats_.caps_events++;
+    if (player->has_negotiated_info_ && gst_video_info_is_equal(&video_info, &player->negotiated_info_))
+        return GST_PAD_PROBE_OK;
+
+    player->negotiated_info_ = video_info;
+    player->has_negotiated_info_ = true;
+    player->stats_.caps_changes++;
+    std::cout << "Negotiated " << gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&video_info)) << " "
+              << GST_VIDEO_INFO_WIDTH(&video_info) << "x" << GST_VIDEO_INFO_HEIGHT(&video_info) << std::endl;
+    return GST_PAD_PROBE_OK;
+}
 
-    switch (GST_MESSAGE_TYPE(msg))
-    {
-    case GST_MESSAGE_ERROR:
+// 把一帧放进邮箱（接管 sample 的引用）
+void GstOpenGLPlayer::handle_sample(GstSample *sample)
+{
+    // 获取 buffer
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstCaps *caps = gst_sample_get_caps(sample);
+
+    stats_.frames_received++;
+
+    // 邮箱 back 槽只属于生产者线程（appsink 线程或拉模式下的渲染线程），写入期间不需要加锁
+    VideoFrame &frame = mailbox_.back();
+    // 槽中可能残留被覆盖的旧帧
+    if (frame.sample)
     {
-        GError *err = nullptr;
-        gchar *debug = nullptr;
-        gst_message_parse_error(msg, &err, &debug);
+        gst_sample_unref(frame.sample);
+        frame.sample = nullptr;
+    }
+
+    // caps 只在重新协商时变化，这里通常只是一次指针比较
+    frame.video = descriptor_cache_.get(caps);
+    frame.running_time = sample_running_time(sample);
+    frame.source_generation = source_generation_.load();
+    if (!buffer || !frame.video)
+    {
+        stats_.frames_rejected++;
+        gst_sample_unref(sample);
+        return;
+    }
+
+    if (options_.handoff == FrameHandoff::ZeroCopy)
+    {
+        // 零拷贝：只保留 sample 引用，由渲染线程直接从 buffer 上传
+        frame.sample = sample;
+        publish_frame(frame);
+        return;
+    }
+
+    // 按 GstVideoMeta 给出的步长映射，行填充原样保留
+    GstVideoFrame vframe;
+    if (gst_video_frame_map(&vframe, &frame.video->info, buffer, GST_MAP_READ))
+    {
+        FrameLayout layout = frame.video->layout;
+        if (frame_layout_apply_planes(layout, vframe.info.stride, nullptr))
+        {
+            // 各平面依次拷贝，平面偏移改为相对 data 起点
+            size_t total = 0;
+            for (int i = 0; i < layout.n_planes; ++i)
+            {
+                layout.planes[i].offset = total;
+                total += layout.planes[i].span();
+            }
+            frame.data.resize(total);
+            for (int i = 0; i < layout.n_planes; ++i)
+                memcpy(frame.data.data() + layout.planes[i].offset, GST_VIDEO_FRAME_PLANE_DATA(&vframe, i), layout.planes[i].span());
+            frame.layout = layout;
+            stats_.intermediate_copies++;
+            stats_.bytes_copied += total;
+            publish_frame(frame);
+        }
+        else
+        {
+            stats_.frames_rejected++;
+        }
+        gst_video_frame_unmap(&vframe);
+    }
+    else
+    {
+        stats_.frames_rejected++;
+    }
+
+    gst_sample_unref(sample);
+}
+
+GstBusSyncReply GstOpenGLPlayer::bus_sync_handler(GstBus *bus, GstMessage *msg, gpointer data)
+{
+    GstOpenGLPlayer *player = static_cast<GstOpenGLPlayer *>(data);
+    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_NEED_CONTEXT && player->gl_bridge_.handle_need_context(msg))
+    {
+        gst_message_unref(msg);
+        return GST_BUS_DROP;
+    }
+    return GST_BUS_PASS;
+}
+
+gboolean GstOpenGLPlayer::bus_callback(GstBus *bus, GstMessage *msg, gpointer data)
+{
+    GstOpenGLPlayer *player = static_cast<GstOpenGLPlayer *>(data);
+
+    switch (GST_MESSAGE_TYPE(msg))
+    {
+    case GST_MESSAGE_ERROR:
+    {
+        GError *err = nullptr;
+        gchar *debug = nullptr;
+        gst_message_parse_error(msg, &err, &debug);
 
         std::cerr << "GStreamer error: " << err->message << std::endl;
         if (debug)
@@ -334,6 +991,7 @@ gboolean GstOpenGLPlayer::bus_callback(GstBus *bus, GstMessage *msg, gpointer da
         break;
     }
     case GST_MESSAGE_EOS:
+        // 主循环线程上只请求停止：渲染线程仍在使用 appsink、FBO 和上下文（无窗口时还要写快照）
         std::cout << "End of stream" << std::endl;
         player->stop();
         break;
@@ -360,6 +1018,10 @@ gboolean GstOpenGLPlayer::bus_callback(GstBus *bus, GstMessage *msg, gpointer da
 // 更新显示的文本
 void GstOpenGLPlayer::update_overlay_text()
 {
+    // 在 GLib 主循环线程中执行，渲染线程切换源时会替换管道和叠加文字元素
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    if (!pipeline_ || !textoverlay)
+        return;
 
     gchar *text = NULL;
 
@@ -369,7 +1031,6 @@ void GstOpenGLPlayer::update_overlay_text()
     {
         position = 0;
     }
-    printf("更新----");
     // 计算时间（时:分:秒.毫秒）
     guint hours = (guint)(position / (3600 * GST_SECOND));
     guint minutes = (guint)((position % (3600 * GST_SECOND)) / (60 * GST_SECOND));
@@ -416,30 +1077,165 @@ void GstOpenGLPlayer::update_display(gpointer user_data)
         player->update_overlay_text();
     }
 
-    printf("更新\r\n");
     return;
 }
 
+// 发布邮箱 back 槽中的帧，并唤醒阻塞在事件等待中的渲染线程
+void GstOpenGLPlayer::publish_frame(VideoFrame &frame)
+{
+    frame.arrival = std::chrono::steady_clock::now();
+    mailbox_.publish();
+    // 流线程上不能读 upload_thread_（渲染线程可能正在启动它），只看原子标志
+    if (upload_running_.load(std::memory_order_acquire))
+    {
+        // 经过互斥量再通知，避免上传线程检查完条件、尚未开始等待时错过唤醒
+        {
+            std::lock_guard<std::mutex> lock(upload_mutex_);
+        }
+        upload_cv_.notify_one();
+    }
+    else if (options_.render_loop == RenderLoop::Event && options_.delivery != SampleDelivery::Pull)
+    {
+        wake_render_loop();
+    }
+}
+
 void GstOpenGLPlayer::render_frame()
 {
-    // 更新纹理（如果有新帧）
-    if (!has_new_frame_)
+    // 只在有新帧或窗口需要重绘（暴露、尺寸变化）时绘制
+    const GLuint *textures = plane_textures_;
+    const FrameLayout *layout = &texture_layout_;
+    UploadedTextures *uploaded = nullptr;
+    bool new_frame;
+    if (upload_running_.load(std::memory_order_relaxed))
+    {
+        // 上传已在上传线程完成，这里只在 GPU 端等待它的栅栏
+        new_frame = uploaded_.acquire();
+        uploaded = &uploaded_.front();
+        if (uploaded->ready)
+        {
+            glWaitSync(uploaded->ready, 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(uploaded->ready);
+            uploaded->ready = nullptr;
+        }
+        textures = uploaded->textures;
+        layout = &uploaded->layout;
+    }
+    else
+    {
+        new_frame = mailbox_.acquire();
+    }
+    if (!new_frame && !redraw_pending_)
         return;
-    updateTextureData();
-    // 清除颜色缓冲区
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    if (new_frame && !uploaded)
+        updateTextureData();
+    else if (!new_frame)
+        present_stats_.expose_redraws++;
+    redraw_pending_ = false;
+    // 整个目标清成黑色，视口之外即为黑边
+    GLuint target_fbo = options_.headless ? fbo_ : 0;
+    glBindFramebuffer(GL_FRAMEBUFFER, target_fbo);
+    glViewport(0, 0, framebuffer_width_, framebuffer_height_);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
+
+    ScaleViewport view;
+    view.width = framebuffer_width_;
+    view.height = framebuffer_height_;
+    if (options_.keep_aspect)
+        view = letterbox_viewport(framebuffer_width_, framebuffer_height_, layout->display_width() * options_.crop.width,
+                                  layout->height * options_.crop.height);
+    // 只显示一部分时把整幅画面放大平移，裁剪测试限制在 crop 区域的视口内（黑边保持不变）
+    ScaleViewport visible = view;
+    bool cropped = !crop_is_full(options_.crop);
+    if (cropped)
+        view = crop_viewport(view, options_.crop);
+
+    // 颜色转换：bilinear 直接画进目标视口，其余档位先画进视频尺寸的中间纹理
+    scaler_.begin_frame();
+    if (scaler_.uses_intermediate())
+        scaler_.bind_intermediate(layout->width, layout->height);
+    else
+        glViewport(view.x, view.y, view.width, view.height);
+    // 中间纹理按视频尺寸完整绘制，裁剪只作用在画进目标的那一步
+    if (cropped && !scaler_.uses_intermediate())
+    {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(visible.x, visible.y, visible.width, visible.height);
+    }
+
     // bind textures on corresponding texture units
+    for (int i = 0; i < layout->n_planes; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, i == 0 && gl_texture_ ? gl_texture_ : textures[i]);
+    }
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture_id_);
 
     // render container
-    glUseProgram(shader_program_);
+    GLuint program = shader_programs_[(int)layout->shader];
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "colorMatrix"), 1, GL_TRUE, layout->color_matrix);
+    glUniform1i(glGetUniformLocation(program, "frameWidth"), layout->width);
     glBindVertexArray(vao_);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    if (scaler_.uses_intermediate())
+    {
+        if (cropped)
+        {
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(visible.x, visible.y, visible.width, visible.height);
+        }
+        scaler_.draw_scaled(target_fbo, view, vao_);
+    }
+    glDisable(GL_SCISSOR_TEST);
+    scaler_.end_frame();
+    if (uploaded)
+    {
+        // 上传线程下次改写这组纹理前等待这次绘制（交换时随之 flush）
+        if (uploaded->released)
+            glDeleteSync(uploaded->released);
+        uploaded->released = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
     // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
     // -------------------------------------------------------------------------------
-    glfwSwapBuffers(window_);
+    auto swap_start = std::chrono::steady_clock::now();
+    // 无窗口时没有 vblank，以 GPU 完成绘制作为“交换”完成
+    if (options_.headless)
+        glFinish();
+    else
+        glfwSwapBuffers(window_);
+    auto swap_end = std::chrono::steady_clock::now();
+    present_stats_.swaps++;
+    std::chrono::steady_clock::time_point arrival = uploaded ? uploaded->arrival : mailbox_.front().arrival;
+    if (new_frame && uploaded && uploaded->content_period_us > 0.0)
+        pacing_.set_content_period_us(uploaded->content_period_us);
+    else if (new_frame && !uploaded && mailbox_.front().video && mailbox_.front().video->info.fps_n > 0)
+    {
+        const GstVideoInfo &info = mailbox_.front().video->info;
+        pacing_.set_content_period_us(1e6 * info.fps_d / info.fps_n);
+    }
+    pacing_.record(swap_start, swap_end, new_frame);
+    // 交换完成时刻相对共同时钟上期望时间的误差，各节点的误差之差即为节点间的呈现偏差
+    if (new_frame && net_clock_.active())
+        net_clock_.record_present(uploaded ? uploaded->running_time : mailbox_.front().running_time);
+    if (options_.pts_schedule)
+    {
+        scheduler_.on_swap_complete(swap_end);
+        if (new_frame && has_scheduled_due_)
+            scheduler_.record_present(scheduled_due_, swap_end);
+        has_scheduled_due_ = false;
+    }
+    if (new_frame)
+        source_presented(uploaded ? uploaded->source_generation : mailbox_.front().source_generation, swap_end);
+    if (new_frame)
+    {
+        double latency_us = std::chrono::duration<double, std::micro>(swap_end - arrival).count();
+        present_stats_.latency_samples++;
+        present_stats_.latency_total_us += latency_us;
+        if (latency_us > present_stats_.latency_max_us)
+            present_stats_.latency_max_us = latency_us;
+    }
 
     // 在开始渲染循环前等待一下，让GPU完成纹理上传
     // std::this_thread::sleep_for(std::chrono::milliseconds(33));
@@ -450,56 +1246,910 @@ void GstOpenGLPlayer::render_frame()
 // 更新纹理数据（用于视频帧）
 void GstOpenGLPlayer::updateTextureData()
 {
+    // front 槽只属于渲染线程，上传期间 appsink 线程不会改写它
+    VideoFrame &frame = mailbox_.front();
+    if (frame.shared.valid())
+    {
+        upload_shared_frame(frame);
+        return;
+    }
+    if (options_.handoff == FrameHandoff::ZeroCopy)
+    {
+        upload_from_sample(frame);
+        return;
+    }
 
-    // std::lock_guard<std::mutex> lock(texture_mutex_);
-    glBindTexture(GL_TEXTURE_2D, texture_id_);
-    if (has_new_frame_)
+    if (frame.data.empty())
+        return;
+
+    const uint8_t *planes[MAX_VIDEO_PLANES] = {};
+    for (int i = 0; i < frame.layout.n_planes; ++i)
+        planes[i] = frame.data.data() + frame.layout.planes[i].offset;
+    ensure_textures(*frame.video);
+    upload_planes(planes, frame.layout);
+    stats_.frames_uploaded++;
+}
+
+// 把一帧的各平面上传到对应纹理，返回 true 表示 GL 可能仍在读取客户端内存（直接上传）
+bool GstOpenGLPlayer::upload_planes(const uint8_t *const planes[], const FrameLayout &layout)
+{
+    bool reads_client_memory = true;
+    if (options_.upload == TextureUpload::Pbo)
     {
-        // 重新分配纹理内存
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture_width_, texture_height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture_data_.data());
-        has_new_frame_ = false;
-        std::cout << "Texture resized to: " << texture_width_ << "x" << texture_height_ << std::endl;
+        // 所有平面写入同一个映射的 PBO，再按各自的偏移从 PBO 上传，不阻塞渲染线程
+        size_t offsets[MAX_VIDEO_PLANES] = {};
+        size_t size = 0;
+        for (int i = 0; i < layout.n_planes; ++i)
+        {
+            offsets[i] = size;
+            size += (layout.planes[i].span() + 15) & ~(size_t)15;
+        }
+        uint8_t *dst = (uint8_t *)pbo_ring_.map_next(size);
+        if (dst)
+        {
+            for (int i = 0; i < layout.n_planes; ++i)
+                memcpy(dst + offsets[i], planes[i], layout.planes[i].span());
+            if (pbo_ring_.unmap())
+            {
+                for (int i = 0; i < layout.n_planes; ++i)
+                    upload_plane(i, layout.planes[i], (const void *)offsets[i], offsets[i]);
+            }
+            pbo_ring_.fence_and_advance();
+            reads_client_memory = false;
+        }
     }
-    else
+    if (reads_client_memory)
     {
         // 更新纹理数据（更高效的方式）
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture_width_, texture_height_, GL_RGBA, GL_UNSIGNED_BYTE, texture_data_.data());
+        for (int i = 0; i < layout.n_planes; ++i)
+        {
+            if (options_.dirty_tiles)
+                upload_plane_tiles(i, layout.planes[i], planes[i]);
+            else
+                upload_plane(i, layout.planes[i], planes[i], (size_t)planes[i]);
+        }
     }
+    reset_unpack_layout();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return reads_client_memory;
+}
+
+// 上传一个平面，pixels 为客户端指针或当前绑定 PBO 中的偏移
+void GstOpenGLPlayer::upload_plane(int index, const PlaneLayout &plane, const void *pixels, size_t address)
+{
+    glBindTexture(GL_TEXTURE_2D, plane_textures_[index]);
+    set_unpack_layout(plane.stride, plane.bytes_per_pixel, address);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, plane.width, plane.height, plane.gl_format, GL_UNSIGNED_BYTE, pixels);
+}
+
+// 只上传与上一帧相比发生变化的块，同一行相邻的脏块合并为一次 glTexSubImage2D
+void GstOpenGLPlayer::upload_plane_tiles(int index, const PlaneLayout &plane, const uint8_t *pixels)
+{
+    TileDiff &tiles = tile_diffs_[index];
+    const std::vector<TileRect> &rects = tiles.diff(pixels, plane.stride, plane.width, plane.height, plane.bytes_per_pixel);
+
+    glBindTexture(GL_TEXTURE_2D, plane_textures_[index]);
+    for (const TileRect &rect : rects)
+    {
+        const uint8_t *origin = pixels + (size_t)rect.y * plane.stride + (size_t)rect.x * plane.bytes_per_pixel;
+        set_unpack_layout(plane.stride, plane.bytes_per_pixel, (size_t)origin);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, plane.gl_format, GL_UNSIGNED_BYTE, origin);
+    }
+
+    stats_.tile_frames++;
+    stats_.tiles_total += tiles.total_tiles();
+    stats_.tiles_changed += tiles.changed_tiles();
+    stats_.tile_bytes_saved += tiles.frame_bytes() - tiles.changed_bytes();
+}
+
+// 每次协商检查一次：只有格式或尺寸变化时才重新分配各平面的纹理，其余帧只做 glTexSubImage2D；
+// 同时记录该协商的着色器变体与颜色矩阵
+void GstOpenGLPlayer::ensure_textures(const VideoDescriptor &video)
+{
+    if (video.generation == texture_generation_)
+        return;
+    texture_generation_ = video.generation;
 
+    const FrameLayout &layout = video.layout;
+    bool reallocate = !texture_layout_.same_textures(layout);
+    texture_layout_ = layout;
+    if (!reallocate)
+        return;
+
+    allocate_plane_textures(layout);
+    texture_width_ = layout.width;
+    texture_height_ = layout.height;
+    std::cout << "Texture resized to: " << texture_width_ << "x" << texture_height_
+              << " (" << gst_video_format_to_string(layout.format) << ", " << layout.n_planes << " planes)" << std::endl;
+}
+
+// 为各平面分配纹理存储。不可变存储（glTexStorage2D）无法改变尺寸，需要重新创建纹理对象
+void GstOpenGLPlayer::allocate_plane_textures(const FrameLayout &layout)
+{
+    if (plane_textures_[0])
+        glDeleteTextures(MAX_VIDEO_PLANES, plane_textures_);
+    glGenTextures(MAX_VIDEO_PLANES, plane_textures_);
+    // 新纹理内容未定义，下一帧必须整帧上传
+    for (TileDiff &tiles : tile_diffs_)
+        tiles.reset();
+
+    for (int i = 0; i < MAX_VIDEO_PLANES; ++i)
+    {
+        glBindTexture(GL_TEXTURE_2D, plane_textures_[i]);
+
+        // 设置纹理参数
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        if (i >= layout.n_planes)
+            continue;
+
+        const PlaneLayout &plane = layout.planes[i];
+        if (gl_ext.texture_storage)
+            gl_ext.TexStorage2D(GL_TEXTURE_2D, 1, plane.internal_format, plane.width, plane.height);
+        else
+            glTexImage2D(GL_TEXTURE_2D, 0, plane.internal_format, plane.width, plane.height, 0, plane.gl_format, GL_UNSIGNED_BYTE, nullptr);
+        stats_.texture_allocations++;
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
-    has_new_frame_ = false;
+}
+
+// 创建持久映射的 GL 缓冲，并把它切成槽位交给上游缓冲池
+bool GstOpenGLPlayer::create_persistent_region()
+{
+    guint8 *base = nullptr;
+    size_t slot_bytes = (options_.persistent_slot_bytes + 255) & ~(size_t)255;
+    size_t total = slot_bytes * options_.persistent_slots;
+
+    if (gl_ext.buffer_storage && total > 0)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &persistent_buffer_);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, persistent_buffer_);
+        gl_ext.BufferStorage(GL_PIXEL_UNPACK_BUFFER, total, nullptr, flags);
+        base = (guint8 *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, total, flags);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (!base)
+        {
+            std::cerr << "Failed to map persistent buffer" << std::endl;
+            glDeleteBuffers(1, &persistent_buffer_);
+            persistent_buffer_ = 0;
+        }
+    }
+    if (!base)
+        std::cout << "Persistent mapping unavailable, buffer pool uses system memory" << std::endl;
+
+    persistent_region_ = gst_persistent_region_new(base, slot_bytes, options_.persistent_slots);
+    return base != nullptr;
+}
+
+void GstOpenGLPlayer::destroy_persistent_region()
+{
+    if (persistent_region_)
+    {
+        // 调用前管道（包括预热池中的）已经进入 NULL，解码器不再持有这些缓冲；
+        // 之后归还到上游缓冲池的旧缓冲会被丢弃，不会在解除映射后再被写入
+        guint in_use = gst_persistent_region_invalidate(persistent_region_);
+        if (in_use)
+            std::cerr << "Persistent region unmapped with " << in_use << " buffer(s) still in use" << std::endl;
+        gst_persistent_region_unref(persistent_region_);
+        persistent_region_ = nullptr;
+    }
+    if (persistent_buffer_)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, persistent_buffer_);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &persistent_buffer_);
+        persistent_buffer_ = 0;
+    }
+}
+
+// 零拷贝上传：直接从 GstBuffer 映射的内存上传，不经过中间副本
+void GstOpenGLPlayer::upload_from_sample(VideoFrame &frame)
+{
+    // 先回收 GPU 已经读取完毕的 sample
+    release_uploaded_samples(false);
+
+    // 从槽中取走 sample，槽回到 appsink 线程时不再持有引用
+    GstSample *sample = frame.sample;
+    frame.sample = nullptr;
+    if (!sample)
+        return;
+
+    // 描述由生产者线程按 caps 缓存，这里不再解析 caps
+    const VideoDescriptor &video = *frame.video;
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+
+    if (options_.upload == TextureUpload::GLMemory)
+    {
+        bind_gl_memory(sample, video);
+        return;
+    }
+
+    FrameLayout layout = video.layout;
+    gsize offset = 0;
+    if (persistent_buffer_ && gst_persistent_buffer_get_offset(buffer, &offset))
+    {
+        // 像素已经在持久映射的 GL 缓冲里：不映射、不拷贝，按 GstVideoMeta 的偏移和步长直接上传
+        GstVideoMeta *meta = gst_buffer_get_video_meta(buffer);
+        if (meta && !frame_layout_apply_planes(layout, meta->stride, meta->offset))
+        {
+            stats_.frames_rejected++;
+            gst_sample_unref(sample);
+            return;
+        }
+
+        ensure_textures(video);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, persistent_buffer_);
+        for (int i = 0; i < layout.n_planes; ++i)
+        {
+            size_t plane_offset = offset + layout.planes[i].offset;
+            upload_plane(i, layout.planes[i], (const void *)plane_offset, plane_offset);
+        }
+        reset_unpack_layout();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // GPU 读完之前 buffer 不能回到缓冲池
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        inflight_samples_.push_back({sample, fence});
+        stats_.persistent_uploads++;
+        stats_.zero_copy_uploads++;
+        stats_.frames_uploaded++;
+        return;
+    }
+
+    // 按 GstVideoMeta 映射，带填充的行不重新打包
+    GstVideoFrame vframe;
+    if (!gst_video_frame_map(&vframe, &video.info, buffer, GST_MAP_READ))
+    {
+        stats_.frames_rejected++;
+        gst_sample_unref(sample);
+        return;
+    }
+    if (!frame_layout_apply_planes(layout, vframe.info.stride, nullptr))
+    {
+        gst_video_frame_unmap(&vframe);
+        stats_.frames_rejected++;
+        gst_sample_unref(sample);
+        return;
+    }
+
+    const uint8_t *planes[MAX_VIDEO_PLANES] = {};
+    for (int i = 0; i < layout.n_planes; ++i)
+        planes[i] = (const uint8_t *)GST_VIDEO_FRAME_PLANE_DATA(&vframe, i);
+    ensure_textures(video);
+    bool referenced = upload_planes(planes, layout);
+    gst_video_frame_unmap(&vframe);
+
+    if (referenced)
+    {
+        // sample 的引用保留到上传栅栏完成为止
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        inflight_samples_.push_back({sample, fence});
+    }
+    else
+    {
+        // 数据已写入 PBO，buffer 可以立即归还
+        gst_sample_unref(sample);
+        stats_.samples_released++;
+    }
+
+    stats_.zero_copy_uploads++;
+    stats_.frames_uploaded++;
+}
+
+// 共享帧源：写端退出或重启时保留最后一帧（纹理不变），每 500ms 重连一次。
+// 取到的帧不拷贝，邮箱里只放环槽位的引用
+void GstOpenGLPlayer::pull_shared_frame()
+{
+    int timeout_ms = (int)GST_TIME_AS_MSECONDS(pull_timeout());
+    if (frame_ring_.connected() && frame_ring_.writer_gone())
+    {
+        std::cout << "Frame server disconnected, keeping the last frame" << std::endl;
+        // 共享源时生产和消费都在渲染线程上，三个槽位都可以在这里释放；
+        // 中间槽里还没上传的帧随旧映射一起作废
+        for (int i = 0; i < mailbox_.slot_count(); ++i)
+            frame_ring_.release(mailbox_.slot(i).shared);
+        frame_ring_.close();
+        ring_retry_ = std::chrono::steady_clock::now();
+    }
+    if (!frame_ring_.connected())
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now < ring_retry_ || !frame_ring_.connect(frame_ring_path_))
+        {
+            if (now >= ring_retry_)
+                ring_retry_ = now + std::chrono::milliseconds(500);
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return;
+        }
+        std::cout << "Connected to frame server " << frame_ring_path_ << std::endl;
+    }
+
+    // 与拉 sample 相同，最多等待一个刷新周期
+    if (!frame_ring_.wait_for_frame(timeout_ms))
+        return;
+    // 读端同一时刻只持有一个槽位：被覆盖、还没上传的帧先释放
+    VideoFrame &frame = mailbox_.back();
+    frame_ring_.release(frame.shared);
+    if (!frame_ring_.acquire_latest(frame.shared))
+        return;
+    stats_.frames_received++;
+
+    // caps 字符串只在重新协商时变化，变化时才重新解析
+    if (ring_caps_string_ != frame.shared.caps)
+    {
+        ring_caps_string_ = frame.shared.caps;
+        if (ring_caps_)
+            gst_caps_unref(ring_caps_);
+        ring_caps_ = gst_caps_from_string(ring_caps_string_.c_str());
+    }
+    frame.video = ring_caps_ ? descriptor_cache_.get(ring_caps_) : nullptr;
+    frame.running_time = frame.shared.info->pts >= 0 ? (GstClockTime)frame.shared.info->pts : GST_CLOCK_TIME_NONE;
+    if (!frame.video)
+    {
+        stats_.frames_rejected++;
+        frame_ring_.release(frame.shared);
+        return;
+    }
+    publish_frame(frame);
+}
+
+// 直接从共享映射上传，上传调用返回后 GL 不再读取客户端内存，槽位立即还给写端
+void GstOpenGLPlayer::upload_shared_frame(VideoFrame &frame)
+{
+    const SharedFrameInfo &info = *frame.shared.info;
+    const VideoDescriptor &video = *frame.video;
+    FrameLayout layout = video.layout;
+    gint strides[MAX_VIDEO_PLANES] = {};
+    gsize offsets[MAX_VIDEO_PLANES] = {};
+    bool valid = (int)info.n_planes == layout.n_planes && info.size <= frame_ring_.slot_size();
+    for (int i = 0; valid && i < layout.n_planes; ++i)
+    {
+        strides[i] = info.stride[i];
+        offsets[i] = (gsize)info.offset[i];
+    }
+    valid = valid && frame_layout_apply_planes(layout, strides, offsets);
+    for (int i = 0; valid && i < layout.n_planes; ++i)
+        valid = layout.planes[i].offset + layout.planes[i].span() <= info.size;
+    if (!valid)
+    {
+        stats_.frames_rejected++;
+        frame_ring_.release(frame.shared);
+        return;
+    }
+
+    const uint8_t *planes[MAX_VIDEO_PLANES] = {};
+    for (int i = 0; i < layout.n_planes; ++i)
+        planes[i] = frame.shared.data + layout.planes[i].offset;
+    ensure_textures(video);
+    upload_planes(planes, layout);
+    frame_ring_.release(frame.shared);
+    stats_.zero_copy_uploads++;
+    stats_.frames_uploaded++;
+}
+
+// GstGLMemory：纹理已由上游在共享上下文中生成，渲染线程只等待同步点并绑定纹理
+void GstOpenGLPlayer::bind_gl_memory(GstSample *sample, const VideoDescriptor &video)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstVideoFrame vframe;
+    if (!gst_video_frame_map(&vframe, &video.info, buffer, (GstMapFlags)(GST_MAP_READ | GST_MAP_GL)))
+    {
+        stats_.frames_rejected++;
+        gst_sample_unref(sample);
+        return;
+    }
+    // 以 GST_MAP_GL 映射时平面数据是纹理 ID，sample 持有期间纹理有效
+    GLuint texture = *(guint *)GST_VIDEO_FRAME_PLANE_DATA(&vframe, 0);
+    gst_video_frame_unmap(&vframe);
+
+    // 在本上下文中等待上游的 GL 命令完成，不阻塞 CPU
+    GstGLSyncMeta *sync_meta = gst_buffer_get_gl_sync_meta(buffer);
+    if (sync_meta)
+        gst_gl_sync_meta_wait(sync_meta, gl_bridge_.context());
+
+    // 上一帧的纹理已经提交绘制，栅栏完成后才把 buffer 还给上游
+    if (gl_sample_)
+    {
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        inflight_samples_.push_back({gl_sample_, fence});
+    }
+    gl_sample_ = sample;
+    gl_texture_ = texture;
+    if (video.generation != texture_generation_)
+    {
+        texture_generation_ = video.generation;
+        texture_layout_ = video.layout;
+        std::cout << "GL memory texture: " << texture_layout_.width << "x" << texture_layout_.height << std::endl;
+    }
+
+    stats_.gl_memory_frames++;
+    stats_.frames_uploaded++;
+}
+
+// 释放上传栅栏已完成的 sample，wait_all 为 true 时阻塞等待全部完成
+void GstOpenGLPlayer::release_uploaded_samples(bool wait_all)
+{
+    while (!inflight_samples_.empty())
+    {
+        InflightSample &front = inflight_samples_.front();
+        GLenum result = wait_all ? glClientWaitSync(front.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull)
+                                 : glClientWaitSync(front.fence, 0, 0);
+        if (!wait_all && result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(front.fence);
+        gst_sample_unref(front.sample);
+        stats_.samples_released++;
+        inflight_samples_.pop_front();
+    }
+}
+
+// 打印帧统计
+void GstOpenGLPlayer::print_stats()
+{
+    std::cout << "=== Frame statistics ===" << std::endl;
+    if (pipeline_timing_.elements > 0)
+    {
+        ElementFactoryCache &factories = ElementFactoryCache::instance();
+        std::cout << "Pipeline build:      " << pipeline_timing_.build_ms << " ms, " << pipeline_timing_.elements
+                  << " elements (" << factories.misses() << " factory lookups for " << factories.lookups()
+                  << " elements created)" << std::endl;
+        std::cout << "Preroll:             ";
+        if (pipeline_timing_.live)
+            std::cout << "live source" << std::endl;
+        else if (pipeline_timing_.preroll_ms >= 0.0)
+            std::cout << pipeline_timing_.preroll_ms << " ms" << std::endl;
+        else
+            std::cout << "not completed" << std::endl;
+    }
+    if (switch_stats_.switches > 0)
+        std::cout << "Source switches:     " << switch_stats_.switches << " (" << switch_stats_.warm << " pre-warmed, "
+                  << switch_stats_.prerolled << " already prerolled), avg "
+                  << switch_stats_.total_ms / switch_stats_.switches << " ms, max " << switch_stats_.max_ms
+                  << " ms to first frame" << std::endl;
+    if (switch_stats_.stale > 0)
+        std::cout << "Stale source frames: " << switch_stats_.stale << std::endl;
+    if (discovery_stats_.elapsed_ms > 0.0)
+        std::cout << "Media discovery:     " << discovery_stats_.elapsed_ms << " ms ("
+                  << (discovery_stats_.cached ? "cached" : "probed") << ")" << std::endl;
+    std::cout << "Frames received:     " << stats_.frames_received.load() << std::endl;
+    std::cout << "Frames uploaded:     " << stats_.frames_uploaded.load() << std::endl;
+    std::cout << "Intermediate copies: " << stats_.intermediate_copies.load()
+              << " (" << stats_.bytes_copied.load() << " bytes)" << std::endl;
+    std::cout << "Zero-copy uploads:   " << stats_.zero_copy_uploads.load() << std::endl;
+    std::cout << "Samples released:    " << stats_.samples_released.load() << std::endl;
+    std::cout << "Frames rejected:     " << stats_.frames_rejected.load() << std::endl;
+    std::cout << "Caps events:         " << stats_.caps_events.load()
+              << " (" << stats_.caps_changes.load() << " changes)" << std::endl;
+    std::cout << "Caps parses:         " << descriptor_cache_.parses()
+              << " (" << descriptor_cache_.generation() << " descriptors)" << std::endl;
+    std::cout << "Texture allocations: " << stats_.texture_allocations.load()
+              << (gl_ext.texture_storage ? " (immutable storage)" : " (glTexImage2D)") << std::endl;
+    if (options_.upload == TextureUpload::GLMemory)
+        std::cout << "GL memory frames:    " << stats_.gl_memory_frames.load() << std::endl;
+    std::cout << "Upload format:       " << (upload_format_ == GL_BGRA ? "BGRA" : "RGBA") << std::endl;
+    std::cout << "Video format:        " << gst_video_format_to_string(texture_layout_.format)
+              << (options_.native_yuv ? " (native YUV caps)" : " (RGBA caps)") << std::endl;
+    if (run_wall_seconds_ > 0.0)
+    {
+        std::cout << "Process CPU:         " << 100.0 * run_cpu_seconds_ / run_wall_seconds_
+                  << "% of one core over " << run_wall_seconds_ << " s" << std::endl;
+        std::cout << "Render thread CPU:   " << 100.0 * render_cpu_seconds_ / run_wall_seconds_ << "% ("
+                  << (options_.render_loop == RenderLoop::Event ? "event" : "poll") << " loop, "
+                  << present_stats_.wakeups << " wakeups)" << std::endl;
+    }
+    if (options_.upload_thread && run_wall_seconds_ > 0.0)
+    {
+        double uploads = stats_.frames_uploaded ? (double)stats_.frames_uploaded.load() : 1.0;
+        std::cout << "Upload thread:       avg " << 1e6 * upload_seconds_ / uploads << " us/frame, CPU "
+                  << 100.0 * upload_cpu_seconds_ / run_wall_seconds_ << "% of one core" << std::endl;
+    }
+    if (options_.pts_schedule)
+    {
+        const ScheduleStats &schedule = scheduler_.stats();
+        double presented = schedule.presented ? (double)schedule.presented : 1.0;
+        double mean = schedule.judder_sum_us / presented;
+        double variance = schedule.judder_sq_sum_us / presented - mean * mean;
+        std::cout << "Refresh period:      " << scheduler_.refresh_period_us() << " us (measured)" << std::endl;
+        std::cout << "Scheduled frames:    " << schedule.presented << " presented, " << schedule.waited
+                  << " waits, " << schedule.dropped_late << " dropped late" << std::endl;
+        std::cout << "Judder:              mean " << mean << " us, stddev " << std::sqrt(variance > 0.0 ? variance : 0.0)
+                  << " us, max " << schedule.judder_max_us << " us" << std::endl;
+    }
+    std::cout << "Swaps:               " << present_stats_.swaps
+              << " (" << present_stats_.expose_redraws << " expose/resize redraws)" << std::endl;
+    const ScalerStats &scaler = scaler_.stats();
+    if (scaler.gpu_samples > 0)
+        std::cout << "Scaler GPU time:     " << scale_filter_name(options_.scale_filter) << ", avg "
+                  << scaler.gpu_total_us / scaler.gpu_samples << " us, max " << scaler.gpu_max_us << " us ("
+                  << scaler.mipmap_generations << " mipmap generations, "
+                  << scaler.intermediate_allocations << " intermediate allocations)" << std::endl;
+    PacingSummary pacing = pacing_.summary();
+    std::cout << "Swap interval:       " << swap_interval_name(options_.swap_interval);
+    if (options_.swap_interval == SwapInterval::Adaptive && applied_swap_interval_ != -1)
+        std::cout << " (unsupported, using 1)";
+    std::cout << std::endl;
+    std::cout << "Refresh period:      " << pacing.refresh_period_us
+              << (applied_swap_interval_ != 0 ? " us (measured)" : " us (nominal)");
+    if (pacing.content_period_us > 0.0)
+        std::cout << ", content " << pacing.content_period_us << " us";
+    std::cout << std::endl;
+    std::cout << "Swap blocking:       avg " << pacing.swap_avg_us << " us, max " << pacing.swap_max_us << " us" << std::endl;
+    std::cout << "Missed vblanks:      " << pacing.missed_vblanks << std::endl;
+    std::cout << "Repeated frames:     " << pacing.repeated_frames << " of " << pacing.new_frames << " frames" << std::endl;
+    std::cout << "Vblanks per frame:   1:" << pacing.held_histogram[1] << " 2:" << pacing.held_histogram[2]
+              << " 3:" << pacing.held_histogram[3] << " 4:" << pacing.held_histogram[4]
+              << " 5+:" << pacing.held_histogram[5] << std::endl;
+    if (present_stats_.latency_samples > 0)
+        std::cout << "Arrival-to-swap:     avg " << present_stats_.latency_total_us / present_stats_.latency_samples
+                  << " us, max " << present_stats_.latency_max_us << " us" << std::endl;
+    FrameCounters counters = mailbox_.counters();
+    std::cout << "Frames produced:     " << counters.produced << std::endl;
+    std::cout << "Frames consumed:     " << counters.consumed << std::endl;
+    std::cout << "Frames overwritten:  " << counters.overwritten << std::endl;
+    if (persistent_region_)
+    {
+        guint64 gl_buffers = 0, system_buffers = 0;
+        gst_persistent_region_get_stats(persistent_region_, &gl_buffers, &system_buffers);
+        std::cout << "Persistent uploads:  " << stats_.persistent_uploads.load() << std::endl;
+        std::cout << "Pool buffers:        " << gl_buffers << " in GL memory, "
+                  << system_buffers << " in system memory" << std::endl;
+    }
+    if (options_.dirty_tiles && stats_.tile_frames > 0)
+    {
+        double planes = (double)stats_.tile_frames.load();
+        double tiles = stats_.tiles_total ? (double)stats_.tiles_total.load() : 1.0;
+        std::cout << "Changed tiles:       " << 100.0 * stats_.tiles_changed.load() / tiles << "% ("
+                  << stats_.tiles_changed.load() << " of " << stats_.tiles_total.load() << ")" << std::endl;
+        std::cout << "Upload bytes saved:  " << stats_.tile_bytes_saved.load() / planes << " bytes/plane/frame, "
+                  << stats_.tile_bytes_saved.load() << " total" << std::endl;
+    }
+    if (pbo_ring_.count() > 0)
+    {
+        const PboStats &pbo = pbo_ring_.stats();
+        double uploads = pbo.uploads ? (double)pbo.uploads : 1.0;
+        std::cout << "PBO ring depth:      " << pbo_ring_.count() << std::endl;
+        std::cout << "PBO uploads:         " << pbo.uploads
+                  << " (stalled " << pbo.stalled_uploads << ")" << std::endl;
+        std::cout << "Upload stall:        avg " << pbo.stall_total_us / uploads
+                  << " us/frame, max " << pbo.stall_max_us << " us" << std::endl;
+    }
+    if (!frame_ring_path_.empty())
+    {
+        const SharedReaderStats &ring = frame_ring_.reader_stats();
+        std::cout << "Shared frames:       " << ring.acquired << " acquired, " << ring.skipped << " skipped, "
+                  << ring.connections << " connections" << std::endl;
+        if (const SharedRingHeader *header = frame_ring_.header())
+            std::cout << "Frame server:        " << header->published.load() << " published, "
+                      << header->dropped.load() << " dropped by back-pressure" << std::endl;
+    }
+    if (net_clock_.active())
+    {
+        const PresentErrorStats &present = net_clock_.present_errors();
+        std::cout << "Network clock:       " << (net_clock_.is_master() ? "master" : "node") << " on port " << net_clock_.port()
+                  << ", offset " << net_clock_.offset_ms() << " ms" << std::endl;
+        if (present.frames)
+            std::cout << "Presentation error:  avg " << present.sum_ms / present.frames << " ms, max "
+                      << present.max_ms << " ms over " << present.frames << " frames" << std::endl;
+    }
 }
 void GstOpenGLPlayer::run()
 {
     if (!is_running_)
         return;
-    // 设置定时器更新显示
-    guint timer_id = g_timeout_add(1000 / 30, (GSourceFunc)update_display, this); // 30Hz更新
-    gst_element_set_state(pipeline_, GST_STATE_PLAYING);
-    std::cout << "Pipeline started" << std::endl;
+    // 设置定时器更新显示（共享帧源没有管道，也就没有叠加文字）
+    guint timer_id = 0;
+    if (pipeline_)
+    {
+        timer_id = g_timeout_add(1000 / 30, (GSourceFunc)update_display, this); // 30Hz更新
+        // 先预卷再播放，单独记录预卷耗时
+        GstStateChangeReturn preroll = PipelineBuilder::preroll(pipeline_, 10 * GST_SECOND, pipeline_timing_);
+        if (preroll == GST_STATE_CHANGE_SUCCESS)
+            std::cout << "Pipeline prerolled in " << pipeline_timing_.preroll_ms << " ms" << std::endl;
+        else if (preroll == GST_STATE_CHANGE_ASYNC)
+            std::cerr << "Pipeline did not preroll in time, starting anyway" << std::endl;
+        gst_element_set_state(pipeline_, GST_STATE_PLAYING);
+        std::cout << "Pipeline started" << std::endl;
+    }
     GMainLoop *loop = g_main_loop_new(NULL, FALSE);
     std::thread gst_loop_thread([loop]()
                                 { g_main_loop_run(loop); });
-    // 获取textoverlay元素
-    textoverlay = gst_bin_get_by_name(GST_BIN(pipeline_), "overlay");
-    while (is_running_ && !glfwWindowShouldClose(window_))
+    // 当前管道开始播放后再预热其余的源
+    warm_sources();
+    // 统计播放期间整个进程（解码、转换、上传）的 CPU 占用
+    scheduler_.reset((double)GST_TIME_AS_USECONDS(pull_timeout()), options_.late_drop_ms * 1000.0);
+    pacing_.reset((double)GST_TIME_AS_USECONDS(pull_timeout()), applied_swap_interval_);
+    double cpu_start = process_cpu_seconds();
+    double render_cpu_start = thread_cpu_seconds();
+    start_upload_thread();
+    auto wall_start = std::chrono::steady_clock::now();
+    while (is_running_ && !render_should_close())
     {
-        glfwPollEvents();
+        present_stats_.wakeups++;
+        process_switch();
+        if (options_.pts_schedule)
+        {
+            poll_events();
+            present_scheduled();
+            continue;
+        }
+        if (options_.delivery == SampleDelivery::Pull)
+        {
+            // 拉模式：最多等待一个刷新周期，拿到的帧直接放进邮箱
+            poll_events();
+            if (!frame_ring_path_.empty())
+            {
+                pull_shared_frame();
+            }
+            else
+            {
+                GstSample *sample = gst_app_sink_try_pull_sample(GST_APP_SINK(appsink_), pull_timeout());
+                if (sample)
+                    handle_sample(sample);
+            }
+        }
+        else if (options_.render_loop == RenderLoop::Event)
+        {
+            // 阻塞到新帧到达（appsink 线程 glfwPostEmptyEvent）或窗口事件；超时只为检查停止标志
+            wait_events(0.1);
+        }
+        else
+        {
+            poll_events();
+            // 小延迟以减少 CPU 使用率
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
         render_frame();
-        // 小延迟以减少 CPU 使用率
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
+    run_cpu_seconds_ = process_cpu_seconds() - cpu_start;
+    render_cpu_seconds_ = thread_cpu_seconds() - render_cpu_start;
+    stop_upload_thread();
+    run_wall_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
     // 清理
-    g_source_remove(timer_id);
-    gst_element_set_state(pipeline_, GST_STATE_NULL);
+    if (timer_id)
+        g_source_remove(timer_id);
+    if (pipeline_)
+        gst_element_set_state(pipeline_, GST_STATE_NULL);
+    print_stats();
+    if (!options_.headless_snapshot.empty() && !write_snapshot(options_.headless_snapshot))
+        std::cerr << "Failed to write snapshot " << options_.headless_snapshot << std::endl;
+    if (!options_.pacing_log.empty() && !pacing_.write_csv(options_.pacing_log))
+        std::cerr << "Failed to write pacing log " << options_.pacing_log << std::endl;
     g_main_loop_quit(loop);
     gst_loop_thread.join();
     g_main_loop_unref(loop);
 
-    stop();
+    shutdown();
+}
+
+// PTS 调度：渲染线程持有下一帧，直到离它的到期时间最近的 vblank 才提交
+void GstOpenGLPlayer::present_scheduled()
+{
+    if (!scheduled_sample_)
+    {
+        scheduled_sample_ = gst_app_sink_try_pull_sample(GST_APP_SINK(appsink_), pull_timeout());
+        if (!scheduled_sample_)
+        {
+            render_frame(); // 只处理暴露/尺寸变化的重绘
+            return;
+        }
+    }
+
+    auto now = FrameScheduler::Clock::now();
+    FrameScheduler::Clock::time_point due;
+    // 没有时间戳或时钟时立即显示
+    if (!sample_due_time(scheduled_sample_, now, due))
+        due = now;
+
+    switch (scheduler_.decide(due, now))
+    {
+    case FrameScheduler::Decision::Drop:
+        gst_sample_unref(scheduled_sample_);
+        scheduled_sample_ = nullptr;
+        break;
+    case FrameScheduler::Decision::Wait:
+        // 保持上一帧，睡到预测的下一次 vblank 再重新决定
+        render_frame();
+        std::this_thread::sleep_until(scheduler_.next_vblank(now));
+        break;
+    case FrameScheduler::Decision::Present:
+        scheduled_due_ = due;
+        has_scheduled_due_ = true;
+        handle_sample(scheduled_sample_);
+        scheduled_sample_ = nullptr;
+        render_frame(); // 交换落在预测的 vblank 上
+        break;
+    }
+}
+
+// 把 buffer PTS 映射到管道时钟，再换算成 steady_clock 上的到期时间
+bool GstOpenGLPlayer::sample_due_time(GstSample *sample, FrameScheduler::Clock::time_point now, FrameScheduler::Clock::time_point &due)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    const GstSegment *segment = gst_sample_get_segment(sample);
+    if (!buffer || !segment || !GST_BUFFER_PTS_IS_VALID(buffer))
+        return false;
+
+    GstClockTime running_time = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    GstClock *clock = gst_element_get_clock(pipeline_);
+    if (!GST_CLOCK_TIME_IS_VALID(running_time) || !clock)
+    {
+        if (clock)
+            gst_object_unref(clock);
+        return false;
+    }
+    GstClockTime clock_now = gst_clock_get_time(clock);
+    gst_object_unref(clock);
+
+    GstClockTime latency = gst_pipeline_get_latency(GST_PIPELINE(pipeline_));
+    if (!GST_CLOCK_TIME_IS_VALID(latency))
+        latency = 0;
+    GstClockTime clock_due = gst_element_get_base_time(pipeline_) + running_time + latency;
+    due = now + std::chrono::nanoseconds(GST_CLOCK_DIFF(clock_now, clock_due));
+    return true;
+}
+
+// 启动上传线程。初始的黑色纹理作为第一组交给渲染线程显示，之后各组纹理由上传线程按需分配
+void GstOpenGLPlayer::start_upload_thread()
+{
+    if (!options_.upload_thread)
+        return;
+
+    UploadedTextures &initial = uploaded_.front();
+    for (int i = 0; i < MAX_VIDEO_PLANES; ++i)
+    {
+        initial.textures[i] = plane_textures_[i];
+        plane_textures_[i] = 0;
+    }
+    initial.layout = texture_layout_;
+    initial.generation = texture_generation_;
+
+    // 主上下文必须先释放 GL 命令，共享上下文才能看到初始纹理
+    glFlush();
+    upload_running_ = true;
+    upload_thread_ = std::thread(&GstOpenGLPlayer::upload_thread_main, this);
+}
+
+void GstOpenGLPlayer::stop_upload_thread()
+{
+    if (!upload_thread_.joinable())
+        return;
+    upload_running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(upload_mutex_);
+    }
+    upload_cv_.notify_one();
+    upload_thread_.join();
+
+    // plane_textures_ 中是最后一组的副本，纹理由 uploaded_ 的槽释放
+    for (GLuint &texture : plane_textures_)
+        texture = 0;
+}
+
+void GstOpenGLPlayer::upload_thread_main()
+{
+    if (upload_offscreen_.valid())
+        upload_offscreen_.make_current();
+    else
+        glfwMakeContextCurrent(upload_window_);
+    double cpu_start = thread_cpu_seconds();
+
+    while (upload_running_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(upload_mutex_);
+            upload_cv_.wait_for(lock, std::chrono::milliseconds(100),
+                                [this]
+                                { return mailbox_.has_new() || !upload_running_; });
+        }
+        if (mailbox_.acquire())
+            upload_to_textures(uploaded_.back());
+        else
+            release_uploaded_samples(false);
+    }
+
+    // 退出前归还所有 sample，并确保上传命令执行完毕
+    release_uploaded_samples(true);
+    glFinish();
+    upload_cpu_seconds_ = thread_cpu_seconds() - cpu_start;
+    if (upload_offscreen_.valid())
+        upload_offscreen_.release_current();
+    else
+        glfwMakeContextCurrent(nullptr);
+}
+
+// 在上传线程上把 mailbox_ front 槽的帧上传到 target，完成后带栅栏发布给渲染线程。
+// 上传路径与渲染线程上传完全相同，只是临时把 target 换入 plane_textures_/texture_layout_
+void GstOpenGLPlayer::upload_to_textures(UploadedTextures &target)
+{
+    // 渲染线程对这组纹理的最后一次绘制完成前不能改写（GPU 端等待，不阻塞本线程）
+    if (target.released)
+    {
+        glWaitSync(target.released, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(target.released);
+        target.released = nullptr;
+    }
+    // 发布后被新帧覆盖、从未显示过的一组
+    if (target.ready)
+    {
+        glDeleteSync(target.ready);
+        target.ready = nullptr;
+    }
+
+    for (int i = 0; i < MAX_VIDEO_PLANES; ++i)
+        plane_textures_[i] = target.textures[i];
+    texture_layout_ = target.layout;
+    texture_generation_ = target.generation;
+
+    uint64_t uploaded_before = stats_.frames_uploaded;
+    auto start = std::chrono::steady_clock::now();
+    updateTextureData();
+    upload_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (int i = 0; i < MAX_VIDEO_PLANES; ++i)
+        target.textures[i] = plane_textures_[i];
+    target.layout = texture_layout_;
+    target.generation = texture_generation_;
+    // 被拒绝的帧不发布，渲染线程继续显示上一组
+    if (stats_.frames_uploaded == uploaded_before)
+        return;
+
+    const VideoFrame &frame = mailbox_.front();
+    target.arrival = frame.arrival;
+    target.running_time = frame.running_time;
+    target.source_generation = frame.source_generation;
+    target.content_period_us = frame.video && frame.video->info.fps_n > 0
+                                   ? 1e6 * frame.video->info.fps_d / frame.video->info.fps_n
+                                   : 0.0;
+    target.ready = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // 让栅栏对渲染上下文可见
+    glFlush();
+    uploaded_.publish();
+    if (options_.render_loop == RenderLoop::Event)
+        wake_render_loop();
+}
+
+// 设置交换间隔；adaptive 需要 WGL/GLX_EXT_swap_control_tear，不支持时退回垂直同步
+void GstOpenGLPlayer::apply_swap_interval()
+{
+    applied_swap_interval_ = (int)options_.swap_interval;
+    if (options_.swap_interval == SwapInterval::Adaptive &&
+        !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+        !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+    {
+        std::cerr << "Adaptive vsync is not supported, falling back to swap interval 1" << std::endl;
+        applied_swap_interval_ = 1;
+    }
+    glfwSwapInterval(applied_swap_interval_);
+}
+
+// 拉模式的等待时间：主显示器的一个刷新周期
+GstClockTime GstOpenGLPlayer::pull_timeout() const
+{
+    int refresh_rate = 60;
+    if (options_.headless)
+        return GST_SECOND / refresh_rate;
+    GLFWmonitor *monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode *mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    if (mode && mode->refreshRate > 0)
+        refresh_rate = mode->refreshRate;
+    return GST_SECOND / refresh_rate;
 }
 
 void GstOpenGLPlayer::stop()
+{
+    is_running_ = false;
+    wake_render_loop();
+}
+
+void GstOpenGLPlayer::shutdown()
 {
     is_running_ = false;
 
@@ -511,11 +2161,19 @@ void GstOpenGLPlayer::stop()
 
     // 清理 GStreamer 资源
     cleanup_pipeline();
+    net_clock_.stop();
 
     // 清理 OpenGL 资源
     cleanup_opengl();
 
-    // 销毁窗口
+    // 销毁离屏上下文（共享的先销毁）和窗口
+    upload_offscreen_.destroy();
+    offscreen_.destroy();
+    if (upload_window_)
+    {
+        glfwDestroyWindow(upload_window_);
+        upload_window_ = nullptr;
+    }
     if (window_)
     {
         glfwDestroyWindow(window_);
@@ -527,31 +2185,87 @@ void GstOpenGLPlayer::stop()
 
 void GstOpenGLPlayer::cleanup_pipeline()
 {
-    if (bus_)
+    descriptor_cache_.reset();
+    for (int i = 0; i < mailbox_.slot_count(); ++i)
+        frame_ring_.release(mailbox_.slot(i).shared);
+    frame_ring_.close();
+    if (ring_caps_)
     {
-        gst_object_unref(bus_);
-        bus_ = nullptr;
+        gst_caps_unref(ring_caps_);
+        ring_caps_ = nullptr;
     }
-
-    if (appsink_)
+    if (scheduled_sample_)
     {
-        gst_object_unref(appsink_);
-        appsink_ = nullptr;
+        gst_sample_unref(scheduled_sample_);
+        scheduled_sample_ = nullptr;
     }
 
-    if (pipeline_)
-    {
-        gst_object_unref(pipeline_);
-        pipeline_ = nullptr;
-    }
+    pipeline_pool_.clear();
+    GstElement *pipeline = detach_pipeline();
+    if (pipeline)
+        gst_object_unref(pipeline);
 }
 
 void GstOpenGLPlayer::cleanup_opengl()
 {
-    if (texture_id_)
+    // 释放尚在 GPU 上使用的 sample 和邮箱中未上传的 sample（窗口或 EGL 离屏上下文是当前上下文时才能等待栅栏）
+    if (window_ || offscreen_.valid())
+    {
+        if (gl_sample_)
+        {
+            inflight_samples_.push_back({gl_sample_, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+            gl_sample_ = nullptr;
+            gl_texture_ = 0;
+        }
+        release_uploaded_samples(true);
+    }
+    if (gl_sample_)
+    {
+        gst_sample_unref(gl_sample_);
+        gl_sample_ = nullptr;
+        gl_texture_ = 0;
+    }
+    for (int i = 0; i < mailbox_.slot_count(); ++i)
     {
-        glDeleteTextures(1, &texture_id_);
-        texture_id_ = 0;
+        VideoFrame &frame = mailbox_.slot(i);
+        if (frame.sample)
+        {
+            gst_sample_unref(frame.sample);
+            frame.sample = nullptr;
+        }
+    }
+
+    for (int i = 0; i < uploaded_.slot_count(); ++i)
+    {
+        UploadedTextures &set = uploaded_.slot(i);
+        if (set.textures[0])
+            glDeleteTextures(MAX_VIDEO_PLANES, set.textures);
+        if (set.ready)
+            glDeleteSync(set.ready);
+        if (set.released)
+            glDeleteSync(set.released);
+        set = UploadedTextures();
+    }
+
+    scaler_.destroy();
+    pbo_ring_.destroy();
+    destroy_persistent_region();
+    gl_bridge_.destroy();
+
+    if (plane_textures_[0])
+    {
+        glDeleteTextures(MAX_VIDEO_PLANES, plane_textures_);
+        for (GLuint &texture : plane_textures_)
+            texture = 0;
+    }
+
+    if (fbo_)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteTextures(1, &fbo_texture_);
+        fbo_ = 0;
+        fbo_texture_ = 0;
     }
 
     if (ebo_)
@@ -572,9 +2286,12 @@ void GstOpenGLPlayer::cleanup_opengl()
         vao_ = 0;
     }
 
-    if (shader_program_)
+    for (GLuint &program : shader_programs_)
     {
-        glDeleteProgram(shader_program_);
-        shader_program_ = 0;
+        if (program)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
     }
 }
@@ -7,39 +7,252 @@
 #include "GLFW/glfw3.h"
 #include "glad/glad.h"
 
+#include "DecoderSelection.hpp"
+#include "FrameMailbox.hpp"
+#include "FramePacing.hpp"
+#include "FrameScheduler.hpp"
+#include "GLContextBridge.hpp"
+#include "MediaDiscovery.hpp"
+#include "NetClockSync.hpp"
+#include "OffscreenContext.hpp"
+#include "PboRing.hpp"
+#include "PipelineBuilder.hpp"
+#include "PipelinePool.hpp"
+#include "SharedFrameRing.hpp"
+#include "StreamSync.hpp"
+#include "TileDiff.hpp"
+#include "VideoScaler.hpp"
+#include "VideoFormat.hpp"
+#include "gstpersistentpool.h"
+
 #include <iostream>
 #include <string>
 #include <thread>
 #include <chrono>
 #include <mutex>
 #include <vector>
+#include <deque>
+#include <atomic>
+#include <condition_variable>
+
+// 帧交接方式
+enum class FrameHandoff
+{
+    Copy,    // appsink 回调中 memcpy 到邮箱槽，渲染线程从副本上传
+    ZeroCopy // 持有 GstSample 引用，渲染线程直接从映射的 buffer 上传
+};
+
+// appsink 帧投递方式
+enum class SampleDelivery
+{
+    Signal,    // emit-signals + new-sample 信号
+    Callbacks, // gst_app_sink_set_callbacks，无 GObject 信号发射
+    Pull       // run() 按显示刷新周期 gst_app_sink_try_pull_sample
+};
+
+// 渲染循环方式
+enum class RenderLoop
+{
+    Poll, // glfwPollEvents + 每次循环 sleep 1ms（旧做法）
+    Event // 阻塞在 glfwWaitEventsTimeout，新帧到达时由 appsink 线程 glfwPostEmptyEvent 唤醒
+};
+
+// 纹理上传方式
+enum class TextureUpload
+{
+    Direct,        // glTexSubImage2D 直接读取客户端内存
+    Pbo,           // 经过带栅栏的 PBO 环异步上传
+    PersistentPool, // 向上游提供持久映射 GL 内存的缓冲池，解码/转换直接写入 GPU 可见内存
+    GLMemory        // glupload/glcolorconvert 在共享上下文中生成纹理，渲染线程直接绑定 GstGLMemory
+};
+
+// 播放器选项
+struct PlayerOptions
+{
+    FrameHandoff handoff = FrameHandoff::Copy;
+    SampleDelivery delivery = SampleDelivery::Signal;
+    TextureUpload upload = TextureUpload::Direct;
+    RenderLoop render_loop = RenderLoop::Event;
+    // 按 PTS 调度呈现：渲染线程拉取帧（appsink 不丢帧、不同步），在离到期时间最近的 vblank 提交
+    bool pts_schedule = false;
+    double late_drop_ms = -1.0; // 在下一次 vblank 时迟到超过该值的帧被丢弃，< 0 表示从不丢帧
+    SwapInterval swap_interval = SwapInterval::Vsync;
+    std::string pacing_log; // 非空时退出前把每次交换的记录写成 CSV
+    int pbo_count = 3; // PBO 环深度，1080p 通常 2~3，4K 可适当加大
+    // 持久映射区域：槽位数与每个槽位的大小，放不下的帧退回系统内存
+    int persistent_slots = 6;
+    size_t persistent_slot_bytes = 1920 * 1080 * 4;
+    // appsink 直接接受 NV12/I420/YUY2，颜色转换在着色器中完成；false 时只协商 RGBA/BGRA
+    bool native_yuv = true;
+    // 脏块上传：与上一帧按块比较，只上传变化的块（适合屏幕采集等大部分静止的画面，仅直接上传模式）
+    bool dirty_tiles = false;
+    int tile_size = 64;
+    // 上传线程：在共享 GL 上下文中上传，渲染线程只等待栅栏并绘制（不适用于 GstGLMemory 与 PTS 调度）
+    bool upload_thread = false;
+    // 无窗口模式：EGL surfaceless/pbuffer 上下文（没有 EGL 时用不可见窗口），渲染到 FBO，其余路径不变
+    bool headless = false;
+    int headless_frames = 0;       // 呈现这么多帧后退出，0 表示播放到结束
+    std::string headless_snapshot; // 非空时退出前把 FBO 内容写成 PPM
+    // GPU 缩放档位；keep_aspect 为 false 时拉伸铺满窗口
+    ScaleFilter scale_filter = ScaleFilter::Bilinear;
+    bool keep_aspect = true;
+    // 多机电视墙：每个节点只显示源画面的 crop 区域，按该区域的宽高比放进窗口
+    CropRect crop;
+    // 网络时钟：net_clock_port > 0 时作为主节点在该端口发布管道时钟；
+    // net_clock 为 "host:port" 时作为从节点跟随主节点，base time 使用主节点启动时打印的值
+    int net_clock_port = 0;
+    std::string net_clock;
+    GstClockTime net_base_time = GST_CLOCK_TIME_NONE;
+    // 可切换的源：启动后构建并预卷到 PAUSED 放进管道池，切换时只交换管道，窗口和 GL 资源保留。
+    // 使用网络时钟时不能切换（新源无法对齐到共同的 base time），预热源被忽略
+    std::vector<std::string> prewarm_sources;
+    int pipeline_pool_size = 2;   // 池中最多同时预热的管道数（每条都占着解码器和预卷的帧）
+    int switch_every_frames = 0;  // > 0 时每个源显示这么多帧后切到下一个（无窗口测量切换耗时）
+};
+
+// 帧统计（跨线程读写，全部使用原子计数）
+struct FrameStats
+{
+    std::atomic<uint64_t> frames_received{0};     // appsink 收到的帧数
+    std::atomic<uint64_t> frames_uploaded{0};     // 上传到纹理的帧数
+    std::atomic<uint64_t> intermediate_copies{0}; // 拷贝到邮箱槽的次数
+    std::atomic<uint64_t> bytes_copied{0};        // 拷贝到邮箱槽的字节数
+    std::atomic<uint64_t> zero_copy_uploads{0};   // 直接从 GstBuffer 上传的帧数
+    std::atomic<uint64_t> samples_released{0};    // 上传栅栏完成后释放的 sample 数
+    std::atomic<uint64_t> persistent_uploads{0};  // 直接从持久映射缓冲上传的帧数
+    std::atomic<uint64_t> frames_rejected{0};     // 格式或大小不符被丢弃的帧数
+    std::atomic<uint64_t> gl_memory_frames{0};    // 直接绑定 GstGLMemory 纹理的帧数
+    std::atomic<uint64_t> texture_allocations{0}; // 纹理存储分配次数（含初始分配）
+    std::atomic<uint64_t> caps_events{0};         // appsink 收到的 caps 事件数
+    std::atomic<uint64_t> caps_changes{0};        // GstVideoInfo 实际发生变化的次数
+    std::atomic<uint64_t> tile_frames{0};         // 经过脏块比较的平面数
+    std::atomic<uint64_t> tiles_total{0};         // 比较的块总数
+    std::atomic<uint64_t> tiles_changed{0};       // 发生变化并上传的块数
+    std::atomic<uint64_t> tile_bytes_saved{0};    // 因块未变化而省去的上传字节数
+};
+
+// 渲染线程的呈现统计（只在渲染线程读写）
+struct PresentStats
+{
+    uint64_t swaps = 0;             // glfwSwapBuffers 次数
+    uint64_t expose_redraws = 0;    // 没有新帧、因暴露或尺寸变化而重绘的次数
+    uint64_t wakeups = 0;           // 渲染循环醒来的次数
+    uint64_t latency_samples = 0;
+    double latency_total_us = 0.0;  // 帧放入邮箱到交换完成
+    double latency_max_us = 0.0;
+};
+
+// 邮箱中传递的一帧
+struct VideoFrame
+{
+    GstSample *sample = nullptr; // 零拷贝模式持有的 sample 引用
+    std::shared_ptr<const VideoDescriptor> video; // 本帧所属协商的描述，由生产者线程从缓存取得
+    std::vector<uint8_t> data;   // 拷贝模式的像素数据（各平面依次存放，保留原始步长）
+    FrameLayout layout;          // 平面偏移相对 data 起点
+    std::chrono::steady_clock::time_point arrival; // 放入邮箱的时间，用于统计呈现延迟
+    GstClockTime running_time = GST_CLOCK_TIME_NONE; // 帧的运行时间，网络时钟模式下统计呈现误差
+    SharedFrameView shared;      // 共享帧源：读端持有的环槽位，上传后立即释放
+    uint64_t source_generation = 0; // 产生该帧的管道（每次切换源加一），区分切换前留下的旧帧
+};
+
+// 上传线程交给渲染线程的一组纹理（纹理邮箱的槽）
+struct UploadedTextures
+{
+    GLuint textures[MAX_VIDEO_PLANES] = {};
+    FrameLayout layout;
+    uint64_t generation = 0;
+    GLsync ready = nullptr;    // 上传命令的栅栏，渲染线程在 GPU 端等待
+    GLsync released = nullptr; // 渲染线程最后一次绘制的栅栏，上传线程改写前在 GPU 端等待
+    std::chrono::steady_clock::time_point arrival;
+    double content_period_us = 0.0;
+    GstClockTime running_time = GST_CLOCK_TIME_NONE;
+    uint64_t source_generation = 0;
+};
+
 class GstOpenGLPlayer
 {
 
 public:
     GstOpenGLPlayer(int width = 800, int height = 600);
     ~GstOpenGLPlayer();
-    bool initialize(const std::string &video_source = "");
+    bool initialize(const std::string &video_source = "", const PlayerOptions &options = PlayerOptions());
     void run();
+    // 请求停止（任意线程，包括总线回调）：只置标志并唤醒渲染线程，清理在 run() 退出循环后进行
     void stop();
+    // 切换到另一个源（任意线程调用），在池中预热过的源不需要重新构建和预卷
+    void switch_source(const std::string &source);
+    // 帧邮箱计数：生产、消费、覆盖
+    FrameCounters frame_counters() const { return mailbox_.counters(); }
+    // 切换统计（渲染线程写，run() 返回后读取）
+    const SwitchStats &switch_stats() const { return switch_stats_; }
 
 private:
     // GStreamer 回调
     static GstFlowReturn new_sample_callback(GstElement *sink, gpointer data);
+    static GstFlowReturn appsink_new_sample(GstAppSink *sink, gpointer data);
+    static GstPadProbeReturn allocation_query_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+    static GstPadProbeReturn caps_event_probe(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+    void handle_sample(GstSample *sample);
+    GstClockTime pull_timeout() const;
     static gboolean bus_callback(GstBus *bus, GstMessage *msg, gpointer data);
+    static GstBusSyncReply bus_sync_handler(GstBus *bus, GstMessage *msg, gpointer data);
     static void update_display(gpointer app);
     void update_overlay_text();
     void calculate_fps();
-    bool create_window();
+    bool create_window(bool visible = true);
+    bool create_offscreen();
+    bool create_render_target();
+    bool write_snapshot(const std::string &path);
+    // 渲染循环与窗口系统之间的几处交互，无窗口时改用条件变量
+    bool render_should_close();
+    void poll_events();
+    void wait_events(double timeout_seconds);
+    void wake_render_loop();
+    void apply_swap_interval();
+    static void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+    static void window_refresh_callback(GLFWwindow *window);
+    static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
     // OpenGL 相关
     bool init_opengl();
     void render_frame();
+    void publish_frame(VideoFrame &frame);
+    void present_scheduled();
+    bool sample_due_time(GstSample *sample, FrameScheduler::Clock::time_point now, FrameScheduler::Clock::time_point &due);
     void cleanup_opengl();
 
     // GStreamer 相关
     bool create_pipeline(const std::string &source);
+    GstElement *build_pipeline(const std::string &source, PipelineTiming &timing);
+    void attach_pipeline(GstElement *pipeline);
+    GstElement *detach_pipeline();
+    // 源切换
+    void warm_sources();
+    const std::string &adjacent_source(int offset) const;
+    void process_switch();
+    bool switch_pipeline(const std::string &source, std::chrono::steady_clock::time_point requested_at);
+    void source_presented(uint64_t generation, std::chrono::steady_clock::time_point swap_end);
+    bool setup_net_clock();
     void cleanup_pipeline();
+    // 释放管道、GL 资源、上下文和窗口（渲染线程上，run() 结束或析构时）
+    void shutdown();
     void updateTextureData();
+    void upload_from_sample(VideoFrame &frame);
+    void pull_shared_frame();
+    void upload_shared_frame(VideoFrame &frame);
+    void bind_gl_memory(GstSample *sample, const VideoDescriptor &video);
+    bool upload_planes(const uint8_t *const planes[], const FrameLayout &layout);
+    void upload_plane(int index, const PlaneLayout &plane, const void *pixels, size_t address);
+    void upload_plane_tiles(int index, const PlaneLayout &plane, const uint8_t *pixels);
+    void ensure_textures(const VideoDescriptor &video);
+    void allocate_plane_textures(const FrameLayout &layout);
+    bool create_persistent_region();
+    void destroy_persistent_region();
+    void release_uploaded_samples(bool wait_all);
+    void start_upload_thread();
+    void stop_upload_thread();
+    void upload_thread_main();
+    void upload_to_textures(UploadedTextures &target);
+    void print_stats();
     // opengl渲染测试
     void createTestImage();
 
@@ -47,31 +260,134 @@ private:
     int window_width_;
     int window_height_;
 
-    // GLFW 窗口
+    // GLFW 窗口（EGL 无窗口模式下为空）
     GLFWwindow *window_;
+    // 无窗口模式：EGL 上下文（上传线程另有一个共享上下文）和渲染目标 FBO
+    OffscreenContext offscreen_;
+    OffscreenContext upload_offscreen_;
+    GLuint fbo_;
+    GLuint fbo_texture_;
+    // 当前绘制目标的尺寸（窗口的帧缓冲像素或离屏 FBO），只由渲染线程读写
+    int framebuffer_width_;
+    int framebuffer_height_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
 
     // OpenGL 资源
     GLuint vao_;
     GLuint vbo_;
     GLuint ebo_;
-    GLuint shader_program_;
-    GLuint texture_id_;
+    GLuint shader_programs_[(int)VideoShader::Count]; // 每种像素格式一个着色器变体
+    GLuint plane_textures_[MAX_VIDEO_PLANES];          // 各平面的纹理，依次绑定到纹理单元 0/1/2
+    VideoScaler scaler_;                               // 颜色转换之后的缩放阶段
 
     // 纹理参数
+    FrameLayout texture_layout_;  // 当前纹理对应的帧布局，决定着色器与颜色矩阵
+    uint64_t texture_generation_; // texture_layout_ 来自哪一次协商
     int texture_width_;
     int texture_height_;
+    GLenum upload_format_; // 驱动偏好的上传格式，决定 appsink 的协商顺序
+    // 生产者线程的 caps -> 描述缓存，每次协商只解析一次 caps
+    VideoDescriptorCache descriptor_cache_;
+    // 最近一次协商的视频信息（只在流线程的 caps 事件探针中访问）
+    GstVideoInfo negotiated_info_;
+    bool has_negotiated_info_;
     std::vector<uint8_t> texture_data_;
-    std::mutex texture_mutex_;
+
+    // appsink 线程与渲染线程之间的帧邮箱
+    FrameMailbox<VideoFrame> mailbox_;
+
+    // 零拷贝：已上传但 GPU 尚未完成读取的 sample
+    struct InflightSample
+    {
+        GstSample *sample;
+        GLsync fence;
+    };
+    std::deque<InflightSample> inflight_samples_;
+
+    // GstGLMemory：与管道共享的 GL 上下文，以及当前正在显示的 sample 和它的纹理
+    GLContextBridge gl_bridge_;
+    GstSample *gl_sample_;
+    GLuint gl_texture_;
+
+    // 脏块上传：每个平面保存上一帧副本
+    TileDiff tile_diffs_[MAX_VIDEO_PLANES];
+
+    // 异步上传用的 PBO 环
+    PboRing pbo_ring_;
+
+    // 持久映射的 GL 缓冲及其槽位区域（提供给上游缓冲池）
+    GLuint persistent_buffer_;
+    GstPersistentRegion *persistent_region_;
 
     // GStreamer 资源
     GstElement *pipeline_;
     GstElement *appsink_;
     GstBus *bus_;
+    PipelineTiming pipeline_timing_; // 管道构建与预卷耗时，启动变慢时在统计中可见
+    DiscoveryStats discovery_stats_; // 本地文件的探测耗时（是否命中缓存）
+    // 多机同步时共用的网络时钟
+    NetClockSync net_clock_;
+    // 共享帧源（"shm:PATH"）：由 FrameServer 进程解码，本进程只映射帧环上传，没有管道
+    SharedFrameRing frame_ring_;
+    std::string frame_ring_path_;
+    GstCaps *ring_caps_; // 最近一帧 caps 字符串解析的结果，交给描述缓存
+    std::string ring_caps_string_;
+    std::chrono::steady_clock::time_point ring_retry_; // 写端不在时下一次重连的时间
     gint64 duration_ns;
     gdouble current_fps;
     GstElement *textoverlay;
 
-    // 控制标志
-    bool is_running_;
-    bool has_new_frame_;
+    // 选项与统计
+    PlayerOptions options_;
+    FrameStats stats_;
+
+    // 播放期间的进程 CPU 占用
+    double run_cpu_seconds_;
+    double run_wall_seconds_;
+
+    // 渲染循环：暴露/尺寸变化后需要重绘
+    bool redraw_pending_;
+    PresentStats present_stats_;
+    double render_cpu_seconds_; // 渲染线程本身的 CPU 时间
+    FramePacing pacing_;
+    int applied_swap_interval_; // 实际设置的交换间隔（不支持 adaptive 时退回 1）
+
+    // PTS 调度：等待提交的下一帧及当前帧的期望显示时间
+    FrameScheduler scheduler_;
+    GstSample *scheduled_sample_;
+    FrameScheduler::Clock::time_point scheduled_due_;
+    bool has_scheduled_due_;
+
+    // 上传线程：共享上下文（不可见窗口）、交给渲染线程的纹理邮箱和唤醒
+    GLFWwindow *upload_window_;
+    std::thread upload_thread_;
+    std::atomic<bool> upload_running_;
+    std::mutex upload_mutex_;
+    std::condition_variable upload_cv_;
+    FrameMailbox<UploadedTextures> uploaded_;
+    double upload_seconds_;     // 上传线程的上传耗时（线程结束后读取）
+    double upload_cpu_seconds_; // 上传线程的 CPU 时间
+
+    // 源切换：预热管道池、可切换的源和切换请求；pipeline_mutex_ 保护切换时替换的 pipeline_ 与 textoverlay
+    // （叠加文字定时器在 GLib 主循环线程中读取）
+    PipelinePool pipeline_pool_;
+    std::string current_source_;
+    std::vector<std::string> sources_;
+    std::mutex pipeline_mutex_;
+    std::mutex switch_mutex_;
+    std::string requested_source_;
+    std::chrono::steady_clock::time_point requested_at_;
+    std::atomic<uint64_t> source_generation_; // 生产者线程给每帧打上，渲染线程据此识别新源的第一帧
+    // 进行中的切换（只在渲染线程读写）
+    uint64_t presented_generation_; // 最近一次上屏的帧所属的源
+    bool switch_pending_;
+    std::chrono::steady_clock::time_point switch_start_;
+    bool switch_warm_;
+    bool switch_prerolled_;
+    int frames_since_switch_;
+    SwitchStats switch_stats_;
+
+    // 控制标志（渲染线程读，总线回调和其他线程写）
+    std::atomic<bool> is_running_;
 };
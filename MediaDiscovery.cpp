@@ -0,0 +1,189 @@
+#include "MediaDiscovery.hpp"
+#include "gst/pbutils/pbutils.h"
+
+#include <glib/gstdio.h>
+
+#include <chrono>
+#include <iostream>
+
+// 探测一个文件的上限
+#define DISCOVERY_TIMEOUT (5 * GST_SECOND)
+// 缓存字段变化时加一，旧缓存整体作废
+#define DISCOVERY_CACHE_VERSION 1
+
+std::string MediaDiscoveryCache::default_path()
+{
+    gchar *path = g_build_filename(g_get_user_cache_dir(), "gst-opengl-player", "discovery.ini", nullptr);
+    std::string result = path;
+    g_free(path);
+    return result;
+}
+
+MediaDiscoveryCache::MediaDiscoveryCache(const std::string &cache_path)
+    : cache_path_(cache_path), keys_(g_key_file_new())
+{
+    // 没有缓存文件是正常情况
+    if (g_key_file_load_from_file(keys_, cache_path_.c_str(), G_KEY_FILE_NONE, nullptr) &&
+        g_key_file_get_integer(keys_, "cache", "version", nullptr) != DISCOVERY_CACHE_VERSION)
+    {
+        g_key_file_free(keys_);
+        keys_ = g_key_file_new();
+    }
+}
+
+MediaDiscoveryCache::~MediaDiscoveryCache()
+{
+    g_key_file_free(keys_);
+}
+
+bool MediaDiscoveryCache::lookup(const std::string &file, MediaInfo &info)
+{
+    auto start = std::chrono::steady_clock::now();
+    stats_ = DiscoveryStats();
+
+    gchar *absolute = g_canonicalize_filename(file.c_str(), nullptr);
+    GStatBuf st;
+    if (g_stat(absolute, &st) != 0)
+    {
+        std::cerr << "Cannot open " << file << std::endl;
+        g_free(absolute);
+        return false;
+    }
+    // 每个文件一组，组名是路径的摘要（路径可能含有 GKeyFile 组名不允许的字符）
+    gchar *group = g_compute_checksum_for_string(G_CHECKSUM_SHA1, absolute, -1);
+    gint64 mtime = (gint64)st.st_mtime;
+    gint64 size = (gint64)st.st_size;
+
+    gchar *cached_path = g_key_file_get_string(keys_, group, "path", nullptr);
+    bool hit = cached_path && g_strcmp0(cached_path, absolute) == 0 &&
+               g_key_file_get_int64(keys_, group, "mtime", nullptr) == mtime &&
+               g_key_file_get_int64(keys_, group, "size", nullptr) == size;
+    g_free(cached_path);
+
+    bool ok = true;
+    if (hit)
+    {
+        info = MediaInfo();
+        gchar *container_caps = g_key_file_get_string(keys_, group, "container-caps", nullptr);
+        gchar *video_caps = g_key_file_get_string(keys_, group, "video-caps", nullptr);
+        info.container_caps = container_caps ? container_caps : "";
+        info.video_caps = video_caps ? video_caps : "";
+        g_free(container_caps);
+        g_free(video_caps);
+        info.width = g_key_file_get_integer(keys_, group, "width", nullptr);
+        info.height = g_key_file_get_integer(keys_, group, "height", nullptr);
+        info.fps_n = g_key_file_get_integer(keys_, group, "fps-n", nullptr);
+        info.fps_d = g_key_file_get_integer(keys_, group, "fps-d", nullptr);
+        info.has_video = g_key_file_get_boolean(keys_, group, "has-video", nullptr);
+        info.has_audio = g_key_file_get_boolean(keys_, group, "has-audio", nullptr);
+        info.duration = g_key_file_get_uint64(keys_, group, "duration", nullptr);
+        stats_.cached = true;
+    }
+    else
+    {
+        gchar *uri = gst_filename_to_uri(absolute, nullptr);
+        ok = uri && probe(uri, info);
+        g_free(uri);
+        if (ok)
+        {
+            g_key_file_set_integer(keys_, "cache", "version", DISCOVERY_CACHE_VERSION);
+            g_key_file_set_string(keys_, group, "path", absolute);
+            g_key_file_set_int64(keys_, group, "mtime", mtime);
+            g_key_file_set_int64(keys_, group, "size", size);
+            g_key_file_set_string(keys_, group, "container-caps", info.container_caps.c_str());
+            g_key_file_set_string(keys_, group, "video-caps", info.video_caps.c_str());
+            g_key_file_set_integer(keys_, group, "width", info.width);
+            g_key_file_set_integer(keys_, group, "height", info.height);
+            g_key_file_set_integer(keys_, group, "fps-n", info.fps_n);
+            g_key_file_set_integer(keys_, group, "fps-d", info.fps_d);
+            g_key_file_set_boolean(keys_, group, "has-video", info.has_video);
+            g_key_file_set_boolean(keys_, group, "has-audio", info.has_audio);
+            g_key_file_set_uint64(keys_, group, "duration", info.duration);
+            save();
+        }
+    }
+
+    g_free(group);
+    g_free(absolute);
+    stats_.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+bool MediaDiscoveryCache::probe(const std::string &uri, MediaInfo &info)
+{
+    GError *error = nullptr;
+    GstDiscoverer *discoverer = gst_discoverer_new(DISCOVERY_TIMEOUT, &error);
+    if (!discoverer)
+    {
+        std::cerr << "Failed to create discoverer: " << (error ? error->message : "unknown error") << std::endl;
+        if (error)
+            g_error_free(error);
+        return false;
+    }
+
+    GstDiscovererInfo *result = gst_discoverer_discover_uri(discoverer, uri.c_str(), &error);
+    bool ok = result && gst_discoverer_info_get_result(result) == GST_DISCOVERER_OK;
+    if (!ok)
+        std::cerr << "Failed to discover " << uri << ": " << (error ? error->message : "unknown error") << std::endl;
+    if (ok)
+    {
+        info = MediaInfo();
+        info.duration = gst_discoverer_info_get_duration(result);
+        GstDiscovererStreamInfo *top = gst_discoverer_info_get_stream_info(result);
+        GstCaps *caps = top ? gst_discoverer_stream_info_get_caps(top) : nullptr;
+        if (caps)
+        {
+            gchar *caps_string = gst_caps_to_string(caps);
+            info.container_caps = caps_string;
+            g_free(caps_string);
+            gst_caps_unref(caps);
+        }
+        if (top)
+            gst_discoverer_stream_info_unref(top);
+
+        GList *videos = gst_discoverer_info_get_video_streams(result);
+        if (videos)
+        {
+            GstDiscovererVideoInfo *video = (GstDiscovererVideoInfo *)videos->data;
+            info.has_video = true;
+            info.width = (int)gst_discoverer_video_info_get_width(video);
+            info.height = (int)gst_discoverer_video_info_get_height(video);
+            info.fps_n = (int)gst_discoverer_video_info_get_framerate_num(video);
+            info.fps_d = (int)gst_discoverer_video_info_get_framerate_denom(video);
+            caps = gst_discoverer_stream_info_get_caps((GstDiscovererStreamInfo *)video);
+            if (caps)
+            {
+                gchar *caps_string = gst_caps_to_string(caps);
+                info.video_caps = caps_string;
+                g_free(caps_string);
+                gst_caps_unref(caps);
+            }
+        }
+        gst_discoverer_stream_info_list_free(videos);
+        GList *audios = gst_discoverer_info_get_audio_streams(result);
+        info.has_audio = audios != nullptr;
+        gst_discoverer_stream_info_list_free(audios);
+    }
+
+    if (result)
+        gst_discoverer_info_unref(result);
+    if (error)
+        g_error_free(error);
+    g_object_unref(discoverer);
+    return ok;
+}
+
+bool MediaDiscoveryCache::save()
+{
+    gchar *directory = g_path_get_dirname(cache_path_.c_str());
+    g_mkdir_with_parents(directory, 0755);
+    g_free(directory);
+    GError *error = nullptr;
+    if (!g_key_file_save_to_file(keys_, cache_path_.c_str(), &error))
+    {
+        std::cerr << "Failed to write discovery cache " << cache_path_ << ": " << error->message << std::endl;
+        g_error_free(error);
+        return false;
+    }
+    return true;
+}
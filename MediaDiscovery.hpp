@@ -0,0 +1,51 @@
+#pragma once
+#include "gst/gst.h"
+
+#include <string>
+
+// 一个媒体文件的探测结果：容器与第一路视频的 caps、有没有音频、时长
+struct MediaInfo
+{
+    std::string container_caps; // 顶层 caps（如 video/quicktime），基本流时就是视频 caps
+    std::string video_caps;
+    int width = 0;
+    int height = 0;
+    int fps_n = 0;
+    int fps_d = 1;
+    bool has_video = false;
+    bool has_audio = false;
+    GstClockTime duration = GST_CLOCK_TIME_NONE;
+};
+
+// 探测统计
+struct DiscoveryStats
+{
+    bool cached = false;    // 最近一次结果来自缓存
+    double elapsed_ms = 0.0; // 最近一次查询的耗时（命中时只有读缓存）
+};
+
+// GstDiscoverer 结果的持久缓存，按 绝对路径 + mtime + 大小 区分文件：文件没有变化时直接返回上次的结果，
+// 不再为了选择分离器和音频分支而 typefind、预卷一遍。缓存是用户缓存目录下的一个 GKeyFile
+class MediaDiscoveryCache
+{
+public:
+    explicit MediaDiscoveryCache(const std::string &cache_path = default_path());
+    ~MediaDiscoveryCache();
+
+    MediaDiscoveryCache(const MediaDiscoveryCache &) = delete;
+    MediaDiscoveryCache &operator=(const MediaDiscoveryCache &) = delete;
+
+    // 取本地文件的媒体信息，缓存没有或文件已变化时探测并写回缓存
+    bool lookup(const std::string &file, MediaInfo &info);
+    const DiscoveryStats &stats() const { return stats_; }
+
+    static std::string default_path();
+
+private:
+    static bool probe(const std::string &uri, MediaInfo &info);
+    bool save();
+
+    std::string cache_path_;
+    GKeyFile *keys_;
+    DiscoveryStats stats_;
+};
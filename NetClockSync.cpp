@@ -0,0 +1,116 @@
+#include "NetClockSync.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+NetClockSync::NetClockSync()
+    : clock_(nullptr), provider_(nullptr), base_time_(GST_CLOCK_TIME_NONE), port_(0)
+{
+}
+
+NetClockSync::~NetClockSync()
+{
+    stop();
+}
+
+bool NetClockSync::serve(int port, GstClockTime start_delay)
+{
+    stop();
+    clock_ = gst_system_clock_obtain();
+    provider_ = gst_net_time_provider_new(clock_, nullptr, port);
+    if (!provider_)
+    {
+        std::cerr << "Failed to publish network clock on port " << port << std::endl;
+        stop();
+        return false;
+    }
+    g_object_get(provider_, "port", &port_, nullptr);
+    // 留出启动从节点并完成第一次同步的时间
+    base_time_ = gst_clock_get_time(clock_) + start_delay;
+    return true;
+}
+
+bool NetClockSync::follow(const std::string &address, int port, GstClockTime base_time, GstClockTime timeout)
+{
+    stop();
+    if (!GST_CLOCK_TIME_IS_VALID(base_time))
+    {
+        std::cerr << "Network clock needs the base time chosen by the master" << std::endl;
+        return false;
+    }
+    clock_ = gst_net_client_clock_new("net_clock", address.c_str(), port, 0);
+    if (!clock_)
+    {
+        std::cerr << "Failed to create network clock for " << address << ":" << port << std::endl;
+        return false;
+    }
+    if (!gst_clock_wait_for_sync(clock_, timeout))
+    {
+        std::cerr << "Network clock " << address << ":" << port << " did not synchronize" << std::endl;
+        stop();
+        return false;
+    }
+    base_time_ = base_time;
+    port_ = port;
+    return true;
+}
+
+void NetClockSync::stop()
+{
+    if (provider_)
+    {
+        gst_object_unref(provider_);
+        provider_ = nullptr;
+    }
+    if (clock_)
+    {
+        gst_object_unref(clock_);
+        clock_ = nullptr;
+    }
+    base_time_ = GST_CLOCK_TIME_NONE;
+    port_ = 0;
+}
+
+void NetClockSync::apply(GstElement *pipeline) const
+{
+    if (!clock_)
+        return;
+    gst_pipeline_use_clock(GST_PIPELINE(pipeline), clock_);
+    // 保持外部给定的 base time，不在 PAUSED -> PLAYING 时重新选择
+    gst_element_set_start_time(pipeline, GST_CLOCK_TIME_NONE);
+    gst_element_set_base_time(pipeline, base_time_);
+}
+
+double NetClockSync::offset_ms() const
+{
+    if (!clock_ || provider_)
+        return 0.0;
+    // 内部时钟是本机系统时钟，校准点上两者之差即为偏移
+    GstClockTime internal = 0, external = 0, rate_num = 1, rate_denom = 1;
+    gst_clock_get_calibration(clock_, &internal, &external, &rate_num, &rate_denom);
+    return (double)GST_CLOCK_DIFF(internal, external) / GST_MSECOND;
+}
+
+double NetClockSync::record_present(GstClockTime running_time)
+{
+    if (!clock_ || !GST_CLOCK_TIME_IS_VALID(running_time) || !GST_CLOCK_TIME_IS_VALID(base_time_))
+        return 0.0;
+    GstClockTime now = gst_clock_get_time(clock_);
+    double error_ms = (double)GST_CLOCK_DIFF(base_time_ + running_time, now) / GST_MSECOND;
+    present_.frames++;
+    present_.sum_ms += error_ms;
+    if (std::fabs(error_ms) > std::fabs(present_.max_ms))
+        present_.max_ms = error_ms;
+    return error_ms;
+}
+
+bool NetClockSync::parse_address(const std::string &spec, std::string &host, int &port)
+{
+    size_t colon = spec.rfind(':');
+    if (colon == std::string::npos || colon == 0)
+        return false;
+    host = spec.substr(0, colon);
+    port = std::atoi(spec.c_str() + colon + 1);
+    return port > 0 && port < 65536;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "gst/gst.h"
+#include "gst/net/gstnet.h"
+
+#include <cstdint>
+#include <string>
+
+// 呈现误差：帧实际显示时的共同时钟时间减去它的期望时间（base time + 运行时间）
+struct PresentErrorStats
+{
+    uint64_t frames = 0;
+    double sum_ms = 0.0;
+    double max_ms = 0.0; // 绝对值最大的一次
+};
+
+// 多进程 / 多机之间共用一个时钟：主节点用 GstNetTimeProvider 发布系统时钟，
+// 从节点的管道使用跟随它的 GstNetClientClock。base time 由主节点选定（当前时间加启动延迟）、带外交给从节点，
+// 所有节点的管道用同一个时钟和 base time，同一 PTS 的帧在同一时刻显示
+class NetClockSync
+{
+public:
+    NetClockSync();
+    ~NetClockSync();
+
+    NetClockSync(const NetClockSync &) = delete;
+    NetClockSync &operator=(const NetClockSync &) = delete;
+
+    // 主节点：在 port 上发布系统时钟（0 表示自动选择端口），base time 取当前时间 + start_delay
+    bool serve(int port, GstClockTime start_delay = 2 * GST_SECOND);
+    // 从节点：跟随 address:port 的网络时钟，等到第一次同步完成
+    bool follow(const std::string &address, int port, GstClockTime base_time, GstClockTime timeout = 5 * GST_SECOND);
+    void stop();
+
+    // 管道使用共同时钟和 base time（在进入 PLAYING 之前调用）
+    void apply(GstElement *pipeline) const;
+
+    bool active() const { return clock_ != nullptr; }
+    bool is_master() const { return provider_ != nullptr; }
+    int port() const { return port_; }
+    GstClock *clock() const { return clock_; }
+    GstClockTime base_time() const { return base_time_; }
+    // 本地系统时钟到主节点时钟的偏移（毫秒，来自最近一次校准），主节点为 0
+    double offset_ms() const;
+
+    // 记录一帧显示完成，running_time 为该帧的运行时间，返回这一帧的误差（毫秒）
+    double record_present(GstClockTime running_time);
+    const PresentErrorStats &present_errors() const { return present_; }
+
+    // "host:port"
+    static bool parse_address(const std::string &spec, std::string &host, int &port);
+
+private:
+    GstClock *clock_;
+    GstNetTimeProvider *provider_;
+    GstClockTime base_time_;
+    int port_;
+    PresentErrorStats present_;
+};
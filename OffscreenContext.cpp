@@ -0,0 +1,198 @@
+#include "OffscreenContext.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef PLAYER_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static bool has_extension(const char *extensions, const char *name)
+{
+    if (!extensions)
+        return false;
+    size_t length = strlen(name);
+    for (const char *p = strstr(extensions, name); p; p = strstr(p + length, name))
+    {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+            return true;
+    }
+    return false;
+}
+
+// 先尝试 surfaceless 平台，失败再退回默认显示 + pbuffer
+static EGLDisplay open_display(bool &surfaceless)
+{
+    const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display && has_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+        {
+            if (has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+            {
+                surfaceless = true;
+                return display;
+            }
+            eglTerminate(display);
+        }
+    }
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        return EGL_NO_DISPLAY;
+    surfaceless = false;
+    return display;
+}
+#endif
+
+OffscreenContext::OffscreenContext()
+    : display_(nullptr), config_(nullptr), context_(nullptr), surface_(nullptr), kind_("none"), owns_display_(false)
+{
+}
+
+OffscreenContext::~OffscreenContext()
+{
+    destroy();
+}
+
+bool OffscreenContext::create(const OffscreenContext *share)
+{
+    destroy();
+#ifdef PLAYER_HAVE_EGL
+    bool surfaceless = false;
+    if (share)
+    {
+        display_ = share->display_;
+        config_ = share->config_;
+        surfaceless = share->surface_ == EGL_NO_SURFACE;
+    }
+    else
+    {
+        EGLDisplay display = open_display(surfaceless);
+        if (display == EGL_NO_DISPLAY)
+        {
+            std::cerr << "No EGL display for offscreen rendering" << std::endl;
+            return false;
+        }
+        display_ = display;
+        owns_display_ = true;
+
+        // surfaceless 不需要任何表面类型，pbuffer 需要 EGL_PBUFFER_BIT
+        const EGLint config_attribs[] = {
+            EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_NONE};
+        EGLConfig config = nullptr;
+        EGLint count = 0;
+        if (!eglChooseConfig(display, config_attribs, &config, 1, &count) || count < 1)
+        {
+            std::cerr << "No EGL config for desktop OpenGL" << std::endl;
+            destroy();
+            return false;
+        }
+        config_ = config;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cerr << "EGL does not support desktop OpenGL" << std::endl;
+        destroy();
+        return false;
+    }
+
+    // 与窗口模式相同的 3.3 core 上下文
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    context_ = eglCreateContext((EGLDisplay)display_, (EGLConfig)config_,
+                                share ? (EGLContext)share->context_ : EGL_NO_CONTEXT, context_attribs);
+    if (context_ == EGL_NO_CONTEXT)
+    {
+        std::cerr << "Failed to create EGL context (0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        context_ = nullptr;
+        destroy();
+        return false;
+    }
+
+    if (!surfaceless)
+    {
+        // 默认帧缓冲不会被使用，1x1 即可
+        const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        surface_ = eglCreatePbufferSurface((EGLDisplay)display_, (EGLConfig)config_, pbuffer_attribs);
+        if (surface_ == EGL_NO_SURFACE)
+        {
+            std::cerr << "Failed to create EGL pbuffer" << std::endl;
+            surface_ = nullptr;
+            destroy();
+            return false;
+        }
+    }
+    kind_ = surfaceless ? "EGL surfaceless" : "EGL pbuffer";
+    return true;
+#else
+    (void)share;
+    return false;
+#endif
+}
+
+void OffscreenContext::destroy()
+{
+#ifdef PLAYER_HAVE_EGL
+    if (context_)
+    {
+        if (eglGetCurrentContext() == (EGLContext)context_)
+            eglMakeCurrent((EGLDisplay)display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext((EGLDisplay)display_, (EGLContext)context_);
+    }
+    if (surface_)
+        eglDestroySurface((EGLDisplay)display_, (EGLSurface)surface_);
+    if (display_ && owns_display_)
+        eglTerminate((EGLDisplay)display_);
+#endif
+    display_ = nullptr;
+    config_ = nullptr;
+    context_ = nullptr;
+    surface_ = nullptr;
+    kind_ = "none";
+    owns_display_ = false;
+}
+
+bool OffscreenContext::make_current() const
+{
+#ifdef PLAYER_HAVE_EGL
+    return context_ && eglMakeCurrent((EGLDisplay)display_, (EGLSurface)surface_, (EGLSurface)surface_, (EGLContext)context_);
+#else
+    return false;
+#endif
+}
+
+void OffscreenContext::release_current() const
+{
+#ifdef PLAYER_HAVE_EGL
+    if (display_)
+        eglMakeCurrent((EGLDisplay)display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#endif
+}
+
+void *OffscreenContext::get_proc_address(const char *name)
+{
+#ifdef PLAYER_HAVE_EGL
+    return (void *)eglGetProcAddress(name);
+#else
+    (void)name;
+    return nullptr;
+#endif
+}
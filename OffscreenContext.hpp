@@ -0,0 +1,37 @@
+#pragma once
+
+// 无窗口的 OpenGL 3.3 core 上下文，用于没有显示器的渲染服务器和 CI。
+// 优先使用 Mesa 的 surfaceless 平台（不需要 X/Wayland，llvmpipe 可用），否则在默认 EGL 显示上创建 1x1 pbuffer。
+// 编译时没有 EGL（PLAYER_HAVE_EGL 未定义）时 create() 返回 false
+class OffscreenContext
+{
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext &) = delete;
+    OffscreenContext &operator=(const OffscreenContext &) = delete;
+
+    // share 不为空时在同一个 EGL 显示上创建与它共享对象的上下文（上传线程用）
+    bool create(const OffscreenContext *share = nullptr);
+    // 共享上下文必须先于被共享的上下文销毁
+    void destroy();
+
+    bool make_current() const;
+    void release_current() const;
+
+    // 用于 gladLoadGLLoader / load_gl_extensions
+    static void *get_proc_address(const char *name);
+
+    bool valid() const { return context_ != nullptr; }
+    void *egl_display() const { return display_; }
+    const char *kind() const { return kind_; }
+
+private:
+    void *display_;
+    void *config_;
+    void *context_;
+    void *surface_;
+    const char *kind_;
+    bool owns_display_;
+};
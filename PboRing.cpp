@@ -0,0 +1,120 @@
+#include "PboRing.hpp"
+
+#include <chrono>
+#include <iostream>
+
+PboRing::PboRing()
+    : current_(0)
+{
+}
+
+PboRing::~PboRing()
+{
+    destroy();
+}
+
+bool PboRing::init(int count)
+{
+    destroy();
+    if (count <= 0)
+        return false;
+
+    slots_.resize(count);
+    for (Slot &slot : slots_)
+        glGenBuffers(1, &slot.pbo);
+    current_ = 0;
+    stats_ = PboStats();
+    return true;
+}
+
+void PboRing::destroy()
+{
+    for (Slot &slot : slots_)
+    {
+        if (slot.fence)
+        {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        if (slot.pbo)
+        {
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+    }
+    slots_.clear();
+}
+
+// 等待 GPU 读完该 PBO，并记录等待时间
+void PboRing::wait_fence(Slot &slot)
+{
+    stats_.last_stall_us = 0.0;
+    if (!slot.fence)
+        return;
+
+    GLenum result = glClientWaitSync(slot.fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        auto start = std::chrono::steady_clock::now();
+        do
+        {
+            result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+        auto end = std::chrono::steady_clock::now();
+
+        double stall_us = std::chrono::duration<double, std::micro>(end - start).count();
+        stats_.last_stall_us = stall_us;
+        stats_.stall_total_us += stall_us;
+        if (stall_us > stats_.stall_max_us)
+            stats_.stall_max_us = stall_us;
+        stats_.stalled_uploads++;
+    }
+    if (result == GL_WAIT_FAILED)
+        std::cerr << "PBO fence wait failed" << std::endl;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+}
+
+void *PboRing::map_next(size_t size)
+{
+    if (slots_.empty())
+        return nullptr;
+
+    Slot &slot = slots_[current_];
+    wait_fence(slot);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+    if (size > slot.capacity)
+    {
+        // 帧尺寸变大时重新分配存储
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        slot.capacity = size;
+    }
+
+    // 栅栏已经保证 GPU 不再读取，可以不同步映射
+    void *ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!ptr)
+    {
+        std::cerr << "Failed to map PBO" << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    return ptr;
+}
+
+bool PboRing::unmap()
+{
+    // 映射期间存储被破坏时返回 GL_FALSE，本帧数据无效
+    return glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+}
+
+void PboRing::fence_and_advance()
+{
+    Slot &slot = slots_[current_];
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    stats_.uploads++;
+    current_ = (current_ + 1) % (int)slots_.size();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "glad/glad.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 上传等待统计
+struct PboStats
+{
+    uint64_t uploads = 0;        // 经过 PBO 的上传次数
+    uint64_t stalled_uploads = 0; // 需要等待栅栏的次数
+    double stall_total_us = 0.0; // 累计等待时间
+    double stall_max_us = 0.0;   // 单帧最大等待时间
+    double last_stall_us = 0.0;  // 最近一帧的等待时间
+};
+
+// 像素解包缓冲（GL_PIXEL_UNPACK_BUFFER）环
+// 每帧写入一个映射的 PBO，从 PBO 异步上传到纹理，并在上传命令后插入栅栏；
+// 只有栅栏完成后该 PBO 才会被再次写入。所有调用都必须在拥有 GL 上下文的线程上。
+class PboRing
+{
+public:
+    PboRing();
+    ~PboRing();
+
+    PboRing(const PboRing &) = delete;
+    PboRing &operator=(const PboRing &) = delete;
+
+    // 创建 count 个 PBO
+    bool init(int count);
+    void destroy();
+
+    // 等待下一个 PBO 可用，绑定到 GL_PIXEL_UNPACK_BUFFER 并映射 size 字节，失败返回 nullptr
+    void *map_next(size_t size);
+    // 解除映射，PBO 保持绑定，随后的 glTexSubImage2D 以偏移量读取它
+    bool unmap();
+    // 在上传命令之后插入栅栏，解除绑定并前进到下一个 PBO
+    void fence_and_advance();
+
+    int count() const { return (int)slots_.size(); }
+    const PboStats &stats() const { return stats_; }
+
+private:
+    struct Slot
+    {
+        GLuint pbo = 0;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+    };
+
+    void wait_fence(Slot &slot);
+
+    std::vector<Slot> slots_;
+    int current_;
+    PboStats stats_;
+};
@@ -0,0 +1,278 @@
+#include "PipelineBuilder.hpp"
+
+#include <iostream>
+
+SourceKind source_kind(const std::string &source)
+{
+    // "test:<图案>" 选择 videotestsrc 的图案（与电视墙和帧服务一致）
+    if (source.empty() || source == "test" || source.compare(0, 5, "test:") == 0)
+        return SourceKind::Test;
+    if (source.find("rtsp://") == 0 || source.find("rtmp://") == 0)
+        return SourceKind::Rtsp;
+    if (source.find("http://") == 0 || source.find("https://") == 0)
+        return SourceKind::Http;
+    return SourceKind::File;
+}
+
+static SourceProfile make_profile(SourceKind kind)
+{
+    SourceProfile profile;
+    switch (kind)
+    {
+    case SourceKind::Test:
+        profile.name = "test";
+        profile.source = {"videotestsrc", "", {{"pattern", "snow"}}};
+        profile.caps = "video/x-raw,width=640,height=480";
+        profile.convert = false;
+        break;
+    case SourceKind::Rtsp:
+        // 低延迟：只缓冲几帧，落后时由 appsink 丢帧
+        profile.name = "rtsp";
+        profile.source = {"rtspsrc", "", {{"latency", "0"}}};
+        profile.location_property = "location";
+        profile.video_chain = {{"rtph264depay"}, {"h264parse"}, {"avdec_h264"}};
+        profile.queue_buffers = 3;
+        break;
+    case SourceKind::Http:
+        // 网络抖动：按时长缓冲
+        profile.name = "http";
+        profile.source = {"souphttpsrc"};
+        profile.location_property = "location";
+        profile.video_chain = {{"decodebin"}};
+        profile.queue_time = 2 * GST_SECOND;
+        break;
+    case SourceKind::File:
+        // 容器和编码不固定：decodebin3 自己 typefind 并按 rank 选择分离器、解析器和解码器，
+        // 有探测结果时由 auto_file_profile 细化（DecoderSelection.hpp）
+        profile.name = "file";
+        profile.source = {"filesrc"};
+        profile.location_property = "location";
+        profile.demuxer = {"decodebin3", "dec"};
+        profile.filters = {{"myelement"}, {"textoverlay", "overlay", {{"font-desc", "Sans Bold 10"}}}};
+        profile.sync = true;
+        break;
+    }
+    return profile;
+}
+
+const SourceProfile &source_profile(SourceKind kind)
+{
+    static const SourceProfile profiles[] = {make_profile(SourceKind::Test), make_profile(SourceKind::Rtsp),
+                                             make_profile(SourceKind::Http), make_profile(SourceKind::File)};
+    return profiles[(int)kind];
+}
+
+ElementFactoryCache &ElementFactoryCache::instance()
+{
+    static ElementFactoryCache cache;
+    return cache;
+}
+
+GstElementFactory *ElementFactoryCache::find(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    lookups_++;
+    auto it = factories_.find(name);
+    if (it != factories_.end())
+        return it->second;
+    misses_++;
+    GstElementFactory *factory = gst_element_factory_find(name.c_str());
+    factories_[name] = factory;
+    return factory;
+}
+
+// 动态 pad 的链接目标，随 pad-added 信号的连接一起释放
+struct DynamicLink
+{
+    GstElement *target;
+    std::string media;
+};
+
+static bool pad_matches(GstPad *pad, const std::string &media)
+{
+    if (media.empty())
+        return true;
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    if (!caps)
+        caps = gst_pad_query_caps(pad, nullptr);
+    bool matches = false;
+    if (caps && !gst_caps_is_empty(caps))
+    {
+        const GstStructure *structure = gst_caps_get_structure(caps, 0);
+        std::string type = gst_structure_get_name(structure);
+        // rtspsrc 的 pad 都是 application/x-rtp，音视频由 media 字段区分
+        const gchar *rtp_media = gst_structure_get_string(structure, "media");
+        if (type == "application/x-rtp" && rtp_media)
+            type = std::string(rtp_media) + "/";
+        matches = type.compare(0, media.size(), media) == 0;
+    }
+    if (caps)
+        gst_caps_unref(caps);
+    return matches;
+}
+
+static void dynamic_pad_added(GstElement *element, GstPad *pad, gpointer data)
+{
+    DynamicLink *link = static_cast<DynamicLink *>(data);
+    if (GST_PAD_DIRECTION(pad) != GST_PAD_SRC)
+        return;
+    GstPad *sink = gst_element_get_static_pad(link->target, "sink");
+    if (!sink)
+        return;
+    // 同类型的第二个 pad（例如多条视频轨）不再链接
+    if (!gst_pad_is_linked(sink) && pad_matches(pad, link->media) && gst_pad_link(pad, sink) != GST_PAD_LINK_OK)
+        std::cerr << "Failed to link " << GST_ELEMENT_NAME(element) << " to " << GST_ELEMENT_NAME(link->target) << std::endl;
+    gst_object_unref(sink);
+}
+
+static void free_dynamic_link(gpointer data, GClosure *)
+{
+    delete static_cast<DynamicLink *>(data);
+}
+
+PipelineBuilder::PipelineBuilder(const char *name)
+    : pipeline_(gst_pipeline_new(name)), tail_(nullptr), elements_(0), start_(std::chrono::steady_clock::now())
+{
+}
+
+PipelineBuilder::~PipelineBuilder()
+{
+    if (pipeline_)
+        gst_object_unref(pipeline_);
+}
+
+GstElement *PipelineBuilder::add(const ElementSpec &spec)
+{
+    if (!ok())
+        return nullptr;
+    GstElementFactory *factory = ElementFactoryCache::instance().find(spec.factory);
+    if (!factory)
+    {
+        error_ = "Missing element " + spec.factory;
+        return nullptr;
+    }
+    GstElement *element = gst_element_factory_create(factory, spec.name.empty() ? nullptr : spec.name.c_str());
+    if (!element)
+    {
+        error_ = "Failed to create " + spec.factory;
+        return nullptr;
+    }
+
+    std::string description = spec.factory;
+    if (!spec.name.empty())
+        description += " name=" + spec.name;
+    for (const auto &property : spec.properties)
+    {
+        if (!g_object_class_find_property(G_OBJECT_GET_CLASS(element), property.first.c_str()))
+        {
+            error_ = spec.factory + " has no property " + property.first;
+            gst_object_unref(element);
+            return nullptr;
+        }
+        gst_util_set_object_arg(G_OBJECT(element), property.first.c_str(), property.second.c_str());
+        description += " " + property.first + "=\"" + property.second + "\"";
+    }
+
+    gst_bin_add(GST_BIN(pipeline_), element);
+    elements_++;
+    description_ += (tail_ ? " ! " : "") + description;
+    link(element);
+    tail_ = element;
+    return ok() ? element : nullptr;
+}
+
+GstElement *PipelineBuilder::add(const std::string &factory, const std::string &name)
+{
+    return add(ElementSpec{factory, name, {}});
+}
+
+GstElement *PipelineBuilder::add_caps(const std::string &caps)
+{
+    return add(ElementSpec{"capsfilter", "", {{"caps", caps}}});
+}
+
+void PipelineBuilder::link(GstElement *element)
+{
+    if (!tail_)
+        return;
+    GstPad *src = gst_element_get_static_pad(tail_, "src");
+    if (src)
+    {
+        gst_object_unref(src);
+        if (!gst_element_link(tail_, element))
+            error_ = std::string("Failed to link ") + GST_ELEMENT_NAME(tail_) + " to " + GST_ELEMENT_NAME(element);
+        return;
+    }
+    // 只有动态 pad（分离器、rtspsrc、decodebin）：流开始后在 pad-added 中链接
+    g_signal_connect_data(tail_, "pad-added", G_CALLBACK(dynamic_pad_added), new DynamicLink{element, tail_media_},
+                          free_dynamic_link, (GConnectFlags)0);
+}
+
+void PipelineBuilder::branch(GstElement *from, const std::string &media)
+{
+    if (!from)
+        return;
+    tail_ = from;
+    tail_media_ = media;
+    description_ += std::string("  ") + GST_ELEMENT_NAME(from) + ".";
+}
+
+bool PipelineBuilder::add_profile(const SourceProfile &profile, const std::string &location)
+{
+    ElementSpec source = profile.source;
+    if (!profile.location_property.empty())
+        source.properties.push_back({profile.location_property, location});
+    add(source);
+    if (!profile.caps.empty())
+        add_caps(profile.caps);
+    GstElement *demuxer = profile.demuxer.factory.empty() ? nullptr : add(profile.demuxer);
+    if (demuxer && !profile.audio_chain.empty())
+    {
+        branch(demuxer, "audio/");
+        add("queue");
+        for (const ElementSpec &spec : profile.audio_chain)
+            add(spec);
+    }
+    // 源或分离器有多个动态 pad 时只接视频
+    if (demuxer)
+        branch(demuxer, "video/");
+    else
+        tail_media_ = "video/";
+
+    GstElement *queue = add("queue");
+    if (queue && profile.queue_buffers)
+        g_object_set(queue, "max-size-buffers", profile.queue_buffers, nullptr);
+    if (queue && profile.queue_time)
+        g_object_set(queue, "max-size-time", (guint64)profile.queue_time, nullptr);
+    for (const ElementSpec &spec : profile.video_chain)
+        add(spec);
+    if (profile.convert)
+        add("videoconvert");
+    for (const ElementSpec &spec : profile.filters)
+        add(spec);
+    return ok();
+}
+
+GstElement *PipelineBuilder::finish(PipelineTiming &timing)
+{
+    timing.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    timing.elements = elements_;
+    if (!ok())
+        return nullptr;
+    GstElement *pipeline = pipeline_;
+    pipeline_ = nullptr;
+    return pipeline;
+}
+
+GstStateChangeReturn PipelineBuilder::preroll(GstElement *pipeline, GstClockTime timeout, PipelineTiming &timing)
+{
+    auto start = std::chrono::steady_clock::now();
+    GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    if (ret == GST_STATE_CHANGE_ASYNC)
+        ret = gst_element_get_state(pipeline, nullptr, nullptr, timeout);
+    // 直播源在 PLAYING 之前不产生数据，没有预卷
+    timing.live = ret == GST_STATE_CHANGE_NO_PREROLL;
+    if (ret == GST_STATE_CHANGE_SUCCESS)
+        timing.preroll_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ret;
+}
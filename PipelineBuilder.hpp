@@ -0,0 +1,122 @@
+#pragma once
+#include "gst/gst.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 一个元素：工厂名、元素名（空表示自动命名）和属性。属性值按属性类型解析（gst_util_set_object_arg），
+// 用户给出的 URI 和路径只作为属性值，不再拼进 gst_parse_launch 字符串
+struct ElementSpec
+{
+    std::string factory;
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> properties;
+};
+
+// 视频源类型
+enum class SourceKind
+{
+    Test, // "test" 或空
+    Rtsp, // rtsp:// rtmp://
+    Http, // http:// https://
+    File  // 其余按本地文件
+};
+
+// 每种源的管道配置：源 -> [caps] -> [分离器] -> queue -> 解码链 -> [videoconvert] -> 处理元素，
+// 调用者再接 appsink。分离器或解码链中只有动态 pad 的元素（rtspsrc、decodebin）在 pad-added 时链接
+struct SourceProfile
+{
+    const char *name = "";
+    ElementSpec source;
+    std::string location_property;  // 源的 URI/路径属性，空表示没有
+    std::string caps;               // 源之后的 capsfilter，空表示不限制
+    ElementSpec demuxer;            // factory 为空表示源直接接视频链
+    std::vector<ElementSpec> video_chain;
+    std::vector<ElementSpec> audio_chain; // 非空时从分离器的音频 pad 另接一条链（以 sink 结尾）
+    bool convert = true;
+    std::vector<ElementSpec> filters;
+    // 解码前的 queue，0 表示保持 queue 的默认值
+    guint queue_buffers = 0;
+    GstClockTime queue_time = 0;
+    bool sync = false; // appsink 是否按时钟同步
+};
+
+SourceKind source_kind(const std::string &source);
+const SourceProfile &source_profile(SourceKind kind);
+
+// 工厂按名字只查找一次：注册表查找要遍历插件列表，之后每次创建元素都直接用缓存的工厂（找不到的也缓存）。
+// 缓存的工厂引用一直持有到进程结束
+class ElementFactoryCache
+{
+public:
+    static ElementFactoryCache &instance();
+
+    // 返回缓存持有的引用，不存在返回 nullptr
+    GstElementFactory *find(const std::string &name);
+    uint64_t lookups() const { return lookups_.load(); }
+    uint64_t misses() const { return misses_.load(); }
+
+private:
+    ElementFactoryCache() = default;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, GstElementFactory *> factories_;
+    std::atomic<uint64_t> lookups_{0};
+    std::atomic<uint64_t> misses_{0}; // 真正查询注册表的次数
+};
+
+// 管道的构建与预卷耗时
+struct PipelineTiming
+{
+    double build_ms = 0.0;    // 创建、设置、添加并链接全部元素
+    int elements = 0;
+    double preroll_ms = -1.0; // PAUSED 到预卷完成，没有预卷时为 -1
+    bool live = false;        // 直播源没有预卷
+};
+
+// 按顺序追加元素并链接的管道构建器。出错后后续调用都不再生效，由 ok()/error() 报告第一个错误
+class PipelineBuilder
+{
+public:
+    explicit PipelineBuilder(const char *name = nullptr);
+    ~PipelineBuilder();
+
+    PipelineBuilder(const PipelineBuilder &) = delete;
+    PipelineBuilder &operator=(const PipelineBuilder &) = delete;
+
+    // 追加到当前链尾并链接，返回元素（属于管道）
+    GstElement *add(const ElementSpec &spec);
+    GstElement *add(const std::string &factory, const std::string &name = std::string());
+    GstElement *add_caps(const std::string &caps);
+    // 按源配置追加从源到处理元素的整段，location 为用户给出的 URI 或路径
+    bool add_profile(const SourceProfile &profile, const std::string &location);
+    // 之后追加的元素从 from 的动态 pad 开始，只链接 caps 以 media 开头的 pad（RTP pad 按 media 字段判断）
+    void branch(GstElement *from, const std::string &media);
+
+    bool ok() const { return error_.empty(); }
+    const std::string &error() const { return error_; }
+    // 与 gst-launch 写法相同的描述，只用于日志
+    const std::string &description() const { return description_; }
+    // 交出管道并记录构建耗时；失败时返回 nullptr
+    GstElement *finish(PipelineTiming &timing);
+
+    // 切到 PAUSED 并等待预卷完成，耗时写入 timing
+    static GstStateChangeReturn preroll(GstElement *pipeline, GstClockTime timeout, PipelineTiming &timing);
+
+private:
+    void link(GstElement *element);
+
+    GstElement *pipeline_;
+    GstElement *tail_;
+    std::string tail_media_;
+    std::string description_;
+    std::string error_;
+    int elements_;
+    std::chrono::steady_clock::time_point start_;
+};
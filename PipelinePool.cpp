@@ -0,0 +1,144 @@
+#include "PipelinePool.hpp"
+
+#include <chrono>
+#include <iostream>
+
+static void release_pipeline(GstElement *pipeline)
+{
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+}
+
+// 池中的管道没有总线监听，消息一直积在总线上，交出去之前清空，免得接管的一方重放旧消息。
+// 积压的消息里有 ERROR 时返回 false
+static bool drain_bus(GstElement *pipeline, const std::string &source)
+{
+    GstBus *bus = gst_element_get_bus(pipeline);
+    bool ok = true;
+    while (GstMessage *msg = gst_bus_pop(bus))
+    {
+        if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR && ok)
+        {
+            GError *error = nullptr;
+            gst_message_parse_error(msg, &error, nullptr);
+            std::cerr << "Pre-warmed pipeline for " << source << ": " << (error ? error->message : "error") << std::endl;
+            if (error)
+                g_error_free(error);
+            ok = false;
+        }
+        gst_message_unref(msg);
+    }
+    gst_object_unref(bus);
+    return ok;
+}
+
+PipelinePool::PipelinePool(size_t capacity) : capacity_(capacity)
+{
+}
+
+PipelinePool::~PipelinePool()
+{
+    clear();
+}
+
+void PipelinePool::put(const std::string &source, GstElement *pipeline, const PipelineTiming &timing)
+{
+    for (auto it = pipelines_.begin(); it != pipelines_.end(); ++it)
+    {
+        if (it->source == source)
+        {
+            release_pipeline(it->pipeline);
+            pipelines_.erase(it);
+            break;
+        }
+    }
+    if (capacity_ == 0)
+    {
+        release_pipeline(pipeline);
+        return;
+    }
+    evict_to(capacity_ - 1);
+
+    // 上一次播放留下的消息（EOS、状态变化、错误）与预热无关
+    GstBus *bus = gst_element_get_bus(pipeline);
+    gst_bus_set_flushing(bus, TRUE);
+    gst_bus_set_flushing(bus, FALSE);
+    gst_object_unref(bus);
+
+    // 从 NULL/READY 到 PAUSED：文件源从头预卷，直播源只建立连接（NO_PREROLL）
+    if (gst_element_set_state(pipeline, GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
+    {
+        std::cerr << "Failed to pre-roll " << source << std::endl;
+        release_pipeline(pipeline);
+        return;
+    }
+    WarmPipeline warm;
+    warm.source = source;
+    warm.pipeline = pipeline;
+    warm.timing = timing;
+    warm.timing.preroll_ms = -1.0;
+    pipelines_.push_back(warm);
+}
+
+GstElement *PipelinePool::take(const std::string &source, GstClockTime timeout, PipelineTiming &timing, bool &prerolled)
+{
+    prerolled = false;
+    for (auto it = pipelines_.begin(); it != pipelines_.end(); ++it)
+    {
+        if (it->source != source)
+            continue;
+        WarmPipeline warm = *it;
+        pipelines_.erase(it);
+
+        auto start = std::chrono::steady_clock::now();
+        GstStateChangeReturn ret = gst_element_get_state(warm.pipeline, nullptr, nullptr, 0);
+        prerolled = ret == GST_STATE_CHANGE_SUCCESS || ret == GST_STATE_CHANGE_NO_PREROLL;
+        if (ret == GST_STATE_CHANGE_ASYNC)
+            ret = gst_element_get_state(warm.pipeline, nullptr, nullptr, timeout);
+        // 预热期间出错（文件被删除、连接断开）的管道不能再用；
+        // 直播源出错时状态不一定变成 FAILURE，要看总线上积压的 ERROR
+        if (!drain_bus(warm.pipeline, source))
+            ret = GST_STATE_CHANGE_FAILURE;
+        if (ret == GST_STATE_CHANGE_FAILURE)
+        {
+            std::cerr << "Pre-warmed pipeline for " << source << " failed, rebuilding" << std::endl;
+            release_pipeline(warm.pipeline);
+            return nullptr;
+        }
+        timing = warm.timing;
+        timing.live = ret == GST_STATE_CHANGE_NO_PREROLL;
+        timing.preroll_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return warm.pipeline;
+    }
+    return nullptr;
+}
+
+bool PipelinePool::contains(const std::string &source) const
+{
+    for (const WarmPipeline &warm : pipelines_)
+    {
+        if (warm.source == source)
+            return true;
+    }
+    return false;
+}
+
+void PipelinePool::clear()
+{
+    evict_to(0);
+}
+
+void PipelinePool::set_capacity(size_t capacity)
+{
+    capacity_ = capacity;
+    evict_to(capacity_);
+}
+
+void PipelinePool::evict_to(size_t count)
+{
+    while (pipelines_.size() > count)
+    {
+        release_pipeline(pipelines_.front().pipeline);
+        pipelines_.pop_front();
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "gst/gst.h"
+
+#include "PipelineBuilder.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+// 池中一条预热的管道：已构建并置为 PAUSED，非直播源已经（或正在）预卷出第一帧
+struct WarmPipeline
+{
+    std::string source;
+    GstElement *pipeline = nullptr;
+    PipelineTiming timing; // 构建耗时，取出时补上预卷的等待时间
+};
+
+// 切换统计
+struct SwitchStats
+{
+    uint64_t switches = 0;
+    uint64_t warm = 0;      // 来自池中的管道
+    uint64_t prerolled = 0; // 取出时已完成预卷
+    double total_ms = 0.0;  // 请求到新源第一帧显示
+    double max_ms = 0.0;
+    double last_ms = 0.0;
+    uint64_t stale = 0;     // 新源的帧显示之后又呈现出的旧源帧（应为 0）
+};
+
+// 预热管道池：为可能切换到的源提前构建管道并预卷到 PAUSED，切换时取出直接置为 PLAYING，
+// 不再经过构建、typefind 和预卷。只由一个线程使用。
+// 池中的管道占着解码器和预卷的缓冲，容量满时淘汰最早放入的
+class PipelinePool
+{
+public:
+    explicit PipelinePool(size_t capacity = 2);
+    ~PipelinePool();
+
+    PipelinePool(const PipelinePool &) = delete;
+    PipelinePool &operator=(const PipelinePool &) = delete;
+
+    // 接管管道并开始预卷（不等待）；同一源已有管道时替换旧的
+    void put(const std::string &source, GstElement *pipeline, const PipelineTiming &timing);
+    // 取出源的管道（所有权交给调用者），没有时返回 nullptr；预卷尚未完成时最多等待 timeout。
+    // 总线上积压的消息在交出前清空，其中有 ERROR 时释放管道并返回 nullptr（由调用者重建）。
+    // prerolled 为取出时是否已经预卷完成（直播源没有预卷，视为完成）
+    GstElement *take(const std::string &source, GstClockTime timeout, PipelineTiming &timing, bool &prerolled);
+    bool contains(const std::string &source) const;
+    void clear();
+
+    size_t size() const { return pipelines_.size(); }
+    size_t capacity() const { return capacity_; }
+    void set_capacity(size_t capacity);
+
+private:
+    void evict_to(size_t count);
+
+    std::deque<WarmPipeline> pipelines_;
+    size_t capacity_;
+};
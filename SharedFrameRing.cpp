@@ -0,0 +1,576 @@
+#include "SharedFrameRing.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "shared ring needs lock-free atomics");
+
+static size_t page_align(size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+// 共享映射上的 futex（不能用 FUTEX_PRIVATE_FLAG）
+static void futex_wait(std::atomic<uint32_t> *word, uint32_t expected, int timeout_ms)
+{
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t> *word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static int64_t monotonic_ms()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static bool fill_socket_address(const std::string &path, struct sockaddr_un &address)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+        return false;
+    memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+#endif
+
+SharedFrameRing::SharedFrameRing()
+    : fd_(-1), writer_(false), header_(nullptr), header_size_(0), data_(nullptr), data_size_(0), writing_(-1),
+      sequence_(0), listen_fd_(-1), socket_fd_(-1), lease_(-1), last_sequence_(0)
+{
+    for (int &fd : client_fds_)
+        fd = -1;
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+    close();
+}
+
+#ifdef __linux__
+
+bool SharedFrameRing::create(size_t slot_size, int slot_count)
+{
+    // 重建时保留监听套接字，已连接的读端由调用者断开
+    unmap();
+    if (slot_count < 2 || slot_count > SHARED_RING_MAX_SLOTS || slot_size == 0)
+    {
+        std::cerr << "Shared ring needs 2.." << SHARED_RING_MAX_SLOTS << " slots" << std::endl;
+        return false;
+    }
+
+    header_size_ = page_align(sizeof(SharedRingHeader));
+    size_t aligned_slot = page_align(slot_size);
+    data_size_ = aligned_slot * slot_count;
+    fd_ = (int)syscall(SYS_memfd_create, "gst-frame-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd_ < 0 || ftruncate(fd_, (off_t)(header_size_ + data_size_)) != 0)
+    {
+        std::cerr << "Failed to create frame ring memfd: " << strerror(errno) << std::endl;
+        unmap();
+        return false;
+    }
+    // 尺寸固定：读端映射整个环后，写端无法再截断或扩展它
+    if (fcntl(fd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)
+    {
+        std::cerr << "Failed to seal frame ring: " << strerror(errno) << std::endl;
+        unmap();
+        return false;
+    }
+
+    void *header = mmap(nullptr, header_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    void *data = mmap(nullptr, data_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, (off_t)header_size_);
+    if (header == MAP_FAILED || data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map frame ring: " << strerror(errno) << std::endl;
+        if (header != MAP_FAILED)
+            munmap(header, header_size_);
+        if (data != MAP_FAILED)
+            munmap(data, data_size_);
+        unmap();
+        return false;
+    }
+
+    // 新的 memfd 内容全为零，原子变量的零值即初始状态
+    header_ = static_cast<SharedRingHeader *>(header);
+    data_ = static_cast<uint8_t *>(data);
+    header_->version = SHARED_RING_VERSION;
+    header_->slot_count = (uint32_t)slot_count;
+    header_->header_size = (uint32_t)header_size_;
+    header_->slot_size = aligned_slot;
+    header_->data_offset = header_size_;
+    header_->writer_pid = (int32_t)getpid();
+    header_->latest.store(kNoSlot, std::memory_order_relaxed);
+    for (SharedReaderLease &lease : header_->leases)
+        lease.slot.store(-1, std::memory_order_relaxed);
+    // 魔数最后写，读端据此判断头部已经初始化
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = SHARED_RING_MAGIC;
+    writer_ = true;
+    writing_ = -1;
+    sequence_ = 0;
+    return true;
+}
+
+void SharedFrameRing::reclaim_dead_readers(SharedRingHeader *header)
+{
+    for (SharedReaderLease &lease : header->leases)
+    {
+        int32_t pid = lease.pid.load(std::memory_order_acquire);
+        if (pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH)
+            continue;
+        int32_t slot = lease.slot.exchange(-1, std::memory_order_acq_rel);
+        if (slot >= 0 && slot < (int32_t)header->slot_count)
+        {
+            header->slots[slot].readers.fetch_sub(1, std::memory_order_acq_rel);
+            header->reclaimed.fetch_add(1, std::memory_order_relaxed);
+        }
+        lease.pid.store(0, std::memory_order_release);
+    }
+}
+
+uint8_t *SharedFrameRing::begin_write(size_t size, int timeout_ms)
+{
+    if (!writer_ || size > header_->slot_size)
+    {
+        if (writer_)
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    int64_t deadline = monotonic_ms() + timeout_ms;
+    bool reclaimed = false;
+    while (true)
+    {
+        // 读端可能随时给最新帧加读者，写端只在其余槽位中选
+        uint32_t released = header_->release_futex.load(std::memory_order_acquire);
+        uint32_t latest = header_->latest.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < header_->slot_count; ++i)
+        {
+            uint32_t expected = 0;
+            if (i != latest && header_->slots[i].readers.compare_exchange_strong(expected, kSlotWriting, std::memory_order_acq_rel))
+            {
+                writing_ = (int)i;
+                return data_ + (size_t)i * header_->slot_size;
+            }
+        }
+        if (!reclaimed)
+        {
+            reclaim_dead_readers(header_);
+            reclaimed = true;
+            continue;
+        }
+
+        // 反压：等读者释放槽位
+        int64_t remaining = deadline - monotonic_ms();
+        if (remaining <= 0)
+        {
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        futex_wait(&header_->release_futex, released, (int)remaining);
+    }
+}
+
+void SharedFrameRing::commit_write(const SharedFrameInfo &info, const char *caps)
+{
+    if (!writer_ || writing_ < 0)
+        return;
+
+    SharedSlotHeader &slot = header_->slots[writing_];
+    slot.info = info;
+    slot.info.sequence = ++sequence_;
+    strncpy(slot.caps, caps ? caps : "", SHARED_RING_CAPS_SIZE - 1);
+    slot.caps[SHARED_RING_CAPS_SIZE - 1] = '\0';
+    // 清除写标记即发布槽位内容，之后才让 latest 指向它
+    slot.readers.store(0, std::memory_order_release);
+    header_->latest.store((uint32_t)writing_, std::memory_order_release);
+    header_->latest_sequence.store(sequence_, std::memory_order_release);
+    header_->published.fetch_add(1, std::memory_order_relaxed);
+    header_->frame_futex.fetch_add(1, std::memory_order_release);
+    futex_wake(&header_->frame_futex);
+    writing_ = -1;
+}
+
+bool SharedFrameRing::listen(const std::string &path)
+{
+    struct sockaddr_un address;
+    if (!fill_socket_address(path, address))
+    {
+        std::cerr << "Invalid frame ring socket path: " << path << std::endl;
+        return false;
+    }
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    // 上一次运行（可能已崩溃）留下的套接字文件
+    unlink(path.c_str());
+    if (listen_fd_ < 0 || bind(listen_fd_, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        ::listen(listen_fd_, SHARED_RING_MAX_READERS) != 0)
+    {
+        std::cerr << "Failed to listen on " << path << ": " << strerror(errno) << std::endl;
+        if (listen_fd_ >= 0)
+            ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    listen_path_ = path;
+    return true;
+}
+
+void SharedFrameRing::accept_readers()
+{
+    if (listen_fd_ < 0 || fd_ < 0)
+        return;
+
+    // 断开的连接先腾出位置；读端退出时连接随之断开，顺带回收它的租约，
+    // 否则没有持有槽位就退出的读端永远占着租约
+    bool dropped = false;
+    for (int &client : client_fds_)
+    {
+        struct pollfd pfd = {client, POLLIN, 0};
+        char byte;
+        if (client >= 0 && poll(&pfd, 1, 0) > 0 && recv(client, &byte, 1, MSG_DONTWAIT) <= 0)
+        {
+            ::close(client);
+            client = -1;
+            dropped = true;
+        }
+    }
+    if (dropped)
+        reclaim_dead_readers(header_);
+
+    while (true)
+    {
+        int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0)
+            return;
+        int *free_slot = nullptr;
+        for (int &fd : client_fds_)
+        {
+            if (fd < 0)
+            {
+                free_slot = &fd;
+                break;
+            }
+        }
+        if (!free_slot)
+        {
+            ::close(client);
+            continue;
+        }
+
+        // 用 SCM_RIGHTS 传递 memfd，随附一个字节
+        char byte = 'F';
+        struct iovec iov = {&byte, 1};
+        char control[CMSG_SPACE(sizeof(int))];
+        memset(control, 0, sizeof(control));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd_, sizeof(int));
+        if (sendmsg(client, &msg, MSG_NOSIGNAL) != 1)
+        {
+            ::close(client);
+            continue;
+        }
+        *free_slot = client;
+    }
+}
+
+void SharedFrameRing::disconnect_readers()
+{
+    for (int &client : client_fds_)
+    {
+        if (client >= 0)
+        {
+            ::close(client);
+            client = -1;
+        }
+    }
+}
+
+bool SharedFrameRing::connect(const std::string &path)
+{
+    close();
+    struct sockaddr_un address;
+    if (!fill_socket_address(path, address))
+        return false;
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+        return false;
+    if (::connect(sock, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        ::close(sock);
+        return false;
+    }
+
+    // 写端在 accept 后才发送，最多等 1 秒
+    struct pollfd pfd = {sock, POLLIN, 0};
+    char byte = 0;
+    struct iovec iov = {&byte, 1};
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (poll(&pfd, 1, 1000) <= 0 || recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != 1)
+    {
+        ::close(sock);
+        return false;
+    }
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+    {
+        ::close(sock);
+        return false;
+    }
+    int fd = -1;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    if (!attach(fd))
+    {
+        ::close(fd);
+        ::close(sock);
+        return false;
+    }
+    socket_fd_ = sock;
+    return true;
+}
+
+bool SharedFrameRing::attach(int fd)
+{
+    unmap();
+    // 只接受尺寸已封住的 memfd，否则写端截断后读端访问会收到 SIGBUS
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & (F_SEAL_SHRINK | F_SEAL_GROW)) != (F_SEAL_SHRINK | F_SEAL_GROW))
+    {
+        std::cerr << "Frame ring memfd is not sealed" << std::endl;
+        return false;
+    }
+
+    size_t min_header = page_align(sizeof(SharedRingHeader));
+    void *header = mmap(nullptr, min_header, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (header == MAP_FAILED)
+        return false;
+    SharedRingHeader *ring = static_cast<SharedRingHeader *>(header);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (ring->magic != SHARED_RING_MAGIC || ring->version != SHARED_RING_VERSION || ring->header_size != min_header ||
+        ring->slot_count < 2 || ring->slot_count > SHARED_RING_MAX_SLOTS)
+    {
+        std::cerr << "Frame ring layout mismatch" << std::endl;
+        munmap(header, min_header);
+        return false;
+    }
+
+    // 像素数据只读映射：读端无法改动写端发布的帧
+    size_t data_size = (size_t)ring->slot_size * ring->slot_count;
+    void *data = mmap(nullptr, data_size, PROT_READ, MAP_SHARED, fd, (off_t)ring->data_offset);
+    if (data == MAP_FAILED)
+    {
+        munmap(header, min_header);
+        return false;
+    }
+
+    // 登记租约，崩溃后由写端回收持有的槽位
+    // 租约表满时先回收已退出的读端再试一次（写端可能还没发现它们断开）
+    int lease = -1;
+    for (int attempt = 0; attempt < 2 && lease < 0; ++attempt)
+    {
+        if (attempt > 0)
+            reclaim_dead_readers(ring);
+        for (int i = 0; i < SHARED_RING_MAX_READERS && lease < 0; ++i)
+        {
+            int32_t expected = 0;
+            if (ring->leases[i].pid.compare_exchange_strong(expected, (int32_t)getpid(), std::memory_order_acq_rel))
+                lease = i;
+        }
+    }
+    if (lease < 0)
+    {
+        std::cerr << "Frame ring has no free reader lease" << std::endl;
+        munmap(data, data_size);
+        munmap(header, min_header);
+        return false;
+    }
+    ring->leases[lease].slot.store(-1, std::memory_order_release);
+
+    fd_ = fd;
+    writer_ = false;
+    header_ = ring;
+    header_size_ = min_header;
+    data_ = static_cast<uint8_t *>(data);
+    data_size_ = data_size;
+    lease_ = lease;
+    last_sequence_ = 0;
+    reader_stats_.connections++;
+    return true;
+}
+
+bool SharedFrameRing::writer_gone() const
+{
+    if (!header_)
+        return true;
+    if (socket_fd_ < 0)
+        return kill(header_->writer_pid, 0) != 0 && errno == ESRCH;
+    // 写端在发送 memfd 之后不再写入，可读即意味着对端关闭
+    struct pollfd pfd = {socket_fd_, POLLIN, 0};
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLIN | POLLHUP | POLLERR));
+}
+
+bool SharedFrameRing::wait_for_frame(int timeout_ms)
+{
+    if (!header_ || writer_)
+        return false;
+    uint32_t futex = header_->frame_futex.load(std::memory_order_acquire);
+    if (header_->latest_sequence.load(std::memory_order_acquire) > last_sequence_)
+        return true;
+    futex_wait(&header_->frame_futex, futex, timeout_ms);
+    return header_->latest_sequence.load(std::memory_order_acquire) > last_sequence_;
+}
+
+bool SharedFrameRing::acquire_latest(SharedFrameView &view)
+{
+    if (!header_ || writer_ || view.valid())
+        return false;
+
+    // latest 读出后写端可能已经改写那个槽位：CAS 失败说明它正在被写，重新读 latest
+    for (int attempt = 0; attempt < 8; ++attempt)
+    {
+        uint32_t latest = header_->latest.load(std::memory_order_acquire);
+        if (latest >= header_->slot_count)
+            return false;
+        SharedSlotHeader &slot = header_->slots[latest];
+        uint32_t readers = slot.readers.load(std::memory_order_acquire);
+        if (readers & kSlotWriting)
+            continue;
+        if (!slot.readers.compare_exchange_weak(readers, readers + 1, std::memory_order_acq_rel))
+            continue;
+        header_->leases[lease_].slot.store((int32_t)latest, std::memory_order_release);
+
+        uint64_t sequence = slot.info.sequence;
+        if (sequence <= last_sequence_)
+        {
+            // 仍是上一次取过的帧
+            view.slot = (int)latest;
+            release(view);
+            return false;
+        }
+        if (last_sequence_ && sequence > last_sequence_ + 1)
+            reader_stats_.skipped += sequence - last_sequence_ - 1;
+        last_sequence_ = sequence;
+        reader_stats_.acquired++;
+        view.slot = (int)latest;
+        view.data = data_ + (size_t)latest * header_->slot_size;
+        view.info = &slot.info;
+        view.caps = slot.caps;
+        return true;
+    }
+    return false;
+}
+
+void SharedFrameRing::release(SharedFrameView &view)
+{
+    // 环已关闭时视图指向的映射已经失效，只清空视图
+    if (!header_ || !view.valid())
+    {
+        view = SharedFrameView();
+        return;
+    }
+    header_->leases[lease_].slot.store(-1, std::memory_order_release);
+    header_->slots[view.slot].readers.fetch_sub(1, std::memory_order_acq_rel);
+    header_->release_futex.fetch_add(1, std::memory_order_release);
+    futex_wake(&header_->release_futex);
+    view = SharedFrameView();
+}
+
+void SharedFrameRing::close()
+{
+    unmap();
+    if (socket_fd_ >= 0)
+        ::close(socket_fd_);
+    socket_fd_ = -1;
+    disconnect_readers();
+    if (listen_fd_ >= 0)
+    {
+        ::close(listen_fd_);
+        unlink(listen_path_.c_str());
+    }
+    listen_fd_ = -1;
+}
+
+void SharedFrameRing::unmap()
+{
+    if (header_ && !writer_ && lease_ >= 0)
+    {
+        int32_t slot = header_->leases[lease_].slot.exchange(-1, std::memory_order_acq_rel);
+        if (slot >= 0)
+            header_->slots[slot].readers.fetch_sub(1, std::memory_order_acq_rel);
+        header_->leases[lease_].pid.store(0, std::memory_order_release);
+    }
+    if (data_)
+        munmap(data_, data_size_);
+    if (header_)
+        munmap(header_, header_size_);
+    data_ = nullptr;
+    header_ = nullptr;
+    lease_ = -1;
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+    writer_ = false;
+    writing_ = -1;
+}
+
+#else
+
+bool SharedFrameRing::create(size_t, int)
+{
+    std::cerr << "Shared frame ring needs Linux memfd" << std::endl;
+    return false;
+}
+uint8_t *SharedFrameRing::begin_write(size_t, int) { return nullptr; }
+void SharedFrameRing::commit_write(const SharedFrameInfo &, const char *) {}
+bool SharedFrameRing::listen(const std::string &) { return false; }
+void SharedFrameRing::accept_readers() {}
+void SharedFrameRing::disconnect_readers() {}
+bool SharedFrameRing::connect(const std::string &) { return false; }
+bool SharedFrameRing::attach(int) { return false; }
+bool SharedFrameRing::writer_gone() const { return true; }
+bool SharedFrameRing::wait_for_frame(int) { return false; }
+bool SharedFrameRing::acquire_latest(SharedFrameView &) { return false; }
+void SharedFrameRing::release(SharedFrameView &view) { view = SharedFrameView(); }
+void SharedFrameRing::close() {}
+void SharedFrameRing::unmap() {}
+void SharedFrameRing::reclaim_dead_readers(SharedRingHeader *) {}
+
+#endif
@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 共享内存帧环（Linux memfd）：一个解码进程写，多个渲染进程读，像素数据只在解码端写入一次。
+//
+// 内存布局（一个 memfd，创建后用 F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL 封住尺寸，映射后不会因截断收到 SIGBUS）：
+//   [0, header_size)                          RingHeader，读写两端都映射为可写（计数、futex 字、租约）
+//   [data_offset + i * slot_size, +slot_size)  槽位 i 的像素数据，读端只读映射
+//   header_size、data_offset、slot_size 都按页对齐
+//
+// 槽位状态由 SlotHeader::readers 表示：0 空闲，kSlotWriting 写端正在写，其余为持有该槽位的读者数。
+//   写端：选一个不是最新帧、也没有读者的槽位，CAS 0 -> kSlotWriting 后写入；写完把读者数清零、latest 指向它，
+//         frame_futex 加一并唤醒读者。所有槽位都被读者持有时在 release_futex 上等待（反压），超时丢弃这一帧。
+//   读端：只取 latest 指向的槽位（最新帧优先，来不及取的帧直接跳过），读者数 CAS 加一之后内容不再变化，
+//         上传完成后减一并唤醒写端。已发布的槽位在所有读者释放之前对写端封闭。
+// 读者在租约表中登记 pid 和持有的槽位，读端进程崩溃后写端在没有空闲槽位时回收它持有的槽位。
+// memfd 通过 Unix 域套接字（SCM_RIGHTS）交给读端，连接一直保持：写端退出或重启时读端看到连接断开，
+// 保留最后一帧并重新连接，写端重启后创建新的 memfd。
+// 非 Linux 平台上所有操作都返回失败。
+
+#define SHARED_RING_MAGIC 0x52465347u // "GSFR"
+#define SHARED_RING_VERSION 1
+#define SHARED_RING_MAX_SLOTS 8
+#define SHARED_RING_MAX_READERS 16
+#define SHARED_RING_CAPS_SIZE 1024
+
+// 一帧的描述，写端发布前填写，读端持有期间不变
+struct SharedFrameInfo
+{
+    uint64_t sequence = 0;  // 写端发布顺序，从 1 开始
+    int64_t pts = -1;       // 运行时间（纳秒），没有时为 -1
+    uint32_t size = 0;      // 像素数据字节数
+    uint32_t n_planes = 0;
+    int32_t stride[4] = {};
+    uint64_t offset[4] = {}; // 相对槽位数据起点
+};
+
+struct SharedSlotHeader
+{
+    std::atomic<uint32_t> readers;
+    uint32_t reserved;
+    SharedFrameInfo info;
+    char caps[SHARED_RING_CAPS_SIZE]; // 帧的 caps 字符串
+};
+
+struct SharedReaderLease
+{
+    std::atomic<int32_t> pid;  // 0 表示空闲
+    std::atomic<int32_t> slot; // 持有的槽位，-1 表示没有
+};
+
+struct SharedRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t header_size;
+    uint64_t slot_size;
+    uint64_t data_offset;
+    int32_t writer_pid;
+    uint32_t reserved;
+    std::atomic<uint32_t> latest;          // 最新帧的槽位，kNoSlot 表示还没有
+    std::atomic<uint32_t> frame_futex;     // 每发布一帧加一，读端在上面等待
+    std::atomic<uint32_t> release_futex;   // 每释放一个槽位加一，写端反压时在上面等待
+    std::atomic<uint32_t> reserved_futex;
+    std::atomic<uint64_t> latest_sequence; // latest 指向的帧的序号
+    std::atomic<uint64_t> published;       // 写端统计：发布 / 因反压丢弃 / 从崩溃读者回收的槽位
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> reclaimed;
+    SharedReaderLease leases[SHARED_RING_MAX_READERS];
+    SharedSlotHeader slots[SHARED_RING_MAX_SLOTS];
+};
+
+// 读端持有的一帧，释放前 data 与 info 一直有效
+struct SharedFrameView
+{
+    int slot = -1;
+    const uint8_t *data = nullptr; // 直接指向共享映射，不拷贝
+    const SharedFrameInfo *info = nullptr;
+    const char *caps = nullptr;
+    bool valid() const { return slot >= 0; }
+};
+
+// 读端统计
+struct SharedReaderStats
+{
+    uint64_t acquired = 0;    // 取到的帧
+    uint64_t skipped = 0;     // 序号跳过的帧（最新帧优先）
+    uint64_t connections = 0; // 连接成功的次数，大于 1 表示写端重启过
+};
+
+class SharedFrameRing
+{
+public:
+    static const uint32_t kNoSlot = 0xFFFFFFFFu;
+    static const uint32_t kSlotWriting = 0x80000000u;
+
+    SharedFrameRing();
+    ~SharedFrameRing();
+
+    SharedFrameRing(const SharedFrameRing &) = delete;
+    SharedFrameRing &operator=(const SharedFrameRing &) = delete;
+
+    // ---- 写端 ----
+    // 创建 slot_count 个至少 slot_size 字节的槽位并封住尺寸
+    bool create(size_t slot_size, int slot_count);
+    // 取一个可写的槽位，所有槽位都被读者持有时最多等待 timeout_ms，仍没有则返回 nullptr（计为丢弃）
+    uint8_t *begin_write(size_t size, int timeout_ms);
+    // 发布刚写完的槽位，info.sequence 由这里填写
+    void commit_write(const SharedFrameInfo &info, const char *caps);
+    // 在 path 上监听读端连接，accept_readers 把 memfd 交给新连接的读端
+    bool listen(const std::string &path);
+    void accept_readers();
+    // 断开所有读端（它们会重新连接），用于重建环
+    void disconnect_readers();
+
+    // ---- 读端 ----
+    // 连接 path 上的写端，取得 memfd 并映射
+    bool connect(const std::string &path);
+    // 直接映射一个 memfd（测试或其他传递方式）
+    bool attach(int fd);
+    bool connected() const { return header_ != nullptr && !writer_; }
+    // 写端退出或重启（连接断开）
+    bool writer_gone() const;
+    // 等到有比上次取到的更新的帧，超时返回 false
+    bool wait_for_frame(int timeout_ms);
+    // 取最新的一帧，没有新帧或与写端竞争失败返回 false
+    bool acquire_latest(SharedFrameView &view);
+    void release(SharedFrameView &view);
+    const SharedReaderStats &reader_stats() const { return reader_stats_; }
+
+    // 两端共用
+    void close();
+    int fd() const { return fd_; }
+    const SharedRingHeader *header() const { return header_; }
+    size_t slot_size() const { return header_ ? (size_t)header_->slot_size : 0; }
+    int slot_count() const { return header_ ? (int)header_->slot_count : 0; }
+
+private:
+    // 读端和写端都可以调用：槽位与 pid 都用原子交换清除，不会重复回收
+    static void reclaim_dead_readers(SharedRingHeader *header);
+    void unmap();
+
+    int fd_;
+    bool writer_;
+    SharedRingHeader *header_;
+    size_t header_size_;
+    uint8_t *data_;       // 写端可写映射，读端只读映射
+    size_t data_size_;
+    int writing_;         // 写端正在写的槽位
+    uint64_t sequence_;   // 写端最后发布的序号
+    int listen_fd_;       // 写端监听套接字
+    int client_fds_[SHARED_RING_MAX_READERS]; // 写端保持的读端连接
+    std::string listen_path_;
+    int socket_fd_;       // 读端与写端的连接
+    int lease_;           // 读端在租约表中的位置
+    uint64_t last_sequence_;
+    SharedReaderStats reader_stats_;
+};
@@ -0,0 +1,176 @@
+#include "StreamSync.hpp"
+
+#include <iostream>
+
+// 等待预卷的上限，本地文件通常几十毫秒内完成
+#define PREROLL_TIMEOUT (10 * GST_SECOND)
+
+StreamSync::StreamSync()
+    : clock_(nullptr), base_time_(GST_CLOCK_TIME_NONE)
+{
+}
+
+StreamSync::~StreamSync()
+{
+    if (clock_)
+        gst_object_unref(clock_);
+}
+
+void StreamSync::configure_appsink(GstElement *appsink)
+{
+    // 由渲染线程按运行时间选帧，appsink 本身不等时钟；不丢帧，队列满时反压解码
+    g_object_set(appsink, "emit-signals", FALSE, "sync", FALSE, "max-buffers", 3, "drop", FALSE, nullptr);
+}
+
+bool StreamSync::start(const std::vector<GstElement *> &pipelines, GstClockTime start_delay)
+{
+    if (pipelines.empty())
+        return false;
+    if (!clock_)
+        clock_ = gst_system_clock_obtain();
+    skew_ = SkewStats();
+
+    for (GstElement *pipeline : pipelines)
+    {
+        gst_pipeline_use_clock(GST_PIPELINE(pipeline), clock_);
+        // 不让管道在 PAUSED -> PLAYING 时自己重新选 base time
+        gst_element_set_start_time(pipeline, GST_CLOCK_TIME_NONE);
+        if (gst_element_set_state(pipeline, GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
+        {
+            std::cerr << "Failed to pause pipeline for synchronized start" << std::endl;
+            return false;
+        }
+    }
+
+    // 预卷完成后各路的第一帧已经在 appsink 中，同时开始不会因为打开文件的快慢产生偏差。
+    // 直播源返回 NO_PREROLL，不需要等
+    for (GstElement *pipeline : pipelines)
+    {
+        GstStateChangeReturn ret = gst_element_get_state(pipeline, nullptr, nullptr, PREROLL_TIMEOUT);
+        if (ret == GST_STATE_CHANGE_FAILURE)
+        {
+            std::cerr << "Pipeline failed to preroll" << std::endl;
+            return false;
+        }
+        if (ret == GST_STATE_CHANGE_ASYNC)
+            std::cerr << "Pipeline did not preroll in time, starting anyway" << std::endl;
+    }
+
+    base_time_ = gst_clock_get_time(clock_) + start_delay;
+    for (GstElement *pipeline : pipelines)
+    {
+        gst_element_set_base_time(pipeline, base_time_);
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    }
+    return true;
+}
+
+void StreamSync::stop()
+{
+    base_time_ = GST_CLOCK_TIME_NONE;
+}
+
+GstClockTime StreamSync::running_time() const
+{
+    if (!clock_ || !GST_CLOCK_TIME_IS_VALID(base_time_))
+        return 0;
+    GstClockTime now = gst_clock_get_time(clock_);
+    return now > base_time_ ? now - base_time_ : 0;
+}
+
+// 同一个 base time 下各路的运行时间可以直接比较
+GstClockTime sample_running_time(GstSample *sample)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    const GstSegment *segment = gst_sample_get_segment(sample);
+    if (!buffer || !segment || segment->format != GST_FORMAT_TIME || !GST_BUFFER_PTS_IS_VALID(buffer))
+        return GST_CLOCK_TIME_NONE;
+    return gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+}
+
+GstSample *StreamSync::pull_due(SyncedSink &sink, GstClockTime target)
+{
+    GstSample *due = nullptr;
+    GstClockTime due_time = GST_CLOCK_TIME_NONE;
+    while (true)
+    {
+        if (!sink.pending)
+        {
+            sink.pending = gst_app_sink_try_pull_sample(sink.appsink, 0);
+            if (!sink.pending)
+                break;
+            sink.pulled++;
+            GstClockTime previous = sink.pending_time;
+            sink.pending_time = sample_running_time(sink.pending);
+            GstBuffer *buffer = gst_sample_get_buffer(sink.pending);
+            if (buffer && GST_BUFFER_DURATION_IS_VALID(buffer))
+                sink.frame_duration = GST_BUFFER_DURATION(buffer);
+            else if (GST_CLOCK_TIME_IS_VALID(previous) && GST_CLOCK_TIME_IS_VALID(sink.pending_time) &&
+                     sink.pending_time > previous)
+                sink.frame_duration = sink.pending_time - previous;
+        }
+        // 没有时间戳的帧立即显示
+        if (GST_CLOCK_TIME_IS_VALID(sink.pending_time) && sink.pending_time > target)
+            break;
+
+        // 同一次选帧中有更新的到期帧时，较早的一帧不再显示
+        if (due)
+        {
+            gst_sample_unref(due);
+            sink.skipped++;
+        }
+        due = sink.pending;
+        due_time = sink.pending_time;
+        sink.pending = nullptr;
+    }
+    if (due)
+    {
+        sink.shown_time = due_time;
+        sink.shown++;
+    }
+    return due;
+}
+
+void StreamSync::reset(SyncedSink &sink)
+{
+    if (sink.pending)
+    {
+        gst_sample_unref(sink.pending);
+        sink.pending = nullptr;
+    }
+    sink.pending_time = GST_CLOCK_TIME_NONE;
+    sink.shown_time = GST_CLOCK_TIME_NONE;
+}
+
+void StreamSync::record_skew(const std::vector<const SyncedSink *> &sinks)
+{
+    GstClockTime earliest = GST_CLOCK_TIME_NONE, latest = 0, frame = GST_CLOCK_TIME_NONE;
+    int counted = 0;
+    for (const SyncedSink *sink : sinks)
+    {
+        if (!sink->active || !GST_CLOCK_TIME_IS_VALID(sink->shown_time))
+            continue;
+        if (!GST_CLOCK_TIME_IS_VALID(earliest) || sink->shown_time < earliest)
+            earliest = sink->shown_time;
+        if (sink->shown_time > latest)
+            latest = sink->shown_time;
+        if (GST_CLOCK_TIME_IS_VALID(sink->frame_duration) &&
+            (!GST_CLOCK_TIME_IS_VALID(frame) || sink->frame_duration < frame))
+            frame = sink->frame_duration;
+        counted++;
+    }
+    if (counted < 2)
+        return;
+
+    double skew_ms = (double)(latest - earliest) / GST_MSECOND;
+    skew_.samples++;
+    skew_.sum_ms += skew_ms;
+    if (skew_ms > skew_.max_ms)
+        skew_.max_ms = skew_ms;
+    if (GST_CLOCK_TIME_IS_VALID(frame))
+    {
+        skew_.frame_ms = (double)frame / GST_MSECOND;
+        if (latest - earliest >= frame)
+            skew_.over_frame++;
+    }
+}
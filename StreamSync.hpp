@@ -0,0 +1,72 @@
+#pragma once
+#include "gst/gst.h"
+#include "gst/app/gstappsink.h"
+
+#include <cstdint>
+#include <vector>
+
+// sample 的 PTS 换算成运行时间，没有时间戳或不是时间段时返回 GST_CLOCK_TIME_NONE
+GstClockTime sample_running_time(GstSample *sample);
+
+// 多路之间的呈现偏差统计（毫秒）
+struct SkewStats
+{
+    uint64_t samples = 0;      // 记录次数（每次有新帧的绘制）
+    double sum_ms = 0.0;
+    double max_ms = 0.0;
+    uint64_t over_frame = 0;   // 偏差超过一帧时长的次数
+    double frame_ms = 0.0;     // 参考帧时长（最短的帧间隔）
+};
+
+// 一路在渲染端的选帧状态（只在渲染线程上使用）
+struct SyncedSink
+{
+    GstAppSink *appsink = nullptr;
+    GstSample *pending = nullptr;                   // 已取出但还未到期的下一帧
+    GstClockTime pending_time = GST_CLOCK_TIME_NONE; // pending 的运行时间
+    GstClockTime shown_time = GST_CLOCK_TIME_NONE;   // 当前显示帧的运行时间
+    GstClockTime frame_duration = GST_CLOCK_TIME_NONE;
+    uint64_t pulled = 0;                            // 从 appsink 取出的帧
+    uint64_t shown = 0;                             // 选中显示的帧
+    uint64_t skipped = 0;                           // 到期但被更新的帧取代、从未显示的帧
+    bool active = true;                             // 结束或出错的路不参与偏差统计
+};
+
+// 多条管道共用一个时钟和 base time：各自的运行时间可以直接比较。
+// appsink 不同步（sync=false、不丢帧），渲染线程按共同的运行时间从每路取出最新的到期帧，
+// 同一时刻各路显示的是 PTS 相同（或最接近）的帧
+class StreamSync
+{
+public:
+    StreamSync();
+    ~StreamSync();
+
+    StreamSync(const StreamSync &) = delete;
+    StreamSync &operator=(const StreamSync &) = delete;
+
+    // 把 appsink 设置成由渲染端选帧（在启动管道前调用）
+    static void configure_appsink(GstElement *appsink);
+
+    // 所有管道使用系统时钟并预卷，然后以同一个 base time（当前时间 + start_delay）进入 PLAYING
+    bool start(const std::vector<GstElement *> &pipelines, GstClockTime start_delay = 100 * GST_MSECOND);
+    void stop();
+
+    // 当前的共同运行时间
+    GstClockTime running_time() const;
+    GstClockTime base_time() const { return base_time_; }
+    GstClock *clock() const { return clock_; }
+
+    // 取出运行时间不晚于 target 的最新一帧（更早的到期帧丢弃），没有新到期的帧返回 nullptr。调用者释放返回的 sample
+    static GstSample *pull_due(SyncedSink &sink, GstClockTime target);
+    // 释放 pending
+    static void reset(SyncedSink &sink);
+
+    // 记录各活动路当前显示帧之间的最大运行时间差
+    void record_skew(const std::vector<const SyncedSink *> &sinks);
+    const SkewStats &skew() const { return skew_; }
+
+private:
+    GstClock *clock_;
+    GstClockTime base_time_;
+    SkewStats skew_;
+};
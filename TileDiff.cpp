@@ -0,0 +1,210 @@
+#include "TileDiff.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TILE_DIFF_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// 支持 target 属性的编译器无需全局开启 -mavx2，由运行时检测决定是否调用
+#if defined(TILE_DIFF_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TILE_DIFF_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TILE_DIFF_TARGET_AVX2
+#endif
+
+bool tile_bytes_equal_scalar(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        if (x != y)
+            return false;
+    }
+    for (; i < size; ++i)
+    {
+        if (a[i] != b[i])
+            return false;
+    }
+    return true;
+}
+
+#ifdef TILE_DIFF_X86
+static bool tile_bytes_equal_sse2(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF)
+            return false;
+    }
+    return tile_bytes_equal_scalar(a + i, b + i, size - i);
+}
+
+TILE_DIFF_TARGET_AVX2 static bool tile_bytes_equal_avx2(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        if ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != 0xFFFFFFFFu)
+            return false;
+    }
+    return tile_bytes_equal_sse2(a + i, b + i, size - i);
+}
+
+static bool cpu_has_avx2()
+{
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+typedef bool (*BytesEqualFn)(const uint8_t *, const uint8_t *, size_t);
+
+struct TileDiffDispatch
+{
+    BytesEqualFn equal = tile_bytes_equal_scalar;
+    const char *name = "scalar";
+
+    TileDiffDispatch()
+    {
+#ifdef TILE_DIFF_X86
+        if (cpu_has_avx2())
+        {
+            equal = tile_bytes_equal_avx2;
+            name = "avx2";
+        }
+        else
+        {
+            // x86-64 总是支持 SSE2
+            equal = tile_bytes_equal_sse2;
+            name = "sse2";
+        }
+#endif
+    }
+};
+
+static const TileDiffDispatch &dispatch()
+{
+    static TileDiffDispatch instance;
+    return instance;
+}
+
+const char *tile_diff_simd_name()
+{
+    return dispatch().name;
+}
+
+bool tile_bytes_equal(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    return dispatch().equal(a, b, size);
+}
+
+TileDiff::TileDiff(int tile_size)
+    : tile_size_(tile_size > 0 ? tile_size : 64),
+      width_(0), height_(0), bytes_per_pixel_(0), valid_(false),
+      total_tiles_(0), changed_tiles_(0), changed_bytes_(0)
+{
+}
+
+void TileDiff::reset()
+{
+    valid_ = false;
+}
+
+const std::vector<TileRect> &TileDiff::diff(const uint8_t *pixels, int stride, int width, int height, int bytes_per_pixel)
+{
+    BytesEqualFn equal = dispatch().equal;
+    size_t row_bytes = (size_t)width * bytes_per_pixel;
+
+    if (width != width_ || height != height_ || bytes_per_pixel != bytes_per_pixel_)
+    {
+        width_ = width;
+        height_ = height;
+        bytes_per_pixel_ = bytes_per_pixel;
+        previous_.assign(row_bytes * height, 0);
+        valid_ = false;
+    }
+
+    int tiles_x = (width + tile_size_ - 1) / tile_size_;
+    int tiles_y = (height + tile_size_ - 1) / tile_size_;
+    total_tiles_ = (size_t)tiles_x * tiles_y;
+    changed_tiles_ = 0;
+    changed_bytes_ = 0;
+    rects_.clear();
+
+    for (int ty = 0; ty < tiles_y; ++ty)
+    {
+        int y0 = ty * tile_size_;
+        int rows = height - y0 < tile_size_ ? height - y0 : tile_size_;
+        TileRect run; // 当前行中正在合并的脏块
+        run.width = 0;
+
+        for (int tx = 0; tx < tiles_x; ++tx)
+        {
+            int x0 = tx * tile_size_;
+            int cols = width - x0 < tile_size_ ? width - x0 : tile_size_;
+            size_t offset = (size_t)x0 * bytes_per_pixel;
+            size_t bytes = (size_t)cols * bytes_per_pixel;
+
+            // 第一行不同就可以停止比较，之后整块拷贝进副本
+            bool dirty = !valid_;
+            for (int y = y0; !dirty && y < y0 + rows; ++y)
+                dirty = !equal(pixels + (size_t)y * stride + offset, previous_.data() + (size_t)y * row_bytes + offset, bytes);
+
+            if (dirty)
+            {
+                for (int y = y0; y < y0 + rows; ++y)
+                    memcpy(previous_.data() + (size_t)y * row_bytes + offset, pixels + (size_t)y * stride + offset, bytes);
+                changed_tiles_++;
+                changed_bytes_ += bytes * rows;
+
+                if (run.width > 0)
+                {
+                    run.width += cols;
+                }
+                else
+                {
+                    run.x = x0;
+                    run.y = y0;
+                    run.width = cols;
+                    run.height = rows;
+                }
+            }
+            else if (run.width > 0)
+            {
+                rects_.push_back(run);
+                run.width = 0;
+            }
+        }
+        if (run.width > 0)
+            rects_.push_back(run);
+    }
+
+    valid_ = true;
+    return rects_;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 需要重新上传的矩形（单位为 texel）
+struct TileRect
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// 按块比较相邻两帧，找出发生变化的区域。
+// 保存上一帧的紧密排列副本，比较使用 AVX2/SSE2（运行时检测），不支持时退回标量实现。
+// 同一行中相邻的脏块合并为一个矩形，减少 glTexSubImage2D 调用次数。
+class TileDiff
+{
+public:
+    explicit TileDiff(int tile_size = 64);
+
+    // 比较 pixels 与上一帧并更新副本，返回本帧需要上传的矩形。
+    // 尺寸变化或 reset() 之后的第一帧整帧视为脏区
+    const std::vector<TileRect> &diff(const uint8_t *pixels, int stride, int width, int height, int bytes_per_pixel);
+    // 纹理重新分配后调用，下一帧整帧上传
+    void reset();
+
+    // 最近一帧的统计
+    size_t total_tiles() const { return total_tiles_; }
+    size_t changed_tiles() const { return changed_tiles_; }
+    size_t changed_bytes() const { return changed_bytes_; }
+    size_t frame_bytes() const { return (size_t)width_ * height_ * bytes_per_pixel_; }
+
+private:
+    int tile_size_;
+    int width_;
+    int height_;
+    int bytes_per_pixel_;
+    bool valid_;                    // 副本是否对应已上传的纹理内容
+    std::vector<uint8_t> previous_; // 上一帧，行宽 width_ * bytes_per_pixel_
+    std::vector<TileRect> rects_;
+
+    size_t total_tiles_;
+    size_t changed_tiles_;
+    size_t changed_bytes_;
+};
+
+// 当前使用的比较实现："avx2"、"sse2" 或 "scalar"
+const char *tile_diff_simd_name();
+// 判断两段内存是否相同（按运行时检测到的指令集分派）
+bool tile_bytes_equal(const uint8_t *a, const uint8_t *b, size_t size);
+// 标量实现，供测试对照
+bool tile_bytes_equal_scalar(const uint8_t *a, const uint8_t *b, size_t size);
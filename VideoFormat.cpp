@@ -0,0 +1,171 @@
+#include "VideoFormat.hpp"
+
+static void set_plane(PlaneLayout &plane, int width, int height, int bytes_per_pixel,
+                      GLenum internal_format, GLenum gl_format)
+{
+    plane.width = width;
+    plane.height = height;
+    plane.bytes_per_pixel = bytes_per_pixel;
+    plane.internal_format = internal_format;
+    plane.gl_format = gl_format;
+}
+
+bool frame_layout_from_info(const GstVideoInfo &info, const gint *strides, const gsize *offsets, FrameLayout &layout)
+{
+    GstVideoFormat format = GST_VIDEO_INFO_FORMAT(&info);
+    int width = GST_VIDEO_INFO_WIDTH(&info);
+    int height = GST_VIDEO_INFO_HEIGHT(&info);
+    // 4:2:0 / 4:2:2 色度尺寸向上取整
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = (height + 1) / 2;
+
+    layout = FrameLayout();
+    layout.format = format;
+    layout.width = width;
+    layout.height = height;
+    if (GST_VIDEO_INFO_PAR_N(&info) > 0 && GST_VIDEO_INFO_PAR_D(&info) > 0)
+    {
+        layout.par_n = GST_VIDEO_INFO_PAR_N(&info);
+        layout.par_d = GST_VIDEO_INFO_PAR_D(&info);
+    }
+
+    switch (format)
+    {
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_BGRA:
+        layout.n_planes = 1;
+        layout.shader = VideoShader::Rgba;
+        set_plane(layout.planes[0], width, height, 4, GL_RGBA8, format == GST_VIDEO_FORMAT_BGRA ? GL_BGRA : GL_RGBA);
+        break;
+    case GST_VIDEO_FORMAT_I420:
+        layout.n_planes = 3;
+        layout.shader = VideoShader::I420;
+        set_plane(layout.planes[0], width, height, 1, GL_R8, GL_RED);
+        set_plane(layout.planes[1], chroma_width, chroma_height, 1, GL_R8, GL_RED);
+        set_plane(layout.planes[2], chroma_width, chroma_height, 1, GL_R8, GL_RED);
+        break;
+    case GST_VIDEO_FORMAT_NV12:
+        layout.n_planes = 2;
+        layout.shader = VideoShader::Nv12;
+        set_plane(layout.planes[0], width, height, 1, GL_R8, GL_RED);
+        set_plane(layout.planes[1], chroma_width, chroma_height, 2, GL_RG8, GL_RG);
+        break;
+    case GST_VIDEO_FORMAT_YUY2:
+        // 每个 RGBA texel 为 Y0 U Y1 V 两个像素，在着色器中按奇偶取亮度
+        layout.n_planes = 1;
+        layout.shader = VideoShader::Yuy2;
+        set_plane(layout.planes[0], chroma_width, height, 4, GL_RGBA8, GL_RGBA);
+        break;
+    default:
+        return false;
+    }
+
+    for (int i = 0; i < layout.n_planes; ++i)
+    {
+        layout.planes[i].stride = GST_VIDEO_INFO_PLANE_STRIDE(&info, i);
+        layout.planes[i].offset = GST_VIDEO_INFO_PLANE_OFFSET(&info, i);
+    }
+    if (!frame_layout_apply_planes(layout, strides, offsets))
+        return false;
+
+    if (layout.shader != VideoShader::Rgba)
+        yuv_to_rgb_matrix(info.colorimetry, height, layout.color_matrix);
+    return true;
+}
+
+bool frame_layout_apply_planes(FrameLayout &layout, const gint *strides, const gsize *offsets)
+{
+    for (int i = 0; i < layout.n_planes; ++i)
+    {
+        PlaneLayout &plane = layout.planes[i];
+        if (strides)
+            plane.stride = strides[i];
+        if (offsets)
+            plane.offset = offsets[i];
+        if (plane.stride < plane.width * plane.bytes_per_pixel)
+            return false;
+    }
+    return true;
+}
+
+void yuv_to_rgb_matrix(const GstVideoColorimetry &colorimetry, int height, float matrix[16])
+{
+    // 亮度/色度系数；未标注时按分辨率猜测：SD 为 BT.601，HD 为 BT.709
+    gdouble Kr = 0.0, Kb = 0.0;
+    if (!gst_video_color_matrix_get_Kr_Kb(colorimetry.matrix, &Kr, &Kb))
+        gst_video_color_matrix_get_Kr_Kb(height > 576 ? GST_VIDEO_COLOR_MATRIX_BT709 : GST_VIDEO_COLOR_MATRIX_BT601, &Kr, &Kb);
+    double Kg = 1.0 - Kr - Kb;
+
+    // 取值范围：限制范围 Y 为 [16,235]，UV 为 [16,240]
+    bool full_range = colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255;
+    double y_scale = full_range ? 1.0 : 255.0 / 219.0;
+    double y_offset = full_range ? 0.0 : 16.0 / 255.0;
+    double c_scale = full_range ? 1.0 : 255.0 / 224.0;
+    double c_offset = 128.0 / 255.0;
+
+    // R = Y + a*V, G = Y - b*U - c*V, B = Y + d*U
+    double a = 2.0 * (1.0 - Kr);
+    double b = 2.0 * Kb * (1.0 - Kb) / Kg;
+    double c = 2.0 * Kr * (1.0 - Kr) / Kg;
+    double d = 2.0 * (1.0 - Kb);
+
+    // 把范围展开合并进矩阵，着色器中只需一次矩阵乘法
+    const double rows[3][4] = {
+        {y_scale, 0.0, a * c_scale, -y_scale * y_offset - a * c_scale * c_offset},
+        {y_scale, -b * c_scale, -c * c_scale, -y_scale * y_offset + (b + c) * c_scale * c_offset},
+        {y_scale, d * c_scale, 0.0, -y_scale * y_offset - d * c_scale * c_offset},
+    };
+    for (int row = 0; row < 3; ++row)
+        for (int col = 0; col < 4; ++col)
+            matrix[row * 4 + col] = (float)rows[row][col];
+    matrix[12] = 0.0f;
+    matrix[13] = 0.0f;
+    matrix[14] = 0.0f;
+    matrix[15] = 1.0f;
+}
+
+const char *appsink_video_caps(bool native_yuv, GLenum rgba_format)
+{
+    // YUV 格式排在前面，解码器输出可以直接透传；打包格式按驱动偏好排序
+    if (native_yuv)
+        return rgba_format == GL_BGRA ? "video/x-raw,format=(string){NV12,I420,YUY2,BGRA,RGBA}"
+                                      : "video/x-raw,format=(string){NV12,I420,YUY2,RGBA,BGRA}";
+    return rgba_format == GL_BGRA ? "video/x-raw,format=(string){BGRA,RGBA}"
+                                  : "video/x-raw,format=(string){RGBA,BGRA}";
+}
+
+std::shared_ptr<const VideoDescriptor> VideoDescriptorCache::get(GstCaps *caps)
+{
+    // 热路径：同一次协商的 sample 共享同一个 caps 对象
+    if (caps == caps_)
+        return descriptor_;
+
+    parses_++;
+    gst_caps_replace(&caps_, caps);
+
+    GstVideoInfo info;
+    if (!caps || !gst_video_info_from_caps(&info, caps))
+    {
+        descriptor_.reset();
+        return descriptor_;
+    }
+    if (descriptor_ && gst_video_info_is_equal(&info, &descriptor_->info))
+        return descriptor_;
+
+    auto descriptor = std::make_shared<VideoDescriptor>();
+    descriptor->info = info;
+    if (!frame_layout_from_info(info, nullptr, nullptr, descriptor->layout))
+    {
+        descriptor_.reset();
+        return descriptor_;
+    }
+    descriptor->generation = ++generation_;
+    descriptor_ = descriptor;
+    return descriptor_;
+}
+
+void VideoDescriptorCache::reset()
+{
+    gst_caps_replace(&caps_, nullptr);
+    descriptor_.reset();
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "gst/gst.h"
+#include "gst/video/video.h"
+#include "glad/glad.h"
+
+#include "gl_utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 单帧最多的平面数（I420 为 3）
+#define MAX_VIDEO_PLANES 3
+
+// 一个平面在内存中的布局及对应的纹理格式
+struct PlaneLayout
+{
+    int width = 0;                     // 纹理宽度（texel）
+    int height = 0;                    // 纹理高度
+    int stride = 0;                    // 每行字节数，来自 GstVideoMeta/GstVideoInfo
+    size_t offset = 0;                 // 相对帧数据起点的偏移
+    int bytes_per_pixel = 4;           // 每个 texel 的字节数
+    GLenum internal_format = GL_RGBA8; // 纹理内部格式
+    GLenum gl_format = GL_RGBA;        // 上传时的外部格式
+
+    // 从第一个像素到最后一个像素覆盖的字节数
+    size_t span() const { return height > 0 ? (size_t)stride * (height - 1) + (size_t)width * bytes_per_pixel : 0; }
+};
+
+// 一帧视频的平面布局，YUV 格式附带颜色转换矩阵
+struct FrameLayout
+{
+    GstVideoFormat format = GST_VIDEO_FORMAT_UNKNOWN;
+    int width = 0;
+    int height = 0;
+    int n_planes = 0;
+    PlaneLayout planes[MAX_VIDEO_PLANES];
+    VideoShader shader = VideoShader::Rgba;
+    // YUV -> RGB 矩阵（行主序，作用于 vec4(Y, U, V, 1)，已包含范围偏移与缩放）
+    float color_matrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    // 像素宽高比，决定显示宽高比与黑边
+    int par_n = 1;
+    int par_d = 1;
+
+    double display_width() const { return (double)width * par_n / par_d; }
+
+    // 纹理是否需要重新分配
+    bool same_textures(const FrameLayout &other) const
+    {
+        return format == other.format && width == other.width && height == other.height;
+    }
+};
+
+// 根据 GstVideoInfo 填充布局，strides/offsets 来自 GstVideoFrame 或 GstVideoMeta，
+// 为 nullptr 时使用 info 中的默认值；不支持的格式或步长不足返回 false
+bool frame_layout_from_info(const GstVideoInfo &info, const gint *strides, const gsize *offsets, FrameLayout &layout);
+
+// 用实际映射或 GstVideoMeta 给出的步长/偏移覆盖默认值（为 nullptr 时保持不变），步长不足返回 false
+bool frame_layout_apply_planes(FrameLayout &layout, const gint *strides, const gsize *offsets);
+
+// 按色彩空间（BT.601/709/2020）和取值范围计算 YUV -> RGB 矩阵
+void yuv_to_rgb_matrix(const GstVideoColorimetry &colorimetry, int height, float matrix[16]);
+
+// appsink 可接受的格式列表，native_yuv 为 false 时只接受打包 RGBA/BGRA
+const char *appsink_video_caps(bool native_yuv, GLenum rgba_format);
+
+// 一次协商得到的不可变描述：解析后的 GstVideoInfo、默认平面布局与着色器变体。
+// 生产者线程按 caps 创建一次，随每帧交给渲染线程，渲染线程不再解析 caps
+struct VideoDescriptor
+{
+    GstVideoInfo info;
+    FrameLayout layout;      // 按 info 的默认步长与偏移
+    uint64_t generation = 0; // GstVideoInfo 每变化一次加一
+};
+
+// caps -> 描述的缓存，只在生产者线程上使用。caps 指针不变时直接返回上次的结果，
+// 内容相同的新 caps 对象沿用原描述
+class VideoDescriptorCache
+{
+public:
+    VideoDescriptorCache() = default;
+    ~VideoDescriptorCache() { reset(); }
+
+    VideoDescriptorCache(const VideoDescriptorCache &) = delete;
+    VideoDescriptorCache &operator=(const VideoDescriptorCache &) = delete;
+
+    // 不支持的格式返回空指针
+    std::shared_ptr<const VideoDescriptor> get(GstCaps *caps);
+    void reset();
+
+    uint64_t parses() const { return parses_; }
+    uint64_t generation() const { return generation_; }
+
+private:
+    GstCaps *caps_ = nullptr; // 持有引用，避免释放后地址被复用造成误命中
+    std::shared_ptr<const VideoDescriptor> descriptor_;
+    uint64_t generation_ = 0;
+    uint64_t parses_ = 0;
+};
@@ -0,0 +1,340 @@
+#include "VideoScaler.hpp"
+#include "gl_utils.hpp"
+
+#include <cmath>
+#include <iostream>
+
+// 中间纹理已经是正立的，纹理坐标直接由位置得到（不沿用视频四边形的上下翻转）
+static const char *scaler_vertex_source = R"(
+#version 330 core
+layout(location = 0) in vec2 aPos;
+
+out vec2 TexCoord;
+
+void main() {
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    TexCoord = aPos * 0.5 + 0.5;
+}
+)";
+
+// filterKind：0 硬件采样（双线性 / 三线性），1 Catmull-Rom，2 Lanczos-3。
+// 缩小时核按缩放比例放宽以抗混叠，半径上限 MAX_RADIUS texel
+static const char *scaler_fragment_source = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform int filterKind;
+uniform vec2 scale; // 源 texel / 目标像素，大于 1 表示缩小
+
+const float PI = 3.14159265;
+const float MAX_RADIUS = 8.0;
+
+float catmull_rom(float x)
+{
+    x = abs(x);
+    if (x < 1.0)
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0)
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+float sinc(float x)
+{
+    if (abs(x) < 1e-5)
+        return 1.0;
+    x *= PI;
+    return sin(x) / x;
+}
+
+float lanczos3(float x)
+{
+    x = abs(x);
+    return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+float kernel(float x)
+{
+    return filterKind == 1 ? catmull_rom(x) : lanczos3(x);
+}
+
+void main() {
+    if (filterKind == 0)
+    {
+        FragColor = vec4(texture(source, TexCoord).rgb, 1.0);
+        return;
+    }
+
+    ivec2 size = textureSize(source, 0);
+    vec2 pos = TexCoord * vec2(size) - 0.5;
+    vec2 base = floor(pos);
+    vec2 stretch = max(scale, vec2(1.0));
+    float support = filterKind == 1 ? 2.0 : 3.0;
+    ivec2 radius = ivec2(min(ceil(support * stretch), vec2(MAX_RADIUS)));
+
+    vec3 sum = vec3(0.0);
+    float weight_sum = 0.0;
+    for (int j = 1 - radius.y; j <= radius.y; ++j)
+    {
+        float wy = kernel((base.y + float(j) - pos.y) / stretch.y);
+        if (wy == 0.0)
+            continue;
+        for (int i = 1 - radius.x; i <= radius.x; ++i)
+        {
+            float w = wy * kernel((base.x + float(i) - pos.x) / stretch.x);
+            ivec2 texel = clamp(ivec2(base) + ivec2(i, j), ivec2(0), size - 1);
+            sum += w * texelFetch(source, texel, 0).rgb;
+            weight_sum += w;
+        }
+    }
+    FragColor = vec4(clamp(sum / weight_sum, 0.0, 1.0), 1.0);
+}
+)";
+
+const char *scale_filter_name(ScaleFilter filter)
+{
+    switch (filter)
+    {
+    case ScaleFilter::Bilinear:
+        return "bilinear";
+    case ScaleFilter::Mipmap:
+        return "mipmap";
+    case ScaleFilter::Bicubic:
+        return "bicubic";
+    case ScaleFilter::Lanczos:
+        return "lanczos";
+    default:
+        return "unknown";
+    }
+}
+
+ScaleViewport letterbox_viewport(int target_width, int target_height, double display_width, double display_height)
+{
+    ScaleViewport view;
+    view.width = target_width;
+    view.height = target_height;
+    if (target_width <= 0 || target_height <= 0 || display_width <= 0.0 || display_height <= 0.0)
+        return view;
+
+    // 比目标更宽的视频上下留黑边，否则左右留黑边
+    double aspect = display_width / display_height;
+    if (aspect * target_height > target_width)
+        view.height = (int)std::lround(target_width / aspect);
+    else
+        view.width = (int)std::lround(target_height * aspect);
+    if (view.width < 1)
+        view.width = 1;
+    if (view.height < 1)
+        view.height = 1;
+    view.x = (target_width - view.width) / 2;
+    view.y = (target_height - view.height) / 2;
+    return view;
+}
+
+bool crop_is_full(const CropRect &crop)
+{
+    return crop.x == 0.0f && crop.y == 0.0f && crop.width == 1.0f && crop.height == 1.0f;
+}
+
+bool crop_is_valid(const CropRect &crop)
+{
+    const float eps = 1e-4f;
+    return crop.x >= 0.0f && crop.y >= 0.0f && crop.width > 0.0f && crop.height > 0.0f &&
+           crop.x + crop.width <= 1.0f + eps && crop.y + crop.height <= 1.0f + eps;
+}
+
+ScaleViewport crop_viewport(const ScaleViewport &view, const CropRect &crop)
+{
+    if (crop_is_full(crop) || !crop_is_valid(crop))
+        return view;
+
+    // 视口原点在左下，crop 的 y 从顶部算起。用浮点算出整幅画面的边再取整，相邻节点的边界落在同一源像素上
+    double full_width = view.width / (double)crop.width;
+    double full_height = view.height / (double)crop.height;
+    double left = view.x - crop.x * full_width;
+    double bottom = view.y - (1.0 - crop.y - crop.height) * full_height;
+    ScaleViewport full;
+    full.x = (int)std::lround(left);
+    full.y = (int)std::lround(bottom);
+    full.width = (int)std::lround(left + full_width) - full.x;
+    full.height = (int)std::lround(bottom + full_height) - full.y;
+    return full;
+}
+
+VideoScaler::VideoScaler()
+    : filter_(ScaleFilter::Bilinear), program_(0), scale_location_(-1), fbo_(0), texture_(0),
+      width_(0), height_(0), queries_(), query_pending_(), query_index_(0)
+{
+}
+
+VideoScaler::~VideoScaler()
+{
+    // GL 资源由 destroy() 在拥有上下文的线程上释放
+}
+
+bool VideoScaler::init(ScaleFilter filter)
+{
+    destroy();
+    filter_ = filter;
+    glGenQueries(kQueryCount, queries_);
+    if (!uses_intermediate())
+        return true;
+
+    program_ = link_shader_program(scaler_vertex_source, scaler_fragment_source);
+    if (!program_)
+    {
+        std::cerr << "Failed to create scaler program, using bilinear" << std::endl;
+        filter_ = ScaleFilter::Bilinear;
+        return false;
+    }
+    glUseProgram(program_);
+    glUniform1i(glGetUniformLocation(program_, "source"), 0);
+    int kind = filter_ == ScaleFilter::Bicubic ? 1 : (filter_ == ScaleFilter::Lanczos ? 2 : 0);
+    glUniform1i(glGetUniformLocation(program_, "filterKind"), kind);
+    scale_location_ = glGetUniformLocation(program_, "scale");
+    glUseProgram(0);
+
+    glGenFramebuffers(1, &fbo_);
+    return true;
+}
+
+void VideoScaler::destroy()
+{
+    if (queries_[0])
+    {
+        glDeleteQueries(kQueryCount, queries_);
+        for (int i = 0; i < kQueryCount; ++i)
+        {
+            queries_[i] = 0;
+            query_pending_[i] = false;
+        }
+    }
+    if (texture_)
+    {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+    if (fbo_)
+    {
+        glDeleteFramebuffers(1, &fbo_);
+        fbo_ = 0;
+    }
+    if (program_)
+    {
+        glDeleteProgram(program_);
+        program_ = 0;
+    }
+    width_ = 0;
+    height_ = 0;
+}
+
+void VideoScaler::begin_frame()
+{
+    stats_.frames++;
+    collect_queries(false);
+    // 查询环满（GPU 落后超过 kQueryCount 帧）时这一帧不计时
+    if (queries_[0] && !query_pending_[query_index_])
+        glBeginQuery(GL_TIME_ELAPSED, queries_[query_index_]);
+}
+
+void VideoScaler::end_frame()
+{
+    if (!queries_[0] || query_pending_[query_index_])
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    query_pending_[query_index_] = true;
+    query_index_ = (query_index_ + 1) % kQueryCount;
+}
+
+void VideoScaler::collect_queries(bool wait)
+{
+    for (int i = 0; i < kQueryCount; ++i)
+    {
+        if (!query_pending_[i])
+            continue;
+        GLint available = 0;
+        if (!wait)
+        {
+            glGetQueryObjectiv(queries_[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+        }
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(queries_[i], GL_QUERY_RESULT, &elapsed_ns);
+        query_pending_[i] = false;
+
+        double elapsed_us = elapsed_ns / 1000.0;
+        stats_.gpu_samples++;
+        stats_.gpu_total_us += elapsed_us;
+        if (elapsed_us > stats_.gpu_max_us)
+            stats_.gpu_max_us = elapsed_us;
+    }
+}
+
+void VideoScaler::bind_intermediate(int video_width, int video_height)
+{
+    // 只随视频尺寸重新分配；窗口尺寸变化不会走到这里
+    if (video_width != width_ || video_height != height_)
+    {
+        if (texture_)
+            glDeleteTextures(1, &texture_);
+        glGenTextures(1, &texture_);
+        glBindTexture(GL_TEXTURE_2D, texture_);
+
+        int levels = 1;
+        if (filter_ == ScaleFilter::Mipmap)
+        {
+            for (int size = video_width > video_height ? video_width : video_height; size > 1; size >>= 1)
+                levels++;
+        }
+        if (gl_ext.texture_storage)
+        {
+            gl_ext.TexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, video_width, video_height);
+        }
+        else
+        {
+            for (int level = 0; level < levels; ++level)
+            {
+                int w = video_width >> level, h = video_height >> level;
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, w > 0 ? w : 1, h > 0 ? h : 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_, 0);
+        width_ = video_width;
+        height_ = video_height;
+        stats_.intermediate_allocations++;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, width_, height_);
+}
+
+void VideoScaler::draw_scaled(GLuint target_fbo, const ScaleViewport &view, GLuint vao)
+{
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    // mipmap 只在缩小时才会被采样，放大或 1:1 时不重新生成
+    if (filter_ == ScaleFilter::Mipmap && (view.width < width_ || view.height < height_))
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        stats_.mipmap_generations++;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target_fbo);
+    glViewport(view.x, view.y, view.width, view.height);
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(program_);
+    glUniform2f(scale_location_, (float)width_ / view.width, (float)height_ / view.height);
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
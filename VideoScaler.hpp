@@ -0,0 +1,101 @@
+#pragma once
+#include "glad/glad.h"
+
+#include <cstdint>
+
+// 缩放质量档位
+enum class ScaleFilter
+{
+    Bilinear, // 颜色转换时直接双线性采样，无额外 pass
+    Mipmap,   // 转换到中间纹理，缩小时每帧重新生成 mipmap 后三线性采样
+    Bicubic,  // 转换到中间纹理，Catmull-Rom 4x4（缩小时按比例放宽核）
+    Lanczos,  // 转换到中间纹理，Lanczos-3 6x6（缩小时按比例放宽核）
+    Count
+};
+
+const char *scale_filter_name(ScaleFilter filter);
+
+// 目标帧缓冲中的绘制区域（像素，原点在左下）
+struct ScaleViewport
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// 保持显示宽高比、居中放入 target_width x target_height，其余部分留黑边
+ScaleViewport letterbox_viewport(int target_width, int target_height, double display_width, double display_height);
+
+// 源画面中的一块区域（归一化坐标，原点在左上）。多个节点各显示一块，拼成一幅画面
+struct CropRect
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 1.0f;
+    float height = 1.0f;
+};
+
+bool crop_is_full(const CropRect &crop);
+// 区域在 [0,1] 之内且非空
+bool crop_is_valid(const CropRect &crop);
+// 把整幅画面放大、平移，使 crop 区域恰好落在 view 上；超出 view 的部分需要用裁剪测试去掉
+ScaleViewport crop_viewport(const ScaleViewport &view, const CropRect &crop);
+
+// 缩放统计
+struct ScalerStats
+{
+    uint64_t frames = 0;                   // 经过缩放阶段的帧
+    uint64_t gpu_samples = 0;              // 已取回的 GPU 计时结果
+    double gpu_total_us = 0.0;             // 转换 + 缩放的 GPU 时间
+    double gpu_max_us = 0.0;
+    uint64_t mipmap_generations = 0;       // 生成 mipmap 的次数（只在缩小时）
+    uint64_t intermediate_allocations = 0; // 中间纹理分配次数（只随视频尺寸变化）
+};
+
+// GPU 缩放阶段。除 Bilinear 外，颜色转换先画进视频尺寸的 RGBA8 中间纹理，
+// 再按档位把中间纹理缩放到目标视口。窗口尺寸变化只改变视口，不重新分配任何纹理。
+// 每帧用 GL_TIME_ELAPSED 查询环计时，结果延后几帧取回，不阻塞渲染线程。
+class VideoScaler
+{
+public:
+    VideoScaler();
+    ~VideoScaler();
+
+    VideoScaler(const VideoScaler &) = delete;
+    VideoScaler &operator=(const VideoScaler &) = delete;
+
+    bool init(ScaleFilter filter);
+    void destroy();
+
+    ScaleFilter filter() const { return filter_; }
+    bool uses_intermediate() const { return filter_ != ScaleFilter::Bilinear; }
+
+    // 一帧视频绘制的开始与结束（GPU 计时）
+    void begin_frame();
+    void end_frame();
+
+    // 把随后的颜色转换绘制重定向到 video_width x video_height 的中间纹理
+    void bind_intermediate(int video_width, int video_height);
+    // 把中间纹理缩放到 target_fbo 的 view 区域，vao 为全屏四边形（位置在属性 0）
+    void draw_scaled(GLuint target_fbo, const ScaleViewport &view, GLuint vao);
+
+    const ScalerStats &stats() const { return stats_; }
+
+private:
+    void collect_queries(bool wait);
+
+    static const int kQueryCount = 4;
+
+    ScaleFilter filter_;
+    GLuint program_;
+    GLint scale_location_;
+    GLuint fbo_;
+    GLuint texture_;
+    int width_;
+    int height_;
+    GLuint queries_[kQueryCount];
+    bool query_pending_[kQueryCount];
+    int query_index_;
+    ScalerStats stats_;
+};
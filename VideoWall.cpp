@@ -0,0 +1,288 @@
+#include "VideoWall.hpp"
+#include "VideoScaler.hpp"
+#include "gl_utils.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+// 每个实例：格子在 NDC 中的矩形（左下 xy、右上 zw）与层号
+static const char *wall_vertex_source = R"(
+#version 330 core
+layout(location = 0) in vec2 aCorner;
+layout(location = 1) in vec4 aRect;
+layout(location = 2) in float aLayer;
+
+out vec3 TexCoord;
+
+void main() {
+    gl_Position = vec4(mix(aRect.xy, aRect.zw, aCorner), 0.0, 1.0);
+    // 视频第一行在纹理 t=0，显示在格子顶部
+    TexCoord = vec3(aCorner.x, 1.0 - aCorner.y, aLayer);
+}
+)";
+
+static const char *wall_fragment_source = R"(
+#version 330 core
+in vec3 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2DArray layers;
+
+void main() {
+    FragColor = vec4(texture(layers, TexCoord).rgb, 1.0);
+}
+)";
+
+static const float wall_corners[8] = {0, 0, 1, 0, 1, 1, 0, 1};
+static const unsigned int wall_indices[6] = {0, 1, 2, 0, 2, 3};
+
+std::vector<WallTile> wall_grid_layout(int count, int columns, int rows)
+{
+    std::vector<WallTile> tiles;
+    if (count <= 0)
+        return tiles;
+    if (columns <= 0 || rows <= 0)
+    {
+        columns = (int)std::ceil(std::sqrt((double)count));
+        rows = (count + columns - 1) / columns;
+    }
+
+    for (int i = 0; i < count && i < columns * rows; ++i)
+    {
+        WallTile tile;
+        tile.width = 1.0f / columns;
+        tile.height = 1.0f / rows;
+        tile.x = (i % columns) * tile.width;
+        tile.y = (i / columns) * tile.height;
+        tiles.push_back(tile);
+    }
+    return tiles;
+}
+
+bool parse_wall_layout(const std::string &spec, int count, std::vector<WallTile> &tiles)
+{
+    tiles.clear();
+    if (spec.empty() || spec == "grid")
+    {
+        tiles = wall_grid_layout(count);
+        return true;
+    }
+
+    // 固定网格 "CxR"
+    int columns = 0, rows = 0;
+    char tail = 0;
+    if (sscanf(spec.c_str(), "%dx%d%c", &columns, &rows, &tail) == 2)
+    {
+        if (columns <= 0 || rows <= 0)
+            return false;
+        tiles = wall_grid_layout(count, columns, rows);
+        return true;
+    }
+
+    // 自定义矩形列表
+    std::stringstream list(spec);
+    std::string item;
+    while (std::getline(list, item, ';'))
+    {
+        if (item.empty())
+            continue;
+        WallTile tile;
+        if (sscanf(item.c_str(), "%f,%f,%f,%f%c", &tile.x, &tile.y, &tile.width, &tile.height, &tail) != 4 ||
+            tile.width <= 0.0f || tile.height <= 0.0f || tile.x < 0.0f || tile.y < 0.0f ||
+            tile.x + tile.width > 1.001f || tile.y + tile.height > 1.001f)
+        {
+            tiles.clear();
+            return false;
+        }
+        tiles.push_back(tile);
+    }
+    return !tiles.empty();
+}
+
+VideoWall::VideoWall()
+    : program_(0), texture_(0), vao_(0), quad_vbo_(0), instance_vbo_(0), ebo_(0),
+      layers_(0), layer_width_(0), layer_height_(0), instance_count_(0),
+      target_width_(0), target_height_(0), instances_dirty_(true)
+{
+}
+
+VideoWall::~VideoWall()
+{
+    // GL 对象必须在上下文有效时由 destroy() 释放
+}
+
+bool VideoWall::init(int layers, int layer_width, int layer_height)
+{
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (layers <= 0 || layers > max_layers || layer_width <= 0 || layer_height <= 0)
+    {
+        std::cerr << "Unsupported video wall: " << layers << " layers of " << layer_width << "x" << layer_height
+                  << " (max " << max_layers << " layers)" << std::endl;
+        return false;
+    }
+
+    program_ = link_shader_program(wall_vertex_source, wall_fragment_source);
+    if (!program_)
+        return false;
+    glUseProgram(program_);
+    glUniform1i(glGetUniformLocation(program_, "layers"), 0);
+    glUseProgram(0);
+
+    layers_ = layers;
+    layer_width_ = layer_width;
+    layer_height_ = layer_height;
+
+    // 一次分配所有层，初始为黑色
+    std::vector<uint8_t> black((size_t)layer_width * layer_height * layers * 4, 0);
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layer_width, layer_height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, black.data());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &quad_vbo_);
+    glGenBuffers(1, &instance_vbo_);
+    glGenBuffers(1, &ebo_);
+    glBindVertexArray(vao_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(wall_corners), wall_corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+
+    // 实例属性：每个格子前进一次
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)(4 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(wall_indices), wall_indices, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // init 之前 set_layout 给出的布局保留，否则按层数排成网格
+    if (tiles_.empty())
+        tiles_ = wall_grid_layout(layers);
+    instances_dirty_ = true;
+    stats_ = WallStats();
+    return true;
+}
+
+void VideoWall::destroy()
+{
+    if (program_)
+    {
+        glDeleteProgram(program_);
+        program_ = 0;
+    }
+    if (texture_)
+    {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+    if (vao_)
+    {
+        glDeleteVertexArrays(1, &vao_);
+        glDeleteBuffers(1, &quad_vbo_);
+        glDeleteBuffers(1, &instance_vbo_);
+        glDeleteBuffers(1, &ebo_);
+        vao_ = quad_vbo_ = instance_vbo_ = ebo_ = 0;
+    }
+    layers_ = 0;
+    instance_count_ = 0;
+    // 重新 init 时按新的层数重新布局、重新统计
+    tiles_.clear();
+    stats_ = WallStats();
+}
+
+void VideoWall::set_layout(const std::vector<WallTile> &tiles)
+{
+    tiles_ = tiles;
+    instances_dirty_ = true;
+}
+
+void VideoWall::upload_layer(int layer, const uint8_t *pixels, int stride, GLenum format)
+{
+    if (!texture_ || layer < 0 || layer >= layers_ || !pixels)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+    set_unpack_layout(stride, 4, (size_t)pixels);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, layer_width_, layer_height_, 1, format, GL_UNSIGNED_BYTE, pixels);
+    reset_unpack_layout();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    stats_.upload_total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    stats_.layer_uploads++;
+    stats_.bytes_uploaded += (uint64_t)layer_width_ * layer_height_ * 4;
+}
+
+void VideoWall::update_instances(int target_width, int target_height)
+{
+    // 格子矩形只随布局和窗口尺寸变化，平时不重新上传
+    std::vector<float> data;
+    data.reserve(tiles_.size() * 5);
+    for (size_t i = 0; i < tiles_.size(); ++i)
+    {
+        const WallTile &tile = tiles_[i];
+        int layer = tile.layer >= 0 ? tile.layer : (int)i;
+        if (layer >= layers_)
+            continue;
+        int x = (int)std::lround(tile.x * target_width);
+        int y = (int)std::lround(tile.y * target_height);
+        int w = (int)std::lround((tile.x + tile.width) * target_width) - x;
+        int h = (int)std::lround((tile.y + tile.height) * target_height) - y;
+        ScaleViewport view = letterbox_viewport(w, h, layer_width_, layer_height_);
+        // 布局原点在左上，帧缓冲原点在左下
+        float left = (float)(x + view.x) / target_width;
+        float right = (float)(x + view.x + view.width) / target_width;
+        float top = 1.0f - (float)(y + (h - view.y - view.height)) / target_height;
+        float bottom = 1.0f - (float)(y + h - view.y) / target_height;
+        float rect[5] = {left * 2.0f - 1.0f, bottom * 2.0f - 1.0f, right * 2.0f - 1.0f, top * 2.0f - 1.0f, (float)layer};
+        data.insert(data.end(), rect, rect + 5);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instance_count_ = (int)(data.size() / 5);
+    target_width_ = target_width;
+    target_height_ = target_height;
+    instances_dirty_ = false;
+}
+
+void VideoWall::draw(int target_width, int target_height)
+{
+    if (!program_ || target_width <= 0 || target_height <= 0)
+        return;
+    if (instances_dirty_ || target_width != target_width_ || target_height != target_height_)
+        update_instances(target_width, target_height);
+
+    glViewport(0, 0, target_width, target_height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glUseProgram(program_);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+    glBindVertexArray(vao_);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, instance_count_);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    stats_.frames++;
+    stats_.draw_calls++;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 电视墙上的一个格子（窗口归一化坐标，原点在左上）
+struct WallTile
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 1.0f;
+    float height = 1.0f;
+    int layer = -1; // 显示的层（流），-1 表示与格子序号相同
+};
+
+// count 路的网格布局；columns / rows 为 0 时自动取接近正方形的网格
+std::vector<WallTile> wall_grid_layout(int count, int columns = 0, int rows = 0);
+// 解析布局描述："grid"（或空）自动网格，"CxR" 固定网格，
+// 其余按 "x,y,w,h;x,y,w,h;..." 逐个给出归一化矩形。格式错误返回 false
+bool parse_wall_layout(const std::string &spec, int count, std::vector<WallTile> &tiles);
+
+// 电视墙统计
+struct WallStats
+{
+    uint64_t frames = 0;         // 绘制的帧数
+    uint64_t draw_calls = 0;     // 绘制调用次数（每帧一次）
+    uint64_t layer_uploads = 0;  // 上传到纹理数组的层数
+    uint64_t bytes_uploaded = 0;
+    double upload_total_us = 0.0; // 提交上传的 CPU 时间
+};
+
+// 多路视频共用一个 GL_TEXTURE_2D_ARRAY，每路占一层（层尺寸固定，由管道缩放到该尺寸）。
+// 每个格子是一个实例，格子矩形与层号放在实例属性中，整面墙一次 glDrawElementsInstanced 画完。
+// 所有调用都在渲染线程上
+class VideoWall
+{
+public:
+    VideoWall();
+    ~VideoWall();
+
+    VideoWall(const VideoWall &) = delete;
+    VideoWall &operator=(const VideoWall &) = delete;
+
+    bool init(int layers, int layer_width, int layer_height);
+    void destroy();
+
+    // 格子按 WallTile::layer 选择显示的层，对应的层不存在时不绘制
+    void set_layout(const std::vector<WallTile> &tiles);
+    const std::vector<WallTile> &layout() const { return tiles_; }
+
+    // 把一帧 RGBA/BGRA（format）写入第 layer 层，stride 为行字节数
+    void upload_layer(int layer, const uint8_t *pixels, int stride, GLenum format);
+    // 清空当前帧缓冲并画出所有格子，格子内按层的宽高比留黑边
+    void draw(int target_width, int target_height);
+
+    int layers() const { return layers_; }
+    int layer_width() const { return layer_width_; }
+    int layer_height() const { return layer_height_; }
+    const WallStats &stats() const { return stats_; }
+    // 最近一次绘制的实例（格子）数
+    int instance_count() const { return instance_count_; }
+
+private:
+    void update_instances(int target_width, int target_height);
+
+    GLuint program_;
+    GLuint texture_;
+    GLuint vao_;
+    GLuint quad_vbo_;
+    GLuint instance_vbo_;
+    GLuint ebo_;
+    int layers_;
+    int layer_width_;
+    int layer_height_;
+    std::vector<WallTile> tiles_;
+    int instance_count_;
+    int target_width_;  // 实例数据对应的帧缓冲尺寸
+    int target_height_;
+    bool instances_dirty_;
+    WallStats stats_;
+};
@@ -0,0 +1,597 @@
+#include "VideoWallPlayer.hpp"
+#include "CpuUsage.hpp"
+#include "gl_utils.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+VideoWallPlayer::VideoWallPlayer(int width, int height)
+    : window_width_(width), window_height_(height), window_(nullptr), upload_format_(GL_RGBA),
+      framebuffer_width_(width), framebuffer_height_(height), redraw_pending_(true), is_running_(false),
+      run_wall_seconds_(0.0), run_cpu_seconds_(0.0), focus_(-1), layout_dirty_(true), budget_cpu_(0.0)
+{
+}
+
+VideoWallPlayer::~VideoWallPlayer()
+{
+    stop();
+}
+
+bool VideoWallPlayer::create_window()
+{
+    if (!glfwInit())
+    {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return false;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    window_ = glfwCreateWindow(window_width_, window_height_, "GStreamer + OpenGL Video Wall", nullptr, nullptr);
+    if (!window_)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+
+    glfwMakeContextCurrent(window_);
+    glfwSwapInterval(options_.vsync ? 1 : 0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    load_gl_extensions((GLADloadproc)glfwGetProcAddress);
+    glfwGetFramebufferSize(window_, &framebuffer_width_, &framebuffer_height_);
+
+    glfwSetWindowUserPointer(window_, this);
+    glfwSetFramebufferSizeCallback(window_, framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window_, window_refresh_callback);
+    glfwSetWindowIconifyCallback(window_, window_iconify_callback);
+    glfwSetMouseButtonCallback(window_, mouse_button_callback);
+    return true;
+}
+
+void VideoWallPlayer::framebuffer_size_callback(GLFWwindow *window, int width, int height)
+{
+    VideoWallPlayer *player = static_cast<VideoWallPlayer *>(glfwGetWindowUserPointer(window));
+    // 只有实例矩形随尺寸重新计算，纹理数组不变
+    player->framebuffer_width_ = width;
+    player->framebuffer_height_ = height;
+    // 格子面积变化可能改变解码档位
+    player->layout_dirty_ = true;
+    player->redraw_pending_ = true;
+}
+
+void VideoWallPlayer::window_refresh_callback(GLFWwindow *window)
+{
+    VideoWallPlayer *player = static_cast<VideoWallPlayer *>(glfwGetWindowUserPointer(window));
+    player->redraw_pending_ = true;
+}
+
+void VideoWallPlayer::window_iconify_callback(GLFWwindow *window, int iconified)
+{
+    VideoWallPlayer *player = static_cast<VideoWallPlayer *>(glfwGetWindowUserPointer(window));
+    // 最小化时所有流都不可见
+    player->layout_dirty_ = true;
+}
+
+void VideoWallPlayer::mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
+{
+    VideoWallPlayer *player = static_cast<VideoWallPlayer *>(glfwGetWindowUserPointer(window));
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+        return;
+
+    if (player->focus_ >= 0)
+    {
+        player->focus_ = -1;
+    }
+    else
+    {
+        double x = 0.0, y = 0.0;
+        int width = 0, height = 0;
+        glfwGetCursorPos(window, &x, &y);
+        glfwGetWindowSize(window, &width, &height);
+        if (width <= 0 || height <= 0)
+            return;
+        x /= width;
+        y /= height;
+        for (size_t i = 0; i < player->tiles_.size(); ++i)
+        {
+            const WallTile &tile = player->tiles_[i];
+            if (x >= tile.x && x < tile.x + tile.width && y >= tile.y && y < tile.y + tile.height)
+            {
+                player->focus_ = tile.layer >= 0 ? tile.layer : (int)i;
+                break;
+            }
+        }
+        if (player->focus_ < 0)
+            return;
+    }
+    player->layout_dirty_ = true;
+    player->redraw_pending_ = true;
+}
+
+bool VideoWallPlayer::initialize(const std::vector<std::string> &sources, const WallOptions &options)
+{
+    options_ = options;
+    if (sources.empty())
+    {
+        std::cerr << "Video wall needs at least one source" << std::endl;
+        return false;
+    }
+
+    if (!parse_wall_layout(options_.layout, (int)sources.size(), tiles_))
+    {
+        std::cerr << "Invalid wall layout: " << options_.layout << std::endl;
+        return false;
+    }
+    if (tiles_.size() < sources.size())
+        std::cout << "Layout has " << tiles_.size() << " tiles, " << sources.size() - tiles_.size() << " stream(s) not shown" << std::endl;
+
+    if (!create_window())
+        return false;
+    if (!wall_.init((int)sources.size(), options_.tile_width, options_.tile_height))
+        return false;
+    upload_format_ = preferred_rgba_upload_format();
+
+    gst_init(nullptr, nullptr);
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        std::unique_ptr<WallStream> stream(new WallStream());
+        stream->index = (int)i;
+        stream->source = sources[i];
+        stream->owner = this;
+        if (!create_stream(*stream))
+        {
+            std::cerr << "Failed to create pipeline for " << sources[i] << std::endl;
+            return false;
+        }
+        if (options_.decode_tiers)
+            stream->gate.attach(stream->pipeline);
+        streams_.push_back(std::move(stream));
+    }
+
+    std::cout << "Video wall: " << streams_.size() << " streams, " << options_.tile_width << "x" << options_.tile_height
+              << " layers, layout " << options_.layout << std::endl;
+    if (options_.decode_tiers)
+    {
+        budget_.reset((int)streams_.size(), options_.budget);
+        if (options_.budget.core_budget > 0.0)
+            std::cout << "Decode budget: " << options_.budget.core_budget << " cores" << std::endl;
+        else
+            std::cout << "Decode tiers follow visibility and tile size" << std::endl;
+    }
+    is_running_ = true;
+    return true;
+}
+
+bool VideoWallPlayer::create_stream(WallStream &stream)
+{
+    const std::string &source = stream.source;
+    std::string pipeline_str;
+    if (source.empty() || source == "test" || source.compare(0, 5, "test:") == 0)
+    {
+        // "test" 或 "test:N"：videotestsrc 的第 N 种图案，便于区分各路（名为 test*.webm 等的文件不算）
+        std::string pattern = source.size() > 5 ? source.substr(5) : std::to_string(stream.index % 20);
+        for (char c : pattern)
+        {
+            if (!isalnum((unsigned char)c) && c != '-')
+            {
+                std::cerr << "Invalid test pattern: " << pattern << std::endl;
+                return false;
+            }
+        }
+        pipeline_str = "videotestsrc is-live=true pattern=" + pattern + " ! ";
+    }
+    else if (source.find("rtsp://") == 0)
+    {
+        pipeline_str = "rtspsrc location=" + source + " latency=0 ! decodebin ! ";
+    }
+    else
+    {
+        // 本地文件转换成 URI，其余交给 uridecodebin 自动选择
+        std::string uri = source;
+        if (source.find("://") == std::string::npos)
+        {
+            gchar *file_uri = gst_filename_to_uri(source.c_str(), nullptr);
+            if (file_uri)
+            {
+                uri = file_uri;
+                g_free(file_uri);
+            }
+        }
+        pipeline_str = "uridecodebin uri=\"" + uri + "\" ! ";
+    }
+    // 先在解码格式上缩小再转换，纹理数组要求所有层尺寸与格式相同
+    pipeline_str += "queue max-size-buffers=2 ! videoscale add-borders=true ! videoconvert ! "
+                    "video/x-raw,format=" +
+                    std::string(upload_format_ == GL_BGRA ? "BGRA" : "RGBA") +
+                    ",width=" + std::to_string(options_.tile_width) +
+                    ",height=" + std::to_string(options_.tile_height) +
+                    ",pixel-aspect-ratio=1/1 ! appsink name=sink";
+    std::cout << "Stream " << stream.index << ": " << pipeline_str << std::endl;
+
+    GError *error = nullptr;
+    stream.pipeline = gst_parse_launch(pipeline_str.c_str(), &error);
+    if (error)
+    {
+        std::cerr << "Failed to create pipeline: " << error->message << std::endl;
+        g_error_free(error);
+        return false;
+    }
+    if (!stream.pipeline)
+        return false;
+
+    stream.appsink = gst_bin_get_by_name(GST_BIN(stream.pipeline), "sink");
+    if (!stream.appsink)
+    {
+        std::cerr << "Failed to get appsink element" << std::endl;
+        return false;
+    }
+    if (options_.sync)
+    {
+        // 渲染线程按共同的运行时间拉帧
+        StreamSync::configure_appsink(stream.appsink);
+        stream.synced.appsink = GST_APP_SINK(stream.appsink);
+    }
+    else
+    {
+        // 每路只保留最新一帧，渲染跟不上时在 appsink 中丢弃
+        g_object_set(stream.appsink, "emit-signals", FALSE, "max-buffers", 1, "drop", TRUE, nullptr);
+        GstAppSinkCallbacks callbacks = {};
+        callbacks.new_sample = appsink_new_sample;
+        gst_app_sink_set_callbacks(GST_APP_SINK(stream.appsink), &callbacks, &stream, nullptr);
+    }
+
+    stream.bus = gst_element_get_bus(stream.pipeline);
+    gst_bus_add_watch(stream.bus, bus_callback, &stream);
+    return true;
+}
+
+GstFlowReturn VideoWallPlayer::appsink_new_sample(GstAppSink *sink, gpointer data)
+{
+    WallStream *stream = static_cast<WallStream *>(data);
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (!sample)
+        return GST_FLOW_ERROR;
+
+    // back 槽只属于本路的 appsink 线程，槽中可能残留被覆盖的旧帧
+    WallFrame &frame = stream->mailbox.back();
+    if (frame.sample)
+        gst_sample_unref(frame.sample);
+    frame.sample = sample;
+    stream->mailbox.publish();
+    glfwPostEmptyEvent();
+    return GST_FLOW_OK;
+}
+
+gboolean VideoWallPlayer::bus_callback(GstBus *bus, GstMessage *msg, gpointer data)
+{
+    WallStream *stream = static_cast<WallStream *>(data);
+
+    switch (GST_MESSAGE_TYPE(msg))
+    {
+    case GST_MESSAGE_ERROR:
+    {
+        GError *err = nullptr;
+        gchar *debug = nullptr;
+        gst_message_parse_error(msg, &err, &debug);
+        std::cerr << "Stream " << stream->index << " error: " << err->message << std::endl;
+        if (debug)
+            g_free(debug);
+        g_error_free(err);
+        // 只停止出错的这一路，画面停在最后一帧
+        stream->ended = true;
+        break;
+    }
+    case GST_MESSAGE_EOS:
+        std::cout << "Stream " << stream->index << " ended" << std::endl;
+        stream->ended = true;
+        break;
+    case GST_MESSAGE_ASYNC_DONE:
+        // 预卷后才能判断是否可寻址，之前请求的档位在这里补上
+        stream->gate.reapply();
+        break;
+    default:
+        break;
+    }
+    return TRUE;
+}
+
+bool VideoWallPlayer::upload_sample(WallStream &stream, GstSample *sample)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    std::shared_ptr<const VideoDescriptor> video = stream.descriptors.get(gst_sample_get_caps(sample));
+    GstVideoFrame vframe;
+    if (!buffer || !video || video->info.width != wall_.layer_width() || video->info.height != wall_.layer_height() ||
+        !gst_video_frame_map(&vframe, &video->info, buffer, GST_MAP_READ))
+    {
+        stream.frames_rejected++;
+        return false;
+    }
+
+    // glTexSubImage3D 返回时已经读完客户端内存，sample 可以立即归还
+    GLenum format = GST_VIDEO_INFO_FORMAT(&video->info) == GST_VIDEO_FORMAT_BGRA ? GL_BGRA : GL_RGBA;
+    wall_.upload_layer(stream.index, (const uint8_t *)GST_VIDEO_FRAME_PLANE_DATA(&vframe, 0),
+                       GST_VIDEO_FRAME_PLANE_STRIDE(&vframe, 0), format);
+    gst_video_frame_unmap(&vframe);
+    return true;
+}
+
+void VideoWallPlayer::upload_new_frames(bool &uploaded)
+{
+    // 各路邮箱独立，没有新帧的路只是一次原子读
+    for (std::unique_ptr<WallStream> &stream : streams_)
+    {
+        if (!stream->mailbox.acquire())
+            continue;
+
+        WallFrame &frame = stream->mailbox.front();
+        if (upload_sample(*stream, frame.sample))
+            uploaded = true;
+        gst_sample_unref(frame.sample);
+        frame.sample = nullptr;
+    }
+}
+
+void VideoWallPlayer::upload_synchronized_frames(bool &uploaded)
+{
+    // 所有路用同一个目标运行时间选帧：同步录制的文件 PTS 相同，同一次绘制显示的是同一时刻的画面
+    GstClockTime target = sync_.running_time();
+    std::vector<const SyncedSink *> sinks;
+    for (std::unique_ptr<WallStream> &stream : streams_)
+    {
+        GstSample *sample = StreamSync::pull_due(stream->synced, target);
+        if (sample)
+        {
+            if (upload_sample(*stream, sample))
+                uploaded = true;
+            gst_sample_unref(sample);
+        }
+        stream->synced.active = !stream->ended;
+        sinks.push_back(&stream->synced);
+    }
+    if (uploaded)
+        sync_.record_skew(sinks);
+}
+
+double VideoWallPlayer::synchronized_wait_seconds() const
+{
+    // 等到最早的下一帧到期；还没有拉到下一帧的路每 5ms 检查一次
+    GstClockTime now = sync_.running_time();
+    double wait = 0.1;
+    for (const std::unique_ptr<WallStream> &stream : streams_)
+    {
+        if (stream->ended)
+            continue;
+        if (!stream->synced.pending || !GST_CLOCK_TIME_IS_VALID(stream->synced.pending_time))
+            return 0.005;
+        double due = stream->synced.pending_time > now ? (double)(stream->synced.pending_time - now) / GST_SECOND : 0.0;
+        if (due < wait)
+            wait = due;
+    }
+    return wait;
+}
+
+void VideoWallPlayer::apply_layout()
+{
+    std::vector<WallTile> shown = tiles_;
+    if (focus_ >= 0)
+    {
+        WallTile tile;
+        tile.layer = focus_;
+        shown.assign(1, tile);
+    }
+    wall_.set_layout(shown);
+    layout_dirty_ = false;
+    if (!options_.decode_tiers)
+        return;
+
+    // 每路在屏幕上的像素面积，不在布局中或窗口最小化时为 0（不可见）
+    std::vector<double> areas(streams_.size(), 0.0);
+    if (!glfwGetWindowAttrib(window_, GLFW_ICONIFIED))
+    {
+        for (size_t i = 0; i < shown.size(); ++i)
+        {
+            int layer = shown[i].layer >= 0 ? shown[i].layer : (int)i;
+            if (layer < (int)areas.size())
+                areas[layer] += shown[i].width * framebuffer_width_ * shown[i].height * framebuffer_height_;
+        }
+    }
+    for (size_t i = 0; i < streams_.size(); ++i)
+    {
+        if (budget_.set_tile((int)i, areas[i] > 0.0, areas[i]))
+            std::cout << "Stream " << i << " enlarged, decoding at " << decode_tier_name(budget_.tier((int)i)) << std::endl;
+    }
+    apply_decode_tiers();
+}
+
+void VideoWallPlayer::apply_decode_tiers()
+{
+    for (size_t i = 0; i < streams_.size(); ++i)
+        streams_[i]->gate.set_tier(budget_.tier((int)i));
+}
+
+void VideoWallPlayer::evaluate_decode_budget()
+{
+    // 每 500ms 按这段时间内进程的平均核占用评估一次
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - budget_time_).count();
+    if (elapsed < 0.5)
+        return;
+    double cpu = process_cpu_seconds();
+    double cores = (cpu - budget_cpu_) / elapsed;
+    budget_time_ = now;
+    budget_cpu_ = cpu;
+    if (budget_.evaluate(cores))
+        apply_decode_tiers();
+}
+
+void VideoWallPlayer::run()
+{
+    if (!is_running_)
+        return;
+
+    if (options_.sync)
+    {
+        std::vector<GstElement *> pipelines;
+        for (std::unique_ptr<WallStream> &stream : streams_)
+            pipelines.push_back(stream->pipeline);
+        if (!sync_.start(pipelines))
+        {
+            stop();
+            return;
+        }
+        std::cout << "Synchronized start: shared system clock, base time " << sync_.base_time() << std::endl;
+    }
+    else
+    {
+        for (std::unique_ptr<WallStream> &stream : streams_)
+            gst_element_set_state(stream->pipeline, GST_STATE_PLAYING);
+    }
+    GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+    std::thread gst_loop_thread([loop]()
+                                { g_main_loop_run(loop); });
+
+    double cpu_start = process_cpu_seconds();
+    auto wall_start = std::chrono::steady_clock::now();
+    budget_time_ = wall_start;
+    budget_cpu_ = cpu_start;
+    while (is_running_ && !glfwWindowShouldClose(window_))
+    {
+        // 任意一路的新帧都会唤醒；同步播放时等到下一帧到期
+        glfwWaitEventsTimeout(options_.sync ? synchronized_wait_seconds() : 0.1);
+        if (layout_dirty_)
+            apply_layout();
+        if (options_.decode_tiers)
+            evaluate_decode_budget();
+        bool uploaded = false;
+        if (options_.sync)
+            upload_synchronized_frames(uploaded);
+        else
+            upload_new_frames(uploaded);
+        if (!uploaded && !redraw_pending_)
+            continue;
+        redraw_pending_ = false;
+
+        wall_.draw(framebuffer_width_, framebuffer_height_);
+        glfwSwapBuffers(window_);
+    }
+    run_cpu_seconds_ = process_cpu_seconds() - cpu_start;
+    run_wall_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    for (std::unique_ptr<WallStream> &stream : streams_)
+        gst_element_set_state(stream->pipeline, GST_STATE_NULL);
+    sync_.stop();
+    print_stats();
+    g_main_loop_quit(loop);
+    gst_loop_thread.join();
+    g_main_loop_unref(loop);
+
+    stop();
+}
+
+void VideoWallPlayer::print_stats()
+{
+    const WallStats &stats = wall_.stats();
+    std::cout << "=== Video wall statistics ===" << std::endl;
+    for (const std::unique_ptr<WallStream> &stream : streams_)
+    {
+        // 同步模式不经过邮箱，帧由渲染线程直接从 appsink 选取
+        std::cout << "Stream " << std::setw(2) << stream->index << ": ";
+        if (options_.sync)
+        {
+            std::cout << stream->synced.pulled << " received, " << stream->synced.shown << " shown, "
+                      << stream->synced.skipped << " skipped as late, ";
+        }
+        else
+        {
+            FrameCounters counters = stream->mailbox.counters();
+            std::cout << counters.produced << " received, " << counters.consumed << " uploaded, " << counters.overwritten
+                      << " overwritten, ";
+        }
+        std::cout << stream->frames_rejected << " rejected";
+        std::cout << (stream->ended ? " (ended)" : "") << std::endl;
+        if (options_.decode_tiers)
+        {
+            DecodeGateStats gate = stream->gate.stats();
+            std::cout << "           " << decode_tier_name(stream->gate.tier()) << ", " << gate.decoded << " decoded, "
+                      << gate.dropped_before << " skipped before decode, " << gate.dropped_after << " after";
+            if (gate.promotions)
+                std::cout << ", " << gate.promotions << " resumes (max " << gate.promote_latency_max_ms << " ms to keyframe)";
+            std::cout << std::endl;
+        }
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Frames drawn:        " << stats.frames << " (" << stats.draw_calls << " draw calls)" << std::endl;
+    if (stats.layer_uploads)
+        std::cout << "Layer upload:        " << stats.upload_total_us / stats.layer_uploads << " us avg, "
+                  << stats.bytes_uploaded / (1024.0 * 1024.0) << " MB total" << std::endl;
+    if (options_.sync && sync_.skew().samples)
+    {
+        const SkewStats &skew = sync_.skew();
+        std::cout << "Inter-stream skew:   " << skew.sum_ms / skew.samples << " ms avg, " << skew.max_ms << " ms max, "
+                  << skew.over_frame << " of " << skew.samples << " draws off by a frame or more";
+        if (skew.frame_ms > 0.0)
+            std::cout << " (" << skew.frame_ms << " ms)";
+        std::cout << std::endl;
+    }
+    if (options_.decode_tiers)
+    {
+        const DecodeBudgetStats &budget = budget_.stats();
+        std::cout << "Decode budget:       " << budget.demotions << " demotions, " << budget.promotions << " promotions, "
+                  << budget.enlargements << " enlargements, last " << budget.last_cores << " cores" << std::endl;
+    }
+    if (run_wall_seconds_ > 0.0)
+        std::cout << "CPU usage:           " << 100.0 * run_cpu_seconds_ / run_wall_seconds_ << "% of one core" << std::endl;
+}
+
+void VideoWallPlayer::cleanup()
+{
+    for (std::unique_ptr<WallStream> &stream : streams_)
+    {
+        if (stream->pipeline)
+            gst_element_set_state(stream->pipeline, GST_STATE_NULL);
+        for (int i = 0; i < stream->mailbox.slot_count(); ++i)
+        {
+            WallFrame &frame = stream->mailbox.slot(i);
+            if (frame.sample)
+            {
+                gst_sample_unref(frame.sample);
+                frame.sample = nullptr;
+            }
+        }
+        StreamSync::reset(stream->synced);
+        stream->descriptors.reset();
+        stream->gate.detach();
+        if (stream->bus)
+        {
+            gst_bus_remove_watch(stream->bus);
+            gst_object_unref(stream->bus);
+        }
+        if (stream->appsink)
+            gst_object_unref(stream->appsink);
+        if (stream->pipeline)
+            gst_object_unref(stream->pipeline);
+    }
+    streams_.clear();
+}
+
+void VideoWallPlayer::stop()
+{
+    is_running_ = false;
+    cleanup();
+    if (window_)
+    {
+        wall_.destroy();
+        glfwDestroyWindow(window_);
+        window_ = nullptr;
+        glfwTerminate();
+    }
+}
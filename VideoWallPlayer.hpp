@@ -0,0 +1,119 @@
+#pragma once
+#include "gst/gst.h"
+#include "gst/video/video.h"
+#include "gst/app/gstappsink.h"
+
+#include "GLFW/glfw3.h"
+#include "glad/glad.h"
+
+#include "DecodeBudget.hpp"
+#include "DecodeTierGate.hpp"
+#include "FrameMailbox.hpp"
+#include "StreamSync.hpp"
+#include "VideoFormat.hpp"
+#include "VideoWall.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 电视墙选项
+struct WallOptions
+{
+    std::string layout = "grid"; // 见 parse_wall_layout
+    // 每路在纹理数组中的层尺寸，管道中缩放（保持宽高比、加黑边）到该尺寸
+    int tile_width = 640;
+    int tile_height = 360;
+    bool vsync = true;
+    // NVR 模式：按可见性、格子大小和测得的核占用给每路分配解码档位
+    bool decode_tiers = false;
+    DecodeBudgetOptions budget;
+    // 同步播放：所有管道共用一个时钟和 base time，渲染端按共同的运行时间选帧（同步录制的多路文件逐帧对齐）
+    bool sync = false;
+};
+
+// 邮箱中的一帧：只持有 sample 引用，渲染线程上传后释放
+struct WallFrame
+{
+    GstSample *sample = nullptr;
+};
+
+// 一路视频源。appsink 线程只写 mailbox 的 back 槽，渲染线程只读 front 槽，两者之间没有锁
+struct WallStream
+{
+    int index = 0;
+    std::string source;
+    class VideoWallPlayer *owner = nullptr;
+    GstElement *pipeline = nullptr;
+    GstElement *appsink = nullptr;
+    GstBus *bus = nullptr;
+    FrameMailbox<WallFrame> mailbox;
+    VideoDescriptorCache descriptors; // 只在渲染线程上使用
+    DecodeTierGate gate;              // 解码档位，渲染线程设置，流线程中的探针执行
+    SyncedSink synced;                // 同步播放时渲染线程从 appsink 拉帧，不经过 mailbox
+    std::atomic<bool> ended{false};   // EOS 或出错后停在最后一帧
+    uint64_t frames_rejected = 0;     // 渲染线程：映射失败或格式不符
+};
+
+// 多路视频一个窗口：每路一条独立管道，解码后缩放到固定层尺寸，
+// 渲染线程把各路新帧上传进同一个纹理数组，整面墙一次实例化绘制。
+// 单路出错或结束只停在该路最后一帧，不影响其他路。
+// 点击某一路放大到整个窗口，再次点击回到网格
+class VideoWallPlayer
+{
+public:
+    VideoWallPlayer(int width = 1280, int height = 720);
+    ~VideoWallPlayer();
+
+    bool initialize(const std::vector<std::string> &sources, const WallOptions &options);
+    void run();
+    void stop();
+
+private:
+    bool create_window();
+    bool create_stream(WallStream &stream);
+    bool upload_sample(WallStream &stream, GstSample *sample);
+    void upload_new_frames(bool &uploaded);
+    void upload_synchronized_frames(bool &uploaded);
+    double synchronized_wait_seconds() const;
+    void apply_layout();
+    void apply_decode_tiers();
+    void evaluate_decode_budget();
+    void print_stats();
+    void cleanup();
+
+    static GstFlowReturn appsink_new_sample(GstAppSink *sink, gpointer data);
+    static gboolean bus_callback(GstBus *bus, GstMessage *msg, gpointer data);
+    static void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+    static void window_refresh_callback(GLFWwindow *window);
+    static void window_iconify_callback(GLFWwindow *window, int iconified);
+    static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
+
+    int window_width_;
+    int window_height_;
+    GLFWwindow *window_;
+    WallOptions options_;
+    GLenum upload_format_;
+    // FrameMailbox 不可移动，各路按指针保存
+    std::vector<std::unique_ptr<WallStream>> streams_;
+    VideoWall wall_;
+    int framebuffer_width_;
+    int framebuffer_height_;
+    bool redraw_pending_;
+    std::atomic<bool> is_running_;
+    double run_wall_seconds_;
+    double run_cpu_seconds_;
+
+    // 布局：tiles_ 为网格（或自定义）布局，focus_ >= 0 时只显示该路
+    std::vector<WallTile> tiles_;
+    int focus_;
+    bool layout_dirty_;
+    // 解码预算，只在渲染线程上使用
+    DecodeBudget budget_;
+    std::chrono::steady_clock::time_point budget_time_;
+    double budget_cpu_;
+    // 同步播放的共同时钟与偏差统计
+    StreamSync sync_;
+};
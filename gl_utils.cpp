@@ -2,7 +2,9 @@
 #include <sstream>
 #include <vector>
 #include <iostream>
-#include "glad/glad.h"
+#include <cstring>
+#include <string>
+#include "gl_utils.hpp"
 
 // 顶点着色器源码
 const char *vertex_shader_source = R"(
@@ -18,18 +20,64 @@ void main() {
 }
 )";
 
-// 片段着色器源码
-const char *fragment_shader_source = R"(
+// 片段着色器公共部分
+const char *fragment_shader_header = R"(
 #version 330 core
 in vec2 TexCoord;
 out vec4 FragColor;
 
-uniform sampler2D videoTexture;
+uniform sampler2D videoTexture;  // 平面 0
+uniform sampler2D videoTexture1; // 平面 1
+uniform sampler2D videoTexture2; // 平面 2
+uniform mat4 colorMatrix;        // YUV -> RGB，包含限制范围的偏移与缩放
+uniform int frameWidth;          // 视频宽度（像素），YUY2 按奇偶取亮度时使用
 
+vec3 yuv_to_rgb(vec3 yuv)
+{
+    return (colorMatrix * vec4(yuv, 1.0)).rgb;
+}
+)";
+
+// 各格式的采样函数
+const char *fragment_sample_rgba = R"(
+vec3 sample_rgb(vec2 uv)
+{
+    return texture(videoTexture, uv).rgb;
+}
+)";
+
+const char *fragment_sample_i420 = R"(
+vec3 sample_rgb(vec2 uv)
+{
+    return yuv_to_rgb(vec3(texture(videoTexture, uv).r,
+                           texture(videoTexture1, uv).r,
+                           texture(videoTexture2, uv).r));
+}
+)";
+
+const char *fragment_sample_nv12 = R"(
+vec3 sample_rgb(vec2 uv)
+{
+    return yuv_to_rgb(vec3(texture(videoTexture, uv).r, texture(videoTexture1, uv).rg));
+}
+)";
+
+const char *fragment_sample_yuy2 = R"(
+vec3 sample_rgb(vec2 uv)
+{
+    // 每个 texel 为 Y0 U Y1 V，按像素列的奇偶选择亮度
+    ivec2 size = textureSize(videoTexture, 0);
+    int x = clamp(int(uv.x * float(frameWidth)), 0, frameWidth - 1);
+    int y = clamp(int(uv.y * float(size.y)), 0, size.y - 1);
+    vec4 texel = texelFetch(videoTexture, ivec2(x / 2, y), 0);
+    float luma = (x % 2 == 0) ? texel.r : texel.b;
+    return yuv_to_rgb(vec3(luma, texel.g, texel.a));
+}
+)";
+
+const char *fragment_shader_main = R"(
 void main() {
-    FragColor = texture(videoTexture, TexCoord);
-    // 如果需要颜色转换（YUV到RGB），可以在这里添加
-    // FragColor.rgb = vec3(dot(FragColor.rgb, vec3(0.299, 0.587, 0.114)));
+    FragColor = vec4(sample_rgb(TexCoord), 1.0);
 }
 )";
 
@@ -69,13 +117,13 @@ GLuint compile_shader(GLenum type, const char *source)
     return shader;
 }
 // 创建着色器程序
-GLuint create_shader_program()
+GLuint link_shader_program(const char *vertex_source, const char *fragment_source)
 {
-    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_source); // 编译顶点着色器
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source); // 编译顶点着色器
     if (!vertex_shader)
         return 0;
 
-    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source); // 编译顶点着色器
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source); // 编译片段着色器
     if (!fragment_shader)
     {
         glDeleteShader(vertex_shader);
@@ -97,10 +145,49 @@ GLuint create_shader_program()
         glGetProgramInfoLog(program, 512, nullptr, info_log);
         std::cerr << "Shader program linking failed:\n"
                   << info_log << std::endl;
+        glDeleteProgram(program);
+        return 0;
     }
     return program;
 }
 
+GLuint create_video_shader_program(VideoShader shader)
+{
+    const char *sample = fragment_sample_rgba;
+    switch (shader)
+    {
+    case VideoShader::I420:
+        sample = fragment_sample_i420;
+        break;
+    case VideoShader::Nv12:
+        sample = fragment_sample_nv12;
+        break;
+    case VideoShader::Yuy2:
+        sample = fragment_sample_yuy2;
+        break;
+    default:
+        break;
+    }
+
+    std::string source = std::string(fragment_shader_header) + sample + fragment_shader_main;
+    GLuint program = link_shader_program(vertex_shader_source, source.c_str());
+    if (!program)
+        return 0;
+
+    // 采样器固定绑定到纹理单元 0/1/2
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "videoTexture"), 0);
+    glUniform1i(glGetUniformLocation(program, "videoTexture1"), 1);
+    glUniform1i(glGetUniformLocation(program, "videoTexture2"), 2);
+    glUseProgram(0);
+    return program;
+}
+
+GLuint create_shader_program()
+{
+    return create_video_shader_program(VideoShader::Rgba);
+}
+
 const float *get_screen_quad_vertices()
 {
     return vertices;
@@ -110,3 +197,75 @@ const unsigned int *get_screen_quad_indices()
 {
     return indices;
 }
+
+GLExtensions gl_ext;
+
+bool gl_has_extension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char *ext = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if (ext && strcmp(ext, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool gl_version_at_least(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+void load_gl_extensions(GLADloadproc load)
+{
+    gl_ext = GLExtensions();
+
+    if (gl_version_at_least(4, 4) || gl_has_extension("GL_ARB_buffer_storage"))
+    {
+        gl_ext.BufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+        gl_ext.buffer_storage = gl_ext.BufferStorage != nullptr;
+    }
+
+    if (gl_version_at_least(4, 3) || gl_has_extension("GL_ARB_internalformat_query2"))
+    {
+        gl_ext.GetInternalformativ = (PFNGLGETINTERNALFORMATIVPROC)load("glGetInternalformativ");
+        gl_ext.internalformat_query2 = gl_ext.GetInternalformativ != nullptr;
+    }
+
+    if (gl_version_at_least(4, 2) || gl_has_extension("GL_ARB_texture_storage"))
+    {
+        gl_ext.TexStorage2D = (PFNGLTEXSTORAGE2DPROC)load("glTexStorage2D");
+        gl_ext.texture_storage = gl_ext.TexStorage2D != nullptr;
+    }
+
+    std::cout << "GL " << GLVersion.major << "." << GLVersion.minor
+              << ", buffer_storage: " << (gl_ext.buffer_storage ? "yes" : "no")
+              << ", texture_storage: " << (gl_ext.texture_storage ? "yes" : "no") << std::endl;
+}
+
+void set_unpack_layout(int stride, int bytes_per_pixel, size_t address)
+{
+    // 取同时整除行字节数和起始地址的最大对齐值
+    GLint alignment = 8;
+    while (alignment > 1 && ((stride % alignment) != 0 || (address % alignment) != 0))
+        alignment /= 2;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / bytes_per_pixel);
+}
+
+void reset_unpack_layout()
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+GLenum preferred_rgba_upload_format()
+{
+    GLint format = GL_RGBA;
+    if (gl_ext.internalformat_query2)
+        gl_ext.GetInternalformativ(GL_TEXTURE_2D, GL_RGBA8, GL_TEXTURE_IMAGE_FORMAT, 1, &format);
+    return format == GL_BGRA ? GL_BGRA : GL_RGBA;
+}
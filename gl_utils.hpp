@@ -1,4 +1,7 @@
 #pragma once
+#include "glad/glad.h"
+
+#include <cstddef>
 
 #ifdef __cplusplus
 extern "C"
@@ -11,4 +14,61 @@ extern "C"
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
+
+// 视频片段着色器变体，按帧的像素格式选择
+enum class VideoShader
+{
+    Rgba, // 打包 RGBA/BGRA，单纹理直接采样
+    I420, // Y、U、V 三个 R8 纹理
+    Nv12, // Y 为 R8 纹理，交错 UV 为 RG8 纹理
+    Yuy2, // 打包 4:2:2，每个 RGBA8 texel 存两个像素
+    Count
+};
+
+// 创建指定变体的视频着色器程序，采样器依次绑定纹理单元 0/1/2
+GLuint create_video_shader_program(VideoShader shader);
+// 编译并链接一对着色器，失败返回 0
+GLuint link_shader_program(const char *vertex_source, const char *fragment_source);
+
+// glad 只生成了 GL 3.3 core，更高版本或扩展中的功能在运行时按需加载
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_TEXTURE_IMAGE_FORMAT
+#define GL_TEXTURE_IMAGE_FORMAT 0x828F
+#endif
+
+typedef void(APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void(APIENTRYP PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void(APIENTRYP PFNGLGETINTERNALFORMATIVPROC)(GLenum target, GLenum internalformat, GLenum pname, GLsizei count, GLint *params);
+
+struct GLExtensions
+{
+    // GL 4.4 / ARB_buffer_storage
+    bool buffer_storage = false;
+    PFNGLBUFFERSTORAGEPROC BufferStorage = nullptr;
+    // GL 4.3 / ARB_internalformat_query2
+    bool internalformat_query2 = false;
+    PFNGLGETINTERNALFORMATIVPROC GetInternalformativ = nullptr;
+    // GL 4.2 / ARB_texture_storage
+    bool texture_storage = false;
+    PFNGLTEXSTORAGE2DPROC TexStorage2D = nullptr;
+};
+
+extern GLExtensions gl_ext;
+
+// 当前上下文是否支持某个扩展
+bool gl_has_extension(const char *name);
+// 在 gladLoadGLLoader 之后调用，加载可选功能
+void load_gl_extensions(GLADloadproc load);
+
+// 按行字节数与数据起始地址设置 GL_UNPACK_ROW_LENGTH / GL_UNPACK_ALIGNMENT，带填充的行无需重新打包
+void set_unpack_layout(int stride, int bytes_per_pixel, size_t address);
+// 恢复默认解包参数
+void reset_unpack_layout();
+// 驱动偏好的 RGBA8 纹理上传格式（GL_RGBA 或 GL_BGRA）
+GLenum preferred_rgba_upload_format();
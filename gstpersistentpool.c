@@ -0,0 +1,354 @@
+#include "gstpersistentpool.h"
+
+GST_DEBUG_CATEGORY_STATIC(gst_persistent_pool_debug);
+#define GST_CAT_DEFAULT gst_persistent_pool_debug
+
+struct _GstPersistentRegion
+{
+    gint refcount;
+    GMutex lock;
+
+    guint8 *base;    /* 持久映射的起始地址，失效后为 NULL */
+    gsize slot_size; /* 每个槽位的字节数 */
+    guint n_slots;
+    gboolean *used; /* 槽位占用标记 */
+
+    guint64 gl_buffers;     /* 分配在 GL 内存中的缓冲数 */
+    guint64 system_buffers; /* 退回系统内存的缓冲数 */
+};
+
+/* 挂在 GstMemory 上的槽位信息，memory 释放时归还槽位 */
+typedef struct
+{
+    GstPersistentRegion *region;
+    guint index;
+    gsize offset;
+} GstPersistentSlot;
+
+static GQuark
+gst_persistent_slot_quark(void)
+{
+    static GQuark quark = 0;
+    if (!quark)
+        quark = g_quark_from_static_string("GstPersistentSlot");
+    return quark;
+}
+
+GstPersistentRegion *
+gst_persistent_region_new(guint8 *base, gsize slot_size, guint n_slots)
+{
+    GstPersistentRegion *region = g_new0(GstPersistentRegion, 1);
+
+    region->refcount = 1;
+    g_mutex_init(&region->lock);
+    region->base = base;
+    region->slot_size = base ? slot_size : 0;
+    region->n_slots = base ? n_slots : 0;
+    region->used = g_new0(gboolean, region->n_slots ? region->n_slots : 1);
+
+    return region;
+}
+
+GstPersistentRegion *
+gst_persistent_region_ref(GstPersistentRegion *region)
+{
+    g_atomic_int_inc(&region->refcount);
+    return region;
+}
+
+void gst_persistent_region_unref(GstPersistentRegion *region)
+{
+    if (!g_atomic_int_dec_and_test(&region->refcount))
+        return;
+
+    g_mutex_clear(&region->lock);
+    g_free(region->used);
+    g_free(region);
+}
+
+guint gst_persistent_region_invalidate(GstPersistentRegion *region)
+{
+    guint in_use = 0;
+    guint i;
+
+    g_mutex_lock(&region->lock);
+    region->base = NULL;
+    for (i = 0; i < region->n_slots; i++)
+    {
+        if (region->used[i])
+            in_use++;
+    }
+    g_mutex_unlock(&region->lock);
+
+    return in_use;
+}
+
+void gst_persistent_region_get_stats(GstPersistentRegion *region,
+                                     guint64 *gl_buffers, guint64 *system_buffers)
+{
+    g_mutex_lock(&region->lock);
+    if (gl_buffers)
+        *gl_buffers = region->gl_buffers;
+    if (system_buffers)
+        *system_buffers = region->system_buffers;
+    g_mutex_unlock(&region->lock);
+}
+
+static void
+gst_persistent_slot_free(gpointer data)
+{
+    GstPersistentSlot *slot = (GstPersistentSlot *)data;
+
+    g_mutex_lock(&slot->region->lock);
+    slot->region->used[slot->index] = FALSE;
+    g_mutex_unlock(&slot->region->lock);
+
+    gst_persistent_region_unref(slot->region);
+    g_free(slot);
+}
+
+/* 从区域中取一个空闲槽位包装成 GstMemory，没有合适的槽位时返回 NULL */
+static GstMemory *
+gst_persistent_region_alloc(GstPersistentRegion *region, gsize size)
+{
+    GstMemory *mem = NULL;
+    GstPersistentSlot *slot;
+    guint i;
+
+    g_mutex_lock(&region->lock);
+    if (region->base && size <= region->slot_size)
+    {
+        for (i = 0; i < region->n_slots; i++)
+        {
+            if (!region->used[i])
+                break;
+        }
+        if (i < region->n_slots)
+        {
+            region->used[i] = TRUE;
+            region->gl_buffers++;
+
+            slot = g_new0(GstPersistentSlot, 1);
+            slot->region = gst_persistent_region_ref(region);
+            slot->index = i;
+            slot->offset = i * region->slot_size;
+
+            mem = gst_memory_new_wrapped((GstMemoryFlags)0, region->base + slot->offset,
+                                         region->slot_size, 0, size, NULL, NULL);
+            gst_mini_object_set_qdata(GST_MINI_OBJECT_CAST(mem),
+                                      gst_persistent_slot_quark(), slot, gst_persistent_slot_free);
+        }
+    }
+    if (!mem)
+        region->system_buffers++;
+    g_mutex_unlock(&region->lock);
+
+    return mem;
+}
+
+gboolean
+gst_persistent_buffer_get_offset(GstBuffer *buffer, gsize *offset)
+{
+    GstMemory *mem;
+    GstPersistentSlot *slot;
+    gboolean valid;
+
+    if (gst_buffer_n_memory(buffer) != 1)
+        return FALSE;
+
+    mem = gst_buffer_peek_memory(buffer, 0);
+    slot = (GstPersistentSlot *)gst_mini_object_get_qdata(GST_MINI_OBJECT_CAST(mem),
+                                                          gst_persistent_slot_quark());
+    if (!slot)
+        return FALSE;
+
+    g_mutex_lock(&slot->region->lock);
+    valid = slot->region->base != NULL;
+    g_mutex_unlock(&slot->region->lock);
+
+    if (valid && offset)
+        *offset = slot->offset + mem->offset;
+    return valid;
+}
+
+/* 缓冲的内存来自已经失效的区域：指针仍指向解除映射前的地址，不能再写入 */
+static gboolean
+gst_persistent_buffer_is_stale(GstBuffer *buffer)
+{
+    GstMemory *mem;
+    GstPersistentSlot *slot;
+    gboolean stale;
+
+    if (gst_buffer_n_memory(buffer) != 1)
+        return FALSE;
+
+    mem = gst_buffer_peek_memory(buffer, 0);
+    slot = (GstPersistentSlot *)gst_mini_object_get_qdata(GST_MINI_OBJECT_CAST(mem),
+                                                          gst_persistent_slot_quark());
+    if (!slot)
+        return FALSE;
+
+    g_mutex_lock(&slot->region->lock);
+    stale = slot->region->base == NULL;
+    g_mutex_unlock(&slot->region->lock);
+
+    return stale;
+}
+
+/* 缓冲池 */
+
+struct _GstPersistentBufferPool
+{
+    GstBufferPool parent;
+
+    GstPersistentRegion *region;
+    GstVideoInfo info;
+    guint size;
+};
+
+#define gst_persistent_buffer_pool_parent_class parent_class
+G_DEFINE_TYPE(GstPersistentBufferPool, gst_persistent_buffer_pool, GST_TYPE_BUFFER_POOL);
+
+static const gchar **
+gst_persistent_buffer_pool_get_options(GstBufferPool *pool)
+{
+    static const gchar *options[] = {GST_BUFFER_POOL_OPTION_VIDEO_META, NULL};
+    return options;
+}
+
+static gboolean
+gst_persistent_buffer_pool_set_config(GstBufferPool *pool, GstStructure *config)
+{
+    GstPersistentBufferPool *self = GST_PERSISTENT_BUFFER_POOL(pool);
+    GstCaps *caps = NULL;
+    guint size, min_buffers, max_buffers;
+
+    if (!gst_buffer_pool_config_get_params(config, &caps, &size, &min_buffers, &max_buffers) || !caps)
+    {
+        GST_WARNING_OBJECT(pool, "no caps in config");
+        return FALSE;
+    }
+    if (!gst_video_info_from_caps(&self->info, caps))
+    {
+        GST_WARNING_OBJECT(pool, "failed to parse caps %" GST_PTR_FORMAT, caps);
+        return FALSE;
+    }
+
+    /* 上游给出的 size 可能比按默认步长算出的更大 */
+    if (size < GST_VIDEO_INFO_SIZE(&self->info))
+        size = GST_VIDEO_INFO_SIZE(&self->info);
+    gst_buffer_pool_config_set_params(config, caps, size, min_buffers, max_buffers);
+    self->size = size;
+
+    return GST_BUFFER_POOL_CLASS(parent_class)->set_config(pool, config);
+}
+
+static GstFlowReturn
+gst_persistent_buffer_pool_alloc_buffer(GstBufferPool *pool, GstBuffer **buffer,
+                                        GstBufferPoolAcquireParams *params)
+{
+    GstPersistentBufferPool *self = GST_PERSISTENT_BUFFER_POOL(pool);
+    GstVideoInfo *info = &self->info;
+    gsize size = self->size;
+    GstMemory *mem;
+    GstBuffer *buf;
+
+    mem = gst_persistent_region_alloc(self->region, size);
+    if (mem)
+    {
+        buf = gst_buffer_new();
+        gst_buffer_append_memory(buf, mem);
+    }
+    else
+    {
+        /* 没有扩展或槽位用完时退回系统内存 */
+        buf = gst_buffer_new_allocate(NULL, size, NULL);
+        if (!buf)
+            return GST_FLOW_ERROR;
+    }
+
+    /* 下游按 GstVideoMeta 中的步长和偏移读取各平面 */
+    gst_buffer_add_video_meta_full(buf, GST_VIDEO_FRAME_FLAG_NONE,
+                                   GST_VIDEO_INFO_FORMAT(info),
+                                   GST_VIDEO_INFO_WIDTH(info), GST_VIDEO_INFO_HEIGHT(info),
+                                   GST_VIDEO_INFO_N_PLANES(info), info->offset, info->stride);
+
+    *buffer = buf;
+    return GST_FLOW_OK;
+}
+
+/* 池中空闲的缓冲可能在区域失效前就已归还：丢弃后重新分配（此时退回系统内存） */
+static GstFlowReturn
+gst_persistent_buffer_pool_acquire_buffer(GstBufferPool *pool, GstBuffer **buffer,
+                                          GstBufferPoolAcquireParams *params)
+{
+    GstFlowReturn ret;
+
+    while (TRUE)
+    {
+        ret = GST_BUFFER_POOL_CLASS(parent_class)->acquire_buffer(pool, buffer, params);
+        if (ret != GST_FLOW_OK || !gst_persistent_buffer_is_stale(*buffer))
+            return ret;
+
+        GST_DEBUG_OBJECT(pool, "discarding buffer %p from an invalidated region", *buffer);
+        GST_BUFFER_FLAG_SET(*buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+        GST_BUFFER_POOL_CLASS(parent_class)->release_buffer(pool, *buffer);
+        *buffer = NULL;
+    }
+}
+
+/* 区域失效后归还的缓冲不能回到池中复用：标记 TAG_MEMORY，父类会直接释放它 */
+static void
+gst_persistent_buffer_pool_release_buffer(GstBufferPool *pool, GstBuffer *buffer)
+{
+    if (gst_persistent_buffer_is_stale(buffer))
+        GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+
+    GST_BUFFER_POOL_CLASS(parent_class)->release_buffer(pool, buffer);
+}
+
+static void
+gst_persistent_buffer_pool_finalize(GObject *object)
+{
+    GstPersistentBufferPool *self = GST_PERSISTENT_BUFFER_POOL(object);
+
+    if (self->region)
+        gst_persistent_region_unref(self->region);
+
+    G_OBJECT_CLASS(parent_class)->finalize(object);
+}
+
+static void
+gst_persistent_buffer_pool_class_init(GstPersistentBufferPoolClass *klass)
+{
+    GObjectClass *gobject_class = (GObjectClass *)klass;
+    GstBufferPoolClass *pool_class = (GstBufferPoolClass *)klass;
+
+    gobject_class->finalize = gst_persistent_buffer_pool_finalize;
+
+    pool_class->get_options = gst_persistent_buffer_pool_get_options;
+    pool_class->set_config = gst_persistent_buffer_pool_set_config;
+    pool_class->alloc_buffer = gst_persistent_buffer_pool_alloc_buffer;
+    pool_class->acquire_buffer = gst_persistent_buffer_pool_acquire_buffer;
+    pool_class->release_buffer = gst_persistent_buffer_pool_release_buffer;
+
+    GST_DEBUG_CATEGORY_INIT(gst_persistent_pool_debug, "persistentpool", 0,
+                            "persistent mapped GL buffer pool");
+}
+
+static void
+gst_persistent_buffer_pool_init(GstPersistentBufferPool *self)
+{
+    gst_video_info_init(&self->info);
+}
+
+GstBufferPool *
+gst_persistent_buffer_pool_new(GstPersistentRegion *region)
+{
+    GstPersistentBufferPool *pool = g_object_new(GST_TYPE_PERSISTENT_BUFFER_POOL, NULL);
+
+    pool->region = gst_persistent_region_ref(region);
+    gst_object_ref_sink(pool);
+
+    return GST_BUFFER_POOL_CAST(pool);
+}
@@ -0,0 +1,37 @@
+#ifndef __GST_PERSISTENT_POOL_H__
+#define __GST_PERSISTENT_POOL_H__
+
+#include "gst/gst.h"
+#include "gst/video/video.h"
+
+G_BEGIN_DECLS
+
+/* 持久映射区域：一块由 glBufferStorage + GL_MAP_PERSISTENT_BIT 映射的内存，
+ * 按固定大小切成若干槽位。区域由渲染线程创建，可被多个缓冲池共享。
+ * base 为 NULL 时表示没有可用的 GL 内存，所有缓冲都退回系统内存。 */
+typedef struct _GstPersistentRegion GstPersistentRegion;
+
+GstPersistentRegion *gst_persistent_region_new(guint8 *base, gsize slot_size, guint n_slots);
+GstPersistentRegion *gst_persistent_region_ref(GstPersistentRegion *region);
+void gst_persistent_region_unref(GstPersistentRegion *region);
+/* GL 缓冲解除映射前调用：之后新分配的缓冲全部使用系统内存，归还到缓冲池的旧缓冲被丢弃。
+ * 已经包装好的 GstMemory 仍指向原地址，调用者必须先让所有使用这些缓冲池的管道进入 NULL。
+ * 返回仍被占用的槽位数，不为 0 说明还有缓冲在外面 */
+guint gst_persistent_region_invalidate(GstPersistentRegion *region);
+/* 槽位使用统计 */
+void gst_persistent_region_get_stats(GstPersistentRegion *region,
+                                     guint64 *gl_buffers, guint64 *system_buffers);
+
+#define GST_TYPE_PERSISTENT_BUFFER_POOL (gst_persistent_buffer_pool_get_type())
+G_DECLARE_FINAL_TYPE(GstPersistentBufferPool, gst_persistent_buffer_pool,
+                     GST, PERSISTENT_BUFFER_POOL, GstBufferPool)
+
+/* 从区域中分配视频缓冲的缓冲池，带 GstVideoMeta，区域不足时使用系统内存 */
+GstBufferPool *gst_persistent_buffer_pool_new(GstPersistentRegion *region);
+
+/* 如果 buffer 的像素位于持久映射区域中，返回 TRUE 并给出相对区域起点的偏移量 */
+gboolean gst_persistent_buffer_get_offset(GstBuffer *buffer, gsize *offset);
+
+G_END_DECLS
+
+#endif /* __GST_PERSISTENT_POOL_H__ */
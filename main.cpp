@@ -1,4 +1,91 @@
+#include "DecoderSelection.hpp"
+#include "FrameServer.hpp"
 #include "GstOpenGLPlayer.hpp"
+#include "VideoWallPlayer.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+// 数值参数：整个值都必须是数字且不小于 min_value，否则打印错误（std::stoi 遇到非法输入会抛异常）
+static bool parse_int_flag(const std::string &arg, size_t prefix, int min_value, int &value)
+{
+    const char *text = arg.c_str() + prefix;
+    char *end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < min_value || parsed > INT_MAX)
+    {
+        std::cerr << "Invalid value in " << arg << " (expected an integer >= " << min_value << ")" << std::endl;
+        return false;
+    }
+    value = (int)parsed;
+    return true;
+}
+
+static bool parse_double_flag(const std::string &arg, size_t prefix, double &value)
+{
+    const char *text = arg.c_str() + prefix;
+    char *end = nullptr;
+    errno = 0;
+    double parsed = std::strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE)
+    {
+        std::cerr << "Invalid value in " << arg << " (expected a number)" << std::endl;
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+static bool parse_base_time(const std::string &arg, size_t prefix, GstClockTime &value)
+{
+    const char *text = arg.c_str() + prefix;
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    // strtoull 会接受负号并回绕
+    if (end == text || *end != '\0' || errno == ERANGE || *text == '-')
+    {
+        std::cerr << "Invalid value in " << arg << " (expected nanoseconds)" << std::endl;
+        return false;
+    }
+    value = (GstClockTime)parsed;
+    return true;
+}
+
+// --crop=x,y,w,h：归一化坐标，区域必须落在画面内（允许三分之一之类的舍入误差）
+static bool parse_crop(const std::string &arg, size_t prefix, CropRect &crop)
+{
+    const float slack = 1e-4f;
+    CropRect parsed;
+    int consumed = 0;
+    if (sscanf(arg.c_str() + prefix, "%f,%f,%f,%f%n", &parsed.x, &parsed.y, &parsed.width, &parsed.height, &consumed) != 4 ||
+        arg[prefix + consumed] != '\0' || parsed.x < 0.0f || parsed.y < 0.0f || parsed.width <= 0.0f || parsed.height <= 0.0f ||
+        parsed.x + parsed.width > 1.0f + slack || parsed.y + parsed.height > 1.0f + slack)
+    {
+        std::cerr << "Invalid value in " << arg << " (expected x,y,w,h within 0..1)" << std::endl;
+        return false;
+    }
+    crop = parsed;
+    return true;
+}
+
+// --tile-size=WxH
+static bool parse_size(const std::string &arg, size_t prefix, int &width, int &height)
+{
+    int w = 0, h = 0, consumed = 0;
+    if (sscanf(arg.c_str() + prefix, "%dx%d%n", &w, &h, &consumed) != 2 || arg[prefix + consumed] != '\0' || w <= 0 || h <= 0)
+    {
+        std::cerr << "Invalid value in " << arg << " (expected WIDTHxHEIGHT)" << std::endl;
+        return false;
+    }
+    width = w;
+    height = h;
+    return true;
+}
+
 int main(int argc, char *argv[])
 {
     // std::string video_source = "https://gstreamer.freedesktop.org/data/media/sintel_trailer-480p.webm"; // 默认使用测试源
@@ -6,9 +93,185 @@ int main(int argc, char *argv[])
     // std::string video_source = "./sample_720p.mp4"; // 默认使用测试源
     std::string video_source = "./test.webm"; // 默认使用测试源
 
-    if (argc > 1)
+    PlayerOptions options;
+    // 电视墙：--wall 之后所有非选项参数都是视频源
+    bool wall_mode = false;
+    WallOptions wall_options;
+    std::vector<std::string> wall_sources;
+    // 帧服务：只解码并写进共享帧环，渲染进程用 "shm:PATH" 作为视频源
+    FrameServerOptions server_options;
+    // 解码器 rank：对所有模式的自动选择（decodebin3/uridecodebin）都生效
+    DecoderRankPolicy decoder_ranks;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--zero-copy")
+            options.handoff = FrameHandoff::ZeroCopy;
+        else if (arg == "--delivery=callbacks")
+            options.delivery = SampleDelivery::Callbacks;
+        else if (arg == "--delivery=pull")
+            options.delivery = SampleDelivery::Pull;
+        else if (arg == "--delivery=signal")
+            options.delivery = SampleDelivery::Signal;
+        else if (arg == "--persistent")
+            options.upload = TextureUpload::PersistentPool;
+        else if (arg == "--gl-memory")
+            options.upload = TextureUpload::GLMemory;
+        else if (arg == "--dirty-tiles")
+            options.dirty_tiles = true;
+        else if (arg.find("--dirty-tiles=") == 0)
+        {
+            options.dirty_tiles = true;
+            if (!parse_int_flag(arg, 14, 1, options.tile_size))
+                return 1;
+        }
+        else if (arg == "--render-loop=poll")
+            options.render_loop = RenderLoop::Poll;
+        else if (arg == "--render-loop=event")
+            options.render_loop = RenderLoop::Event;
+        else if (arg == "--schedule")
+            options.pts_schedule = true;
+        else if (arg.find("--late-drop=") == 0)
+        {
+            options.pts_schedule = true;
+            if (!parse_double_flag(arg, 12, options.late_drop_ms))
+                return 1;
+        }
+        else if (arg == "--swap-interval=0")
+            options.swap_interval = SwapInterval::Immediate;
+        else if (arg == "--swap-interval=1")
+            options.swap_interval = SwapInterval::Vsync;
+        else if (arg == "--swap-interval=adaptive")
+            options.swap_interval = SwapInterval::Adaptive;
+        else if (arg.find("--pacing-log=") == 0)
+            options.pacing_log = arg.substr(13);
+        else if (arg == "--upload-thread")
+            options.upload_thread = true;
+        else if (arg == "--headless")
+            options.headless = true;
+        else if (arg.find("--frames=") == 0)
+        {
+            if (!parse_int_flag(arg, 9, 0, options.headless_frames))
+                return 1;
+        }
+        else if (arg.find("--snapshot=") == 0)
+            options.headless_snapshot = arg.substr(11);
+        else if (arg == "--scale=bilinear")
+            options.scale_filter = ScaleFilter::Bilinear;
+        else if (arg == "--scale=mipmap")
+            options.scale_filter = ScaleFilter::Mipmap;
+        else if (arg == "--scale=bicubic")
+            options.scale_filter = ScaleFilter::Bicubic;
+        else if (arg == "--scale=lanczos")
+            options.scale_filter = ScaleFilter::Lanczos;
+        else if (arg == "--stretch")
+            options.keep_aspect = false;
+        else if (arg.find("--crop=") == 0)
+        {
+            if (!parse_crop(arg, 7, options.crop))
+                return 1;
+        }
+        else if (arg.find("--net-clock-serve=") == 0)
+        {
+            if (!parse_int_flag(arg, 18, 0, options.net_clock_port))
+                return 1;
+        }
+        else if (arg.find("--net-clock=") == 0)
+            options.net_clock = arg.substr(12);
+        else if (arg.find("--base-time=") == 0)
+        {
+            if (!parse_base_time(arg, 12, options.net_base_time))
+                return 1;
+        }
+        else if (arg == "--rgba")
+            options.native_yuv = false;
+        else if (arg == "--pbo")
+            options.upload = TextureUpload::Pbo;
+        else if (arg.find("--pbo=") == 0)
+        {
+            options.upload = TextureUpload::Pbo;
+            if (!parse_int_flag(arg, 6, 1, options.pbo_count))
+                return 1;
+        }
+        else if (arg.find("--serve-frames=") == 0)
+            server_options.path = arg.substr(15);
+        else if (arg.find("--prewarm=") == 0)
+            options.prewarm_sources.push_back(arg.substr(10));
+        else if (arg.find("--pool-size=") == 0)
+        {
+            if (!parse_int_flag(arg, 12, 0, options.pipeline_pool_size))
+                return 1;
+        }
+        else if (arg.find("--switch-every=") == 0)
+        {
+            if (!parse_int_flag(arg, 15, 0, options.switch_every_frames))
+                return 1;
+        }
+        else if (arg.find("--decoder-rank=") == 0)
+        {
+            if (!parse_decoder_ranks(arg.substr(15), decoder_ranks))
+                return 1;
+        }
+        else if (arg == "--prefer-threaded-decoders")
+            decoder_ranks.prefer_threaded = true;
+        else if (arg == "--wall")
+            wall_mode = true;
+        else if (arg.find("--layout=") == 0)
+            wall_options.layout = arg.substr(9);
+        else if (arg.find("--tile-size=") == 0)
+        {
+            if (!parse_size(arg, 12, wall_options.tile_width, wall_options.tile_height))
+                return 1;
+        }
+        else if (arg == "--sync")
+            wall_options.sync = true;
+        else if (arg == "--decode-budget")
+            wall_options.decode_tiers = true;
+        else if (arg.find("--decode-budget=") == 0)
+        {
+            wall_options.decode_tiers = true;
+            if (!parse_double_flag(arg, 16, wall_options.budget.core_budget))
+                return 1;
+        }
+        else
+        {
+            video_source = arg;
+            wall_sources.push_back(arg);
+        }
+    }
+
+    if (!decoder_ranks.ranks.empty() || decoder_ranks.prefer_threaded)
+    {
+        gst_init(nullptr, nullptr);
+        apply_decoder_ranks(decoder_ranks);
+    }
+
+    if (!server_options.path.empty())
+    {
+        server_options.native_yuv = options.native_yuv;
+        FrameServer server;
+        if (!server.initialize(video_source, server_options))
+        {
+            std::cerr << "Failed to initialize frame server" << std::endl;
+            return 1;
+        }
+        server.run();
+        std::cout << "Frame server stopped" << std::endl;
+        return 0;
+    }
+
+    if (wall_mode)
     {
-        video_source = argv[1];
+        wall_options.vsync = options.swap_interval != SwapInterval::Immediate;
+        VideoWallPlayer wall(1280, 720);
+        if (!wall.initialize(wall_sources, wall_options))
+        {
+            std::cerr << "Failed to initialize video wall" << std::endl;
+            return 1;
+        }
+        wall.run();
+        std::cout << "Video wall stopped" << std::endl;
+        return 0;
     }
 
     std::cout << "Starting GStreamer + OpenGL video player..." << std::endl;
@@ -16,7 +279,7 @@ int main(int argc, char *argv[])
 
     GstOpenGLPlayer player(1280, 720);
  
-    if (!player.initialize(video_source))
+    if (!player.initialize(video_source, options))
     {
         std::cerr << "Failed to initialize player" << std::endl;
         return 1;
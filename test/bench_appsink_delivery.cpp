@@ -0,0 +1,163 @@
+#include "gst/gst.h"
+#include "gst/app/gstappsink.h"
+#include "../CpuUsage.hpp"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+// 比较 appsink 三种帧投递方式的每帧 CPU 开销与投递延迟：
+//   signal    - emit-signals + new-sample 信号
+//   callbacks - gst_app_sink_set_callbacks
+//   pull      - 消费线程按刷新周期 gst_app_sink_try_pull_sample
+// 用法: bench_appsink_delivery [宽] [高] [帧率] [秒数]
+
+enum class Mode
+{
+    Signal,
+    Callbacks,
+    Pull
+};
+
+struct BenchContext
+{
+    GstElement *pipeline = nullptr;
+    GstElement *sink = nullptr;
+    std::mutex mutex;
+    guint64 frames = 0;
+    double latency_sum_ms = 0.0;
+    double latency_max_ms = 0.0;
+};
+
+// 投递延迟：收到 sample 的时钟时间 - buffer 的期望呈现时间
+static void record_sample(BenchContext *ctx, GstSample *sample)
+{
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    const GstSegment *segment = gst_sample_get_segment(sample);
+    GstClock *clock = gst_element_get_clock(ctx->pipeline);
+    if (buffer && segment && clock && GST_BUFFER_PTS_IS_VALID(buffer))
+    {
+        GstClockTime now = gst_clock_get_time(clock);
+        GstClockTime running_time = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+        GstClockTime due = gst_element_get_base_time(ctx->pipeline) + running_time;
+        double latency_ms = now > due ? (double)(now - due) / GST_MSECOND : 0.0;
+
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        ctx->frames++;
+        ctx->latency_sum_ms += latency_ms;
+        if (latency_ms > ctx->latency_max_ms)
+            ctx->latency_max_ms = latency_ms;
+    }
+    if (clock)
+        gst_object_unref(clock);
+    gst_sample_unref(sample);
+}
+
+static GstFlowReturn on_new_sample_signal(GstElement *sink, gpointer data)
+{
+    GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
+    if (!sample)
+        return GST_FLOW_ERROR;
+    record_sample(static_cast<BenchContext *>(data), sample);
+    return GST_FLOW_OK;
+}
+
+static GstFlowReturn on_new_sample_callback(GstAppSink *sink, gpointer data)
+{
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (!sample)
+        return GST_FLOW_ERROR;
+    record_sample(static_cast<BenchContext *>(data), sample);
+    return GST_FLOW_OK;
+}
+
+static bool run_mode(Mode mode, const char *name, int width, int height, int fps, int seconds)
+{
+    std::string caps = "video/x-raw,format=RGBA,width=" + std::to_string(width) +
+                       ",height=" + std::to_string(height) +
+                       ",framerate=" + std::to_string(fps) + "/1";
+    std::string pipeline_str = "videotestsrc is-live=true pattern=ball ! " + caps +
+                               " ! queue ! appsink name=sink sync=false max-buffers=1 drop=true";
+
+    BenchContext ctx;
+    GError *error = nullptr;
+    ctx.pipeline = gst_parse_launch(pipeline_str.c_str(), &error);
+    if (error)
+    {
+        std::cout << "Failed to create pipeline: " << error->message << std::endl;
+        g_error_free(error);
+        return false;
+    }
+    ctx.sink = gst_bin_get_by_name(GST_BIN(ctx.pipeline), "sink");
+
+    switch (mode)
+    {
+    case Mode::Signal:
+        g_object_set(ctx.sink, "emit-signals", TRUE, nullptr);
+        g_signal_connect(ctx.sink, "new-sample", G_CALLBACK(on_new_sample_signal), &ctx);
+        break;
+    case Mode::Callbacks:
+    {
+        GstAppSinkCallbacks callbacks = {};
+        callbacks.new_sample = on_new_sample_callback;
+        gst_app_sink_set_callbacks(GST_APP_SINK(ctx.sink), &callbacks, &ctx, nullptr);
+        break;
+    }
+    case Mode::Pull:
+        break;
+    }
+
+    gst_element_set_state(ctx.pipeline, GST_STATE_PLAYING);
+    gst_element_get_state(ctx.pipeline, nullptr, nullptr, 5 * GST_SECOND);
+
+    double cpu_start = process_cpu_seconds();
+    gint64 end_time = g_get_monotonic_time() + (gint64)seconds * G_USEC_PER_SEC;
+    if (mode == Mode::Pull)
+    {
+        // 模拟渲染循环：每次最多等待一个 60Hz 刷新周期
+        while (g_get_monotonic_time() < end_time)
+        {
+            GstSample *sample = gst_app_sink_try_pull_sample(GST_APP_SINK(ctx.sink), GST_SECOND / 60);
+            if (sample)
+                record_sample(&ctx, sample);
+        }
+    }
+    else
+    {
+        g_usleep((gulong)seconds * G_USEC_PER_SEC);
+    }
+    double cpu_used = process_cpu_seconds() - cpu_start;
+
+    gst_element_set_state(ctx.pipeline, GST_STATE_NULL);
+    gst_object_unref(ctx.sink);
+    gst_object_unref(ctx.pipeline);
+
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    double frames = ctx.frames ? (double)ctx.frames : 1.0;
+    std::cout << std::left << std::setw(10) << name
+              << " frames=" << std::setw(6) << ctx.frames
+              << " cpu/frame=" << std::fixed << std::setprecision(1) << std::setw(8) << cpu_used * 1e6 / frames << "us"
+              << " latency avg=" << std::setprecision(2) << ctx.latency_sum_ms / frames << "ms"
+              << " max=" << ctx.latency_max_ms << "ms" << std::endl;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    int width = argc > 1 ? std::atoi(argv[1]) : 1280;
+    int height = argc > 2 ? std::atoi(argv[2]) : 720;
+    int fps = argc > 3 ? std::atoi(argv[3]) : 60;
+    int seconds = argc > 4 ? std::atoi(argv[4]) : 5;
+
+    std::cout << "=== appsink delivery benchmark " << width << "x" << height << "@" << fps
+              << " for " << seconds << "s per mode ===" << std::endl;
+
+    bool ok = run_mode(Mode::Signal, "signal", width, height, fps, seconds);
+    ok = run_mode(Mode::Callbacks, "callbacks", width, height, fps, seconds) && ok;
+    ok = run_mode(Mode::Pull, "pull", width, height, fps, seconds) && ok;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+#include "gst/gst.h"
+#include "gst/rtsp-server/rtsp-server.h"
+#include "../CpuUsage.hpp"
+#include "../DecodeBudget.hpp"
+#include "../DecodeTierGate.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// NVR 解码档位：用本地 RTSP 替身摄像头（子进程中的 gst-rtsp-server，videotestsrc + x264enc）检查
+//   1. 各档位的解码帧率与解码 CPU：全帧率 / 降帧率 / 只解关键帧 / 暂停
+//   2. 从暂停恢复到全帧率的时间不超过一个 GOP
+//   3. 4x4 网格在核预算一半时，DecodeBudget 把测得的占用压到预算附近，最大的格子保持全帧率
+// 用法: bench_nvr_standins [路数] [每阶段秒数] [端口]
+//       bench_nvr_standins --serve 路数 端口 秒数   （内部使用：替身服务器）
+
+static const int kFps = 30;
+static const int kGop = 30; // 1 秒一个关键帧
+
+static gboolean quit_loop(gpointer data)
+{
+    g_main_loop_quit(static_cast<GMainLoop *>(data));
+    return FALSE;
+}
+
+// 替身服务器：/cam0 .. /camN-1，每路一个独立编码器，运行 seconds 秒后退出
+static int serve(int streams, const char *port, int seconds)
+{
+    GstRTSPServer *server = gst_rtsp_server_new();
+    gst_rtsp_server_set_service(server, port);
+    GstRTSPMountPoints *mounts = gst_rtsp_server_get_mount_points(server);
+    for (int i = 0; i < streams; ++i)
+    {
+        std::string launch = "( videotestsrc is-live=true pattern=" + std::to_string(i % 20) +
+                             " ! video/x-raw,width=640,height=360,framerate=" + std::to_string(kFps) + "/1"
+                             " ! x264enc tune=zerolatency speed-preset=ultrafast key-int-max=" + std::to_string(kGop) +
+                             " ! rtph264pay name=pay0 pt=96 )";
+        GstRTSPMediaFactory *factory = gst_rtsp_media_factory_new();
+        gst_rtsp_media_factory_set_launch(factory, launch.c_str());
+        gst_rtsp_media_factory_set_shared(factory, TRUE);
+        gst_rtsp_mount_points_add_factory(mounts, ("/cam" + std::to_string(i)).c_str(), factory);
+    }
+    g_object_unref(mounts);
+    if (!gst_rtsp_server_attach(server, nullptr))
+    {
+        std::cout << "Failed to start RTSP server on port " << port << std::endl;
+        return 1;
+    }
+
+    GMainLoop *loop = g_main_loop_new(nullptr, FALSE);
+    g_timeout_add((guint)seconds * 1000, quit_loop, loop);
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+    g_object_unref(server);
+    return 0;
+}
+
+struct Camera
+{
+    GstElement *pipeline = nullptr;
+    DecodeTierGate gate;
+};
+
+struct PhaseResult
+{
+    double cores = 0.0;          // 解码端进程的平均核占用
+    double decoded_fps = 0.0;    // 每路平均解码帧率
+    double delivered_fps = 0.0;  // 每路平均送到 sink 的帧率
+};
+
+static PhaseResult run_phase(std::vector<std::unique_ptr<Camera>> &cameras, int seconds)
+{
+    std::vector<DecodeGateStats> before;
+    for (auto &camera : cameras)
+        before.push_back(camera->gate.stats());
+    double cpu_start = process_cpu_seconds();
+    g_usleep((gulong)seconds * G_USEC_PER_SEC);
+
+    PhaseResult result;
+    result.cores = (process_cpu_seconds() - cpu_start) / seconds;
+    for (size_t i = 0; i < cameras.size(); ++i)
+    {
+        DecodeGateStats after = cameras[i]->gate.stats();
+        uint64_t decoded = after.decoded - before[i].decoded;
+        uint64_t dropped = after.dropped_after - before[i].dropped_after;
+        result.decoded_fps += (double)decoded / seconds / cameras.size();
+        result.delivered_fps += (double)(decoded - dropped) / seconds / cameras.size();
+    }
+    return result;
+}
+
+static void print_phase(const char *name, const PhaseResult &result)
+{
+    std::cout << std::left << std::setw(10) << name << std::fixed << std::setprecision(2)
+              << " cores=" << std::setw(6) << result.cores
+              << " decoded=" << std::setw(6) << result.decoded_fps << "fps"
+              << " delivered=" << result.delivered_fps << "fps" << std::endl;
+}
+
+static void set_all(std::vector<std::unique_ptr<Camera>> &cameras, DecodeTier tier)
+{
+    for (auto &camera : cameras)
+        camera->gate.set_tier(tier);
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+    if (argc == 5 && strcmp(argv[1], "--serve") == 0)
+        return serve(std::atoi(argv[2]), argv[3], std::atoi(argv[4]));
+
+    int streams = argc > 1 ? std::atoi(argv[1]) : 16;
+    int seconds = argc > 2 ? std::atoi(argv[2]) : 4;
+    std::string port = argc > 3 ? argv[3] : "8554";
+
+    const char *required[] = {"x264enc", "rtph264pay", "rtspsrc", "avdec_h264"};
+    for (const char *name : required)
+    {
+        GstElementFactory *factory = gst_element_factory_find(name);
+        if (!factory)
+        {
+            std::cout << "Missing " << name << ", skipped" << std::endl;
+            return 0;
+        }
+        gst_object_unref(factory);
+    }
+
+    // 编码在子进程中，测得的 CPU 只包含接收和解码
+    const int phases = 7;
+    std::string serve_seconds = std::to_string(seconds * (phases + 4) + 10);
+    std::string serve_streams = std::to_string(streams);
+    gchar *serve_argv[] = {argv[0], (gchar *)"--serve", (gchar *)serve_streams.c_str(), (gchar *)port.c_str(),
+                           (gchar *)serve_seconds.c_str(), nullptr};
+    GError *error = nullptr;
+    if (!g_spawn_async(nullptr, serve_argv, nullptr, G_SPAWN_DEFAULT, nullptr, nullptr, nullptr, &error))
+    {
+        std::cout << "Failed to start stand-in server: " << error->message << std::endl;
+        g_error_free(error);
+        return 1;
+    }
+    g_usleep(G_USEC_PER_SEC);
+
+    std::cout << "=== NVR decode tiers, " << streams << " RTSP stand-ins, GOP " << kGop << " @ " << kFps << "fps ===" << std::endl;
+    std::vector<std::unique_ptr<Camera>> cameras;
+    for (int i = 0; i < streams; ++i)
+    {
+        std::unique_ptr<Camera> camera(new Camera());
+        std::string launch = "rtspsrc location=rtsp://127.0.0.1:" + port + "/cam" + std::to_string(i) +
+                             " latency=100 protocols=tcp ! decodebin ! fakesink sync=false";
+        camera->pipeline = gst_parse_launch(launch.c_str(), &error);
+        if (error)
+        {
+            std::cout << "Failed to create client: " << error->message << std::endl;
+            g_error_free(error);
+            return 1;
+        }
+        camera->gate.attach(camera->pipeline);
+        gst_element_set_state(camera->pipeline, GST_STATE_PLAYING);
+        cameras.push_back(std::move(camera));
+    }
+    // 等待连接和第一个关键帧
+    g_usleep(2 * G_USEC_PER_SEC);
+    for (auto &camera : cameras)
+        check(camera->gate.has_decoder(), "decoder found inside decodebin");
+
+    PhaseResult full = run_phase(cameras, seconds);
+    print_phase("full", full);
+    check(full.decoded_fps > kFps * 0.8, "full rate decodes every frame");
+
+    set_all(cameras, DecodeTier::Reduced);
+    PhaseResult reduced = run_phase(cameras, seconds);
+    print_phase("reduced", reduced);
+    check(reduced.delivered_fps < full.delivered_fps * 0.6, "reduced rate delivers about half the frames");
+
+    set_all(cameras, DecodeTier::KeyOnly);
+    PhaseResult keyframes = run_phase(cameras, seconds);
+    print_phase("keyframes", keyframes);
+    check(keyframes.decoded_fps > 0.0 && keyframes.decoded_fps <= 2.0 * kFps / kGop, "keyframe tier decodes one frame per GOP");
+
+    set_all(cameras, DecodeTier::Paused);
+    PhaseResult paused = run_phase(cameras, seconds);
+    print_phase("paused", paused);
+    // 解码器内部排队的几帧在切换后仍会输出
+    check(paused.decoded_fps < 0.5, "paused tier decodes nothing");
+
+    // 恢复全帧率：每路都应在一个 GOP 内等到关键帧
+    set_all(cameras, DecodeTier::Full);
+    PhaseResult resumed = run_phase(cameras, seconds);
+    print_phase("resumed", resumed);
+    double latency_max = 0.0;
+    for (auto &camera : cameras)
+    {
+        DecodeGateStats stats = camera->gate.stats();
+        check(stats.promotions == 1, "every stream resumed once");
+        if (stats.promote_latency_max_ms > latency_max)
+            latency_max = stats.promote_latency_max_ms;
+    }
+    std::cout << "resume to first keyframe: max " << latency_max << " ms (GOP " << 1000.0 * kGop / kFps << " ms)" << std::endl;
+    check(latency_max <= 1000.0 * kGop / kFps + 250.0, "resume within one GOP");
+
+    // 4x4 网格（1920x1080 窗口，每格 480x270），预算为全帧率占用的一半
+    DecodeBudgetOptions options;
+    options.core_budget = full.cores * 0.5;
+    DecodeBudget budget;
+    budget.reset(streams, options);
+    for (int i = 0; i < streams; ++i)
+        budget.set_tile(i, true, 480.0 * 270.0 + i);
+    PhaseResult budgeted;
+    for (int round = 0; round < seconds * 4; ++round)
+    {
+        budgeted = run_phase(cameras, 1);
+        if (budget.evaluate(budgeted.cores))
+        {
+            for (int i = 0; i < streams; ++i)
+                cameras[i]->gate.set_tier(budget.tier(i));
+        }
+    }
+    budgeted = run_phase(cameras, seconds);
+    print_phase("budget", budgeted);
+    int counts[(int)DecodeTier::Count] = {};
+    for (int i = 0; i < streams; ++i)
+        counts[(int)budget.tier(i)]++;
+    std::cout << "budget " << options.core_budget << " cores:";
+    for (int t = 0; t < (int)DecodeTier::Count; ++t)
+        std::cout << " " << decode_tier_name((DecodeTier)t) << "=" << counts[t];
+    std::cout << std::endl;
+    check(budgeted.cores <= options.core_budget * 1.25, "measured load settles near the budget");
+    check(budget.tier(streams - 1) == DecodeTier::Full, "largest tile keeps full rate");
+
+    // 放大第 0 路（最小、降级最多的格子）：下一个 GOP 内恢复全帧率
+    uint64_t promotions = cameras[0]->gate.stats().promotions;
+    DecodeTier before_focus = cameras[0]->gate.tier();
+    budget.set_tile(0, true, 1920.0 * 1080.0);
+    for (int i = 1; i < streams; ++i)
+        budget.set_tile(i, false, 0.0);
+    for (int i = 0; i < streams; ++i)
+        cameras[i]->gate.set_tier(budget.tier(i));
+    run_phase(cameras, 2);
+    DecodeGateStats focused = cameras[0]->gate.stats();
+    check(budget.tier(0) == DecodeTier::Full, "enlarged stream is promoted");
+    // 只有从关键帧档位恢复才需要等关键帧
+    check((int)before_focus < (int)DecodeTier::KeyOnly || focused.promotions > promotions, "enlarged stream resumed decoding");
+    check(focused.promote_latency_max_ms <= 1000.0 * kGop / kFps + 250.0, "enlarged stream resumed within one GOP");
+    std::cout << "focus: stream 0 " << decode_tier_name(budget.tier(0)) << ", resume max " << focused.promote_latency_max_ms << " ms" << std::endl;
+
+    for (auto &camera : cameras)
+    {
+        gst_element_set_state(camera->pipeline, GST_STATE_NULL);
+        camera->gate.detach();
+        gst_object_unref(camera->pipeline);
+    }
+
+    return check_result();
+}
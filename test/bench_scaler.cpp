@@ -0,0 +1,204 @@
+#include "glad/glad.h"
+#include "../OffscreenContext.hpp"
+#include "../VideoScaler.hpp"
+#include "../gl_utils.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// GPU 缩放档位的正确性与耗时（离屏 EGL 上下文，没有 EGL 时跳过）：
+//   1. letterbox_viewport 的黑边计算
+//   2. 1 像素棋盘格缩小 3 倍：mipmap/bicubic/lanczos 的混叠（输出标准差）应低于 bilinear
+//   3. 目标尺寸变化不重新分配中间纹理
+//   4. 1080p 源缩放到 360p / 720p / 2160p 的每帧 GPU 时间
+
+static void check_letterbox()
+{
+    ScaleViewport view = letterbox_viewport(1000, 1000, 1920, 1080);
+    check(view.x == 0 && view.width == 1000 && view.height == 563 && view.y == 218, "wide video gets top/bottom bars");
+    view = letterbox_viewport(1920, 1080, 720, 960);
+    check(view.y == 0 && view.height == 1080 && view.width == 810 && view.x == 555, "tall video gets side bars");
+    view = letterbox_viewport(1280, 720, 1920, 1080);
+    check(view.x == 0 && view.y == 0 && view.width == 1280 && view.height == 720, "same aspect fills the target");
+}
+
+struct Target
+{
+    GLuint fbo = 0;
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+};
+
+static Target make_target(int width, int height)
+{
+    Target target;
+    target.width = width;
+    target.height = height;
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    return target;
+}
+
+static void free_target(Target &target)
+{
+    glDeleteFramebuffers(1, &target.fbo);
+    glDeleteTextures(1, &target.texture);
+}
+
+// 与播放器 render_frame 相同的流程：颜色转换（RGBA 变体）+ 缩放
+static void draw_frame(VideoScaler &scaler, GLuint program, GLuint source, int width, int height, const Target &target, GLuint vao)
+{
+    ScaleViewport view = letterbox_viewport(target.width, target.height, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glViewport(0, 0, target.width, target.height);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    scaler.begin_frame();
+    if (scaler.uses_intermediate())
+        scaler.bind_intermediate(width, height);
+    else
+        glViewport(view.x, view.y, view.width, view.height);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glUseProgram(program);
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    if (scaler.uses_intermediate())
+        scaler.draw_scaled(target.fbo, view, vao);
+    scaler.end_frame();
+}
+
+// 目标中心区域亮度的标准差
+static double center_stddev(const Target &target)
+{
+    int w = target.width / 2, h = target.height / 2;
+    std::vector<uint8_t> pixels((size_t)w * h * 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glReadPixels(target.width / 4, target.height / 4, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    double sum = 0.0, sq = 0.0;
+    for (size_t i = 0; i < pixels.size(); i += 4)
+    {
+        sum += pixels[i];
+        sq += (double)pixels[i] * pixels[i];
+    }
+    double n = (double)w * h;
+    double mean = sum / n;
+    return std::sqrt(std::fabs(sq / n - mean * mean));
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 10;
+    check_letterbox();
+
+    OffscreenContext context;
+    if (!context.create() || !context.make_current() || !gladLoadGLLoader((GLADloadproc)OffscreenContext::get_proc_address))
+    {
+        std::cout << "No offscreen GL context, GPU cases skipped" << std::endl;
+        return check_result();
+    }
+    load_gl_extensions((GLADloadproc)OffscreenContext::get_proc_address);
+    std::cout << "=== GPU scaler, " << glGetString(GL_RENDERER) << " ===" << std::endl;
+
+    // 与播放器相同的全屏四边形（纹理坐标上下翻转）
+    static const float quad[16] = {-1, 1, 0, 0, -1, -1, 0, 1, 1, -1, 1, 1, 1, 1, 1, 0};
+    static const unsigned int quad_indices[6] = {0, 1, 2, 0, 2, 3};
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quad_indices), quad_indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // 1080p 的 1 像素棋盘格：最容易暴露缩小时的混叠
+    const int width = 1920, height = 1080;
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            uint8_t value = ((x + y) & 1) ? 255 : 0;
+            uint8_t *p = &pixels[((size_t)y * width + x) * 4];
+            p[0] = p[1] = p[2] = value;
+            p[3] = 255;
+        }
+    }
+    GLuint source = 0;
+    glGenTextures(1, &source);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    GLuint program = create_video_shader_program(VideoShader::Rgba);
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "colorMatrix"), 1, GL_TRUE, identity);
+
+    Target targets[3] = {make_target(640, 360), make_target(1280, 720), make_target(3840, 2160)};
+    double bilinear_stddev = 0.0;
+    for (int f = 0; f < (int)ScaleFilter::Count; ++f)
+    {
+        ScaleFilter filter = (ScaleFilter)f;
+        std::cout << std::left << std::setw(9) << scale_filter_name(filter) << std::fixed << std::setprecision(1);
+        for (const Target &target : targets)
+        {
+            VideoScaler scaler;
+            check(scaler.init(filter), "scaler init");
+            for (int i = 0; i < iterations; ++i)
+            {
+                draw_frame(scaler, program, source, width, height, target, vao);
+                glFinish();
+            }
+            // 再画一帧让最后的查询结果可取
+            draw_frame(scaler, program, source, width, height, target, vao);
+            glFinish();
+            draw_frame(scaler, program, source, width, height, target, vao);
+            const ScalerStats &stats = scaler.stats();
+            double avg = stats.gpu_samples ? stats.gpu_total_us / stats.gpu_samples : 0.0;
+            std::cout << "  " << target.height << "p " << std::setw(8) << avg << "us";
+
+            if (&target == &targets[0])
+            {
+                double stddev = center_stddev(target);
+                if (filter == ScaleFilter::Bilinear)
+                    bilinear_stddev = stddev;
+                else
+                    check(stddev < bilinear_stddev * 0.5, "less aliasing than bilinear when downscaling");
+                std::cout << " (aliasing " << std::setw(5) << stddev << ")";
+            }
+            scaler.destroy();
+        }
+        std::cout << std::endl;
+    }
+
+    // 目标尺寸变化（窗口缩放）只改变视口
+    VideoScaler scaler;
+    scaler.init(ScaleFilter::Mipmap);
+    for (const Target &target : targets)
+        draw_frame(scaler, program, source, width, height, target, vao);
+    check(scaler.stats().intermediate_allocations == 1, "resize does not reallocate the intermediate texture");
+    check(scaler.stats().mipmap_generations == 2, "mipmaps regenerated only when minifying");
+    scaler.destroy();
+
+    for (Target &target : targets)
+        free_target(target);
+    check(glGetError() == GL_NO_ERROR, "no GL errors");
+
+    return check_result();
+}
@@ -0,0 +1,131 @@
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+#include "../gl_utils.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// 比较带填充步长的帧两种上传方式的耗时：
+//   row-length - 设置 GL_UNPACK_ROW_LENGTH/ALIGNMENT 直接上传
+//   repack     - CPU 先去掉行填充再按 width*4 上传（旧做法）
+// 覆盖奇数宽度与 64/256 字节对齐的步长，RGBA 与 BGRA 两种外部格式。
+
+struct Case
+{
+    int width;
+    int height;
+    int stride_align; // 0 表示紧密排列
+};
+
+static int align_up(int value, int align)
+{
+    return align > 0 ? (value + align - 1) / align * align : value;
+}
+
+// 上传 iterations 次并等待完成，返回每帧微秒数
+template <typename UploadFn>
+static double time_uploads(int iterations, UploadFn upload)
+{
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        upload();
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+static void run_case(const Case &c, GLenum format, int iterations)
+{
+    int stride = align_up(c.width * 4, c.stride_align);
+    std::vector<uint8_t> padded((size_t)stride * c.height, 0x80);
+    std::vector<uint8_t> packed((size_t)c.width * 4 * c.height);
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, c.width, c.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    auto upload_row_length = [&]()
+    {
+        set_unpack_layout(stride, 4, (size_t)padded.data());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, c.width, c.height, format, GL_UNSIGNED_BYTE, padded.data());
+        reset_unpack_layout();
+    };
+    auto upload_repack = [&]()
+    {
+        for (int y = 0; y < c.height; ++y)
+            memcpy(packed.data() + (size_t)y * c.width * 4, padded.data() + (size_t)y * stride, (size_t)c.width * 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, c.width, c.height, format, GL_UNSIGNED_BYTE, packed.data());
+    };
+
+    double row_length_us = time_uploads(iterations, upload_row_length);
+    double repack_us = time_uploads(iterations, upload_repack);
+
+    glDeleteTextures(1, &texture);
+
+    double mb = (double)c.width * c.height * 4 / (1024.0 * 1024.0);
+    std::cout << std::right << std::setw(5) << c.width << "x" << std::left << std::setw(5) << c.height
+              << " stride=" << std::setw(6) << stride
+              << (format == GL_BGRA ? " BGRA" : " RGBA")
+              << std::fixed << std::setprecision(1)
+              << "  row-length " << std::setw(8) << row_length_us << "us (" << std::setw(6) << mb / (row_length_us * 1e-6) << " MB/s)"
+              << "  repack " << std::setw(8) << repack_us << "us (" << std::setw(6) << mb / (repack_us * 1e-6) << " MB/s)"
+              << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+
+    if (!glfwInit())
+    {
+        std::cout << "Failed to initialize GLFW" << std::endl;
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(64, 64, "bench_stride_upload", nullptr, nullptr);
+    if (!window)
+    {
+        std::cout << "Failed to create GL context" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return 1;
+    }
+    load_gl_extensions((GLADloadproc)glfwGetProcAddress);
+
+    GLenum preferred = preferred_rgba_upload_format();
+    std::cout << "=== Stride-aware upload benchmark, " << iterations << " iterations, driver prefers "
+              << (preferred == GL_BGRA ? "BGRA" : "RGBA") << " ===" << std::endl;
+
+    const Case cases[] = {
+        {1920, 1080, 0},
+        {1920, 1080, 256},
+        {1921, 1080, 0},
+        {1921, 1080, 64},
+        {1279, 719, 64},
+        {641, 481, 256},
+        {3840, 2160, 256},
+    };
+    for (const Case &c : cases)
+    {
+        run_case(c, GL_RGBA, iterations);
+        run_case(c, GL_BGRA, iterations);
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
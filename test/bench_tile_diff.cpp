@@ -0,0 +1,120 @@
+#include "../TileDiff.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 脏块比较的正确性检查与耗时：
+//   1. SIMD 与标量比较在各种长度和差异位置上结果一致
+//   2. 只改动少数像素时，只有对应的块被报告为脏块
+//   3. 1080p RGBA 帧在静止 / 少量变化 / 全部变化三种情况下的比较耗时
+
+static void check_equal_functions()
+{
+    std::mt19937 rng(1234);
+    std::vector<uint8_t> a(4096), b;
+    for (uint8_t &v : a)
+        v = (uint8_t)rng();
+
+    for (size_t size = 0; size <= 200; ++size)
+    {
+        b.assign(a.begin(), a.end());
+        check(tile_bytes_equal(a.data() + 1, b.data() + 1, size) == tile_bytes_equal_scalar(a.data() + 1, b.data() + 1, size),
+              "equal buffers");
+        for (size_t pos = 0; pos < size; pos += 7)
+        {
+            b[1 + pos] ^= 0x10;
+            bool simd = tile_bytes_equal(a.data() + 1, b.data() + 1, size);
+            check(!simd && simd == tile_bytes_equal_scalar(a.data() + 1, b.data() + 1, size), "single byte difference");
+            b[1 + pos] ^= 0x10;
+        }
+    }
+}
+
+static void check_dirty_rects()
+{
+    const int width = 1000, height = 500, stride = 1024 * 4, tile = 64;
+    std::vector<uint8_t> frame((size_t)stride * height, 0x40);
+    TileDiff diff(tile);
+
+    // 第一帧整帧上传
+    const std::vector<TileRect> &first = diff.diff(frame.data(), stride, width, height, 4);
+    check(diff.changed_tiles() == diff.total_tiles(), "first frame is fully dirty");
+    check(first.size() == (size_t)((height + tile - 1) / tile), "one merged rect per tile row");
+
+    // 静止帧没有脏块
+    check(diff.diff(frame.data(), stride, width, height, 4).empty(), "static frame has no dirty tiles");
+
+    // 改动一个像素（最后一块，宽度不足 64）以及相邻两块
+    frame[(size_t)499 * stride + 999 * 4] ^= 1;
+    frame[(size_t)70 * stride + 63 * 4] ^= 1;
+    frame[(size_t)70 * stride + 64 * 4] ^= 1;
+    const std::vector<TileRect> &rects = diff.diff(frame.data(), stride, width, height, 4);
+    check(diff.changed_tiles() == 3, "three tiles changed");
+    check(rects.size() == 2, "adjacent dirty tiles are merged");
+    if (rects.size() == 2)
+    {
+        check(rects[0].x == 0 && rects[0].y == 64 && rects[0].width == 128 && rects[0].height == 64, "merged rect");
+        check(rects[1].x == 960 && rects[1].y == 448 && rects[1].width == 40 && rects[1].height == 52, "edge rect");
+    }
+    check(diff.diff(frame.data(), stride, width, height, 4).empty(), "copy is updated after diff");
+
+    // reset 后整帧上传
+    diff.reset();
+    diff.diff(frame.data(), stride, width, height, 4);
+    check(diff.changed_tiles() == diff.total_tiles(), "reset forces full upload");
+}
+
+static void time_case(const char *name, double change_ratio, int iterations)
+{
+    const int width = 1920, height = 1080, stride = width * 4;
+    std::vector<uint8_t> frame((size_t)stride * height, 0x80);
+    std::mt19937 rng(42);
+    TileDiff diff(64);
+    diff.diff(frame.data(), stride, width, height, 4);
+
+    double total_us = 0.0;
+    size_t changed = 0, tiles = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        // 按比例随机改动一些块中的一个像素
+        int tiles_x = (width + 63) / 64, tiles_y = (height + 63) / 64;
+        int changes = (int)(tiles_x * tiles_y * change_ratio);
+        for (int c = 0; c < changes; ++c)
+        {
+            int x = (int)(rng() % width), y = (int)(rng() % height);
+            frame[(size_t)y * stride + (size_t)x * 4] ^= 0xFF;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        diff.diff(frame.data(), stride, width, height, 4);
+        auto end = std::chrono::steady_clock::now();
+        total_us += std::chrono::duration<double, std::micro>(end - start).count();
+        changed += diff.changed_tiles();
+        tiles += diff.total_tiles();
+    }
+
+    std::cout << std::left << std::setw(10) << name << std::fixed << std::setprecision(1)
+              << " diff " << std::setw(8) << total_us / iterations << "us/frame"
+              << "  changed tiles " << std::setw(5) << 100.0 * changed / tiles << "%" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 50;
+
+    std::cout << "=== Tile diff, " << tile_diff_simd_name() << " ===" << std::endl;
+    check_equal_functions();
+    check_dirty_rects();
+
+    time_case("static", 0.0, iterations);
+    time_case("5%", 0.05, iterations);
+    time_case("full", 4.0, iterations);
+
+    return check_result();
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <iostream>
+
+// 各测试共用的检查：失败时打印并计数，不中断，main 最后返回 check_result()
+inline int failures = 0;
+
+inline void check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+// 打印汇总，返回进程退出码
+inline int check_result()
+{
+    if (failures)
+    {
+        std::cout << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "../DecodeBudget.hpp"
+#include "check.hpp"
+
+#include <iostream>
+
+// 解码预算调度的策略检查（不依赖 GStreamer）：
+//   1. 可见性与格子面积决定档位上限
+//   2. 超出预算时从最小的格子开始降级，估计占用回到预算以内，可见流不会被暂停
+//   3. 放大的流立即恢复全帧率
+//   4. 负载下降后逐级恢复，预算边缘不来回切换
+
+// 模拟测得的占用：每路全帧率解码 cost 个核
+static double simulated_cores(const DecodeBudget &budget, double cost)
+{
+    double cores = 0.0;
+    for (int i = 0; i < budget.size(); ++i)
+        cores += decode_tier_weight(budget.tier(i)) * cost;
+    return cores;
+}
+
+static void check_ceilings()
+{
+    DecodeBudget budget;
+    DecodeBudgetOptions options;
+    budget.reset(4, options);
+    budget.set_tile(0, true, 640 * 360);
+    budget.set_tile(1, true, 240 * 135);
+    budget.set_tile(2, true, 120 * 68);
+    budget.set_tile(3, false, 640 * 360);
+    check(budget.tier(0) == DecodeTier::Full, "large tile decodes at full rate");
+    check(budget.tier(1) == DecodeTier::Reduced, "medium tile decodes at reduced rate");
+    check(budget.tier(2) == DecodeTier::KeyOnly, "small tile decodes keyframes only");
+    check(budget.tier(3) == DecodeTier::Paused, "hidden stream is paused");
+    // 没有预算时评估不改变档位
+    check(!budget.evaluate(100.0) && budget.tier(0) == DecodeTier::Full, "no budget, no demotion");
+}
+
+static void check_budget()
+{
+    // 4x4 的 1080p 窗口：每格 480x270，都在全帧率上限内；每路全帧率 0.5 核，预算 3 核
+    const int streams = 16;
+    const double cost = 0.5;
+    DecodeBudgetOptions options;
+    options.core_budget = 3.0;
+    DecodeBudget budget;
+    budget.reset(streams, options);
+    for (int i = 0; i < streams; ++i)
+        budget.set_tile(i, true, 480 * 270 + i); // 面积略有差别，便于确定降级顺序
+
+    check(simulated_cores(budget, cost) == 8.0, "all streams start at full rate");
+    check(budget.evaluate(simulated_cores(budget, cost)), "over budget demotes");
+    double cores = simulated_cores(budget, cost);
+    check(cores <= options.core_budget, "one evaluation brings the estimate under budget");
+    for (int i = 0; i < streams; ++i)
+        check(budget.tier(i) != DecodeTier::Paused, "visible streams are never paused by the budget");
+    check((int)budget.tier(0) >= (int)budget.tier(streams - 1), "smallest tiles are demoted first");
+    check(budget.tier(streams - 1) == DecodeTier::Full, "largest tile keeps full rate");
+
+    // 稳定负载下不来回切换
+    DecodeBudgetStats before = budget.stats();
+    for (int i = 0; i < 10; ++i)
+        budget.evaluate(simulated_cores(budget, cost));
+    check(budget.stats().demotions == before.demotions, "no further demotions at a steady load");
+    check(simulated_cores(budget, cost) <= options.core_budget, "steady load stays under budget");
+
+    // 放大第 0 路（原本降级最多）到整个窗口：立即全帧率，其余隐藏
+    check(budget.tier(0) != DecodeTier::Full, "stream 0 was demoted");
+    check(budget.set_tile(0, true, 1920 * 1080), "enlarging promotes immediately");
+    check(budget.tier(0) == DecodeTier::Full, "enlarged stream is at full rate");
+    for (int i = 1; i < streams; ++i)
+        budget.set_tile(i, false, 0.0);
+    check(simulated_cores(budget, cost) == cost, "only the focused stream decodes");
+
+    // 回到网格：全部可见且去掉限制，超出预算后再次降级，放大的那一路最后才动
+    for (int i = 0; i < streams; ++i)
+        budget.set_tile(i, true, 480 * 270 + i);
+    budget.evaluate(simulated_cores(budget, cost));
+    check(simulated_cores(budget, cost) <= options.core_budget, "back under budget after leaving focus");
+
+    // 负载下降（例如画面变简单，每路开销减半）后逐级恢复
+    int promotions = 0;
+    for (int i = 0; i < 50; ++i)
+    {
+        uint64_t promoted = budget.stats().promotions;
+        budget.evaluate(simulated_cores(budget, cost * 0.25));
+        promotions += (int)(budget.stats().promotions - promoted);
+        check(budget.stats().promotions - promoted <= 1, "at most one promotion per evaluation");
+    }
+    check(promotions > 0, "streams are promoted when load drops");
+    check(simulated_cores(budget, cost * 0.25) <= options.core_budget * options.headroom + 1e-9, "promotion respects headroom");
+}
+
+int main()
+{
+    check_ceilings();
+    check_budget();
+
+    return check_result();
+}
@@ -0,0 +1,101 @@
+#include "../FrameScheduler.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <iostream>
+
+// 呈现调度器的离线检查（模拟时钟，不依赖 GStreamer/GL）：
+//   1. 由带抖动的交换间隔估计刷新周期，并跳过漏掉 vblank 的间隔
+//   2. 每帧落在离到期时间最近的 vblank 上；24fps 内容在 60Hz 上呈现 3:2 节奏
+//   3. 迟到丢帧策略与连续丢帧上限
+
+typedef FrameScheduler::Clock Clock;
+
+static Clock::time_point at_us(double us)
+{
+    return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(us)));
+}
+
+static void check_period_estimate()
+{
+    // 标称 60Hz，实际 59.94Hz，交换时间有 ±200us 抖动，偶尔漏掉一次 vblank
+    FrameScheduler scheduler(1e6 / 60.0);
+    const double period = 1e6 / 59.94;
+    double t = 0.0;
+    for (int i = 0; i < 600; ++i)
+    {
+        t += (i % 50 == 49) ? 2.0 * period : period;
+        scheduler.on_swap_complete(at_us(t + ((i % 3) - 1) * 200.0));
+    }
+    check(std::fabs(scheduler.refresh_period_us() - period) < 20.0, "period converges to 59.94Hz");
+
+    // 窗口拖动造成的长停顿不影响估计
+    scheduler.on_swap_complete(at_us(t + 250000.0));
+    check(std::fabs(scheduler.refresh_period_us() - period) < 20.0, "long stall is ignored");
+}
+
+static void check_cadence()
+{
+    // 24fps 内容在 60Hz 上：相邻两帧交替保持 2、3 个 vblank
+    const double period = 1e6 / 60.0, frame = 1e6 / 24.0;
+    FrameScheduler scheduler(period);
+    scheduler.on_swap_complete(at_us(0.0));
+
+    double now = 0.0;
+    int frame_index = 0, held = 0, pattern_errors = 0;
+    int expected[] = {3, 2};
+    for (int vblank = 1; vblank <= 120; ++vblank)
+    {
+        double due = frame_index * frame + 15000.0;
+        FrameScheduler::Decision decision = scheduler.decide(at_us(due), at_us(now));
+        held++;
+        if (decision == FrameScheduler::Decision::Present)
+        {
+            if (frame_index > 1 && held != expected[frame_index % 2])
+                pattern_errors++;
+            scheduler.record_present(at_us(due), at_us(vblank * period));
+            frame_index++;
+            held = 0;
+        }
+        now = vblank * period;
+        scheduler.on_swap_complete(at_us(now));
+    }
+    const ScheduleStats &stats = scheduler.stats();
+    check(pattern_errors == 0, "3:2 cadence");
+    check(stats.presented >= 47 && stats.presented <= 49, "24 frames per 60 vblanks");
+    check(stats.judder_max_us <= period * 0.5 + 1.0, "judder within half a period");
+    check(stats.dropped_late == 0, "nothing dropped without a drop policy");
+}
+
+static void check_late_drop()
+{
+    const double period = 1e6 / 60.0;
+    FrameScheduler scheduler(period, 5000.0);
+    scheduler.on_swap_complete(at_us(0.0));
+
+    // 迟到 2ms 的帧照常显示，迟到 20ms 的帧被丢弃
+    check(scheduler.decide(at_us(period - 2000.0), at_us(1000.0)) == FrameScheduler::Decision::Present, "slightly late frame is shown");
+    check(scheduler.decide(at_us(period - 20000.0), at_us(1000.0)) == FrameScheduler::Decision::Drop, "late frame is dropped");
+
+    // 持续过载时连续丢帧有上限
+    int drops = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        if (scheduler.decide(at_us(-1e6), at_us(1000.0)) == FrameScheduler::Decision::Drop)
+            drops++;
+        else
+            break;
+    }
+    check(drops == 3, "consecutive drops are capped");
+    check(scheduler.stats().dropped_late == 4, "drops are counted");
+}
+
+int main()
+{
+    std::cout << "=== Frame scheduler ===" << std::endl;
+    check_period_estimate();
+    check_cadence();
+    check_late_drop();
+
+    return check_result();
+}
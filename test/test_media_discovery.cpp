@@ -0,0 +1,196 @@
+#include "gst/gst.h"
+#include "gst/app/gstappsink.h"
+#include "../DecoderSelection.hpp"
+#include "../MediaDiscovery.hpp"
+#include "check.hpp"
+
+#include <glib/gstdio.h>
+
+#include <iostream>
+#include <string>
+
+// 自动选择分离器/解码器与探测缓存：
+//   1. rank 规格解析（数字、名称、+N/-N 与错误输入）
+//   2. 第一次查询探测并写缓存，新实例再查询命中缓存且结果相同；文件改写后重新探测
+//   3. 按容器 caps 选择分离器（AVI -> avidemux），未知 caps 没有分离器
+//   4. 按探测结果构建的管道和没有探测结果时的 decodebin3 管道都能预卷
+//   5. 显式 rank 写入注册表
+// 缺少 jpegenc / avimux / avidemux / jpegdec 时跳过 2-4
+
+static bool record(const std::string &path, int frames)
+{
+    std::string launch = "videotestsrc num-buffers=" + std::to_string(frames) +
+                         " ! video/x-raw,width=320,height=180,framerate=25/1 ! jpegenc ! avimux ! filesink location=\"" +
+                         path + "\"";
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch(launch.c_str(), &error);
+    if (error)
+    {
+        std::cout << "Failed to create recorder: " << error->message << std::endl;
+        g_error_free(error);
+        return false;
+    }
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    GstBus *bus = gst_element_get_bus(pipeline);
+    GstMessage *msg = gst_bus_timed_pop_filtered(bus, 10 * GST_SECOND, (GstMessageType)(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    bool ok = msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+    if (msg)
+        gst_message_unref(msg);
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+    return ok;
+}
+
+static void check_rank_parsing()
+{
+    DecoderRankPolicy policy;
+    check(parse_decoder_ranks("avdec_h264:primary+1,vp8dec:0,jpegdec:marginal-4", policy), "rank spec parses");
+    check(policy.ranks.size() == 3, "three ranks");
+    if (policy.ranks.size() == 3)
+    {
+        check(policy.ranks[0].first == "avdec_h264" && policy.ranks[0].second == GST_RANK_PRIMARY + 1, "named rank with offset");
+        check(policy.ranks[1].second == 0, "numeric rank");
+        check(policy.ranks[2].second == GST_RANK_MARGINAL - 4, "negative offset");
+    }
+    DecoderRankPolicy invalid;
+    check(!parse_decoder_ranks("avdec_h264", invalid), "missing rank rejected");
+    check(!parse_decoder_ranks("avdec_h264:best", invalid), "unknown rank name rejected");
+    check(!parse_decoder_ranks(":primary", invalid), "missing factory rejected");
+}
+
+static bool preroll_profile(const SourceProfile &base, const std::string &path)
+{
+    // 自定义滤镜不在测试环境中
+    SourceProfile profile = base;
+    profile.filters.clear();
+    PipelineBuilder builder("auto");
+    builder.add_profile(profile, path);
+    builder.add(ElementSpec{"appsink", "sink", {{"sync", "false"}}});
+    std::cout << profile.name << ": " << builder.description() << std::endl;
+    PipelineTiming timing;
+    GstElement *pipeline = builder.finish(timing);
+    if (!pipeline)
+    {
+        std::cout << "Failed to build: " << builder.error() << std::endl;
+        return false;
+    }
+    bool ok = PipelineBuilder::preroll(pipeline, 5 * GST_SECOND, timing) == GST_STATE_CHANGE_SUCCESS;
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    GstSample *sample = sink ? gst_app_sink_try_pull_preroll(GST_APP_SINK(sink), GST_SECOND) : nullptr;
+    ok = ok && sample != nullptr;
+    if (sample)
+        gst_sample_unref(sample);
+    if (sink)
+        gst_object_unref(sink);
+    std::cout << "  preroll " << timing.preroll_ms << " ms" << std::endl;
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+    return ok;
+}
+
+static void check_discovery(const std::string &media_path, const std::string &cache_path)
+{
+    MediaInfo probed;
+    {
+        MediaDiscoveryCache cache(cache_path);
+        check(cache.lookup(media_path, probed), "recording discovered");
+        check(!cache.stats().cached, "first lookup probes");
+        std::cout << "probe: " << cache.stats().elapsed_ms << " ms, " << probed.container_caps << std::endl;
+    }
+    check(probed.has_video && !probed.has_audio, "video only");
+    check(probed.width == 320 && probed.height == 180, "video size");
+    check(probed.fps_n == 25 && probed.fps_d == 1, "frame rate");
+    check(probed.container_caps.find("video/x-msvideo") == 0, "AVI container");
+    check(GST_CLOCK_TIME_IS_VALID(probed.duration) && probed.duration > 0, "duration");
+
+    MediaInfo cached;
+    {
+        // 新实例从缓存文件读取
+        MediaDiscoveryCache cache(cache_path);
+        check(cache.lookup(media_path, cached), "cached lookup");
+        check(cache.stats().cached, "second lookup hits the cache");
+        std::cout << "cached: " << cache.stats().elapsed_ms << " ms" << std::endl;
+    }
+    check(cached.container_caps == probed.container_caps && cached.video_caps == probed.video_caps &&
+              cached.width == probed.width && cached.height == probed.height && cached.fps_n == probed.fps_n &&
+              cached.has_audio == probed.has_audio && cached.duration == probed.duration,
+          "cached info matches the probe");
+
+    // 文件改写（大小变化）后缓存失效
+    check(record(media_path, 20), "rewrite recording");
+    MediaInfo rewritten;
+    MediaDiscoveryCache cache(cache_path);
+    check(cache.lookup(media_path, rewritten), "rewritten file discovered");
+    check(!cache.stats().cached, "changed file is probed again");
+    check(rewritten.duration > probed.duration, "new duration");
+
+    MediaInfo missing;
+    check(!cache.lookup(media_path + ".missing", missing), "missing file fails");
+}
+
+static void check_selection(const std::string &media_path, const std::string &cache_path)
+{
+    check(select_demuxer("video/x-msvideo").factory == "avidemux", "AVI demuxer selected");
+    check(select_demuxer("application/x-no-such-container").factory.empty(), "unknown container has no demuxer");
+    check(select_demuxer("").factory.empty(), "empty caps have no demuxer");
+
+    MediaDiscoveryCache cache(cache_path);
+    MediaInfo media;
+    check(cache.lookup(media_path, media), "lookup for profile");
+    SourceProfile profile = auto_file_profile(&media);
+    check(profile.demuxer.factory == "avidemux" && profile.audio_chain.empty(), "profile uses the discovered demuxer");
+    check(preroll_profile(profile, media_path), "discovered profile prerolls");
+
+    SourceProfile fallback = auto_file_profile(nullptr);
+    check(fallback.demuxer.factory == "decodebin3" || fallback.demuxer.factory == "decodebin", "fallback auto-plugs");
+    check(preroll_profile(fallback, media_path), "auto-plugged profile prerolls");
+}
+
+static void check_apply_ranks()
+{
+    DecoderRankPolicy policy;
+    policy.ranks = {{"videotestsrc", GST_RANK_PRIMARY + 7}, {"no_such_decoder", GST_RANK_PRIMARY}};
+    check(apply_decoder_ranks(policy) == 1, "missing factories are skipped");
+    GstElementFactory *factory = ElementFactoryCache::instance().find("videotestsrc");
+    check(factory && gst_plugin_feature_get_rank(GST_PLUGIN_FEATURE(factory)) == GST_RANK_PRIMARY + 7, "rank applied");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+    std::cout << "=== Media discovery and decoder selection ===" << std::endl;
+    check_rank_parsing();
+
+    const char *required[] = {"jpegenc", "avimux", "avidemux", "jpegdec"};
+    bool available = true;
+    for (const char *name : required)
+    {
+        if (!ElementFactoryCache::instance().find(name))
+        {
+            std::cout << "Missing " << name << ", skipping discovery checks" << std::endl;
+            available = false;
+            break;
+        }
+    }
+    if (available)
+    {
+        gchar *media = g_build_filename(g_get_tmp_dir(), "media_discovery.avi", nullptr);
+        gchar *cache = g_build_filename(g_get_tmp_dir(), "media_discovery_cache", "discovery.ini", nullptr);
+        g_remove(cache);
+        if (record(media, 10))
+        {
+            check_discovery(media, cache);
+            check_selection(media, cache);
+        }
+        else
+            check(false, "record test media");
+        g_remove(media);
+        g_remove(cache);
+        g_free(media);
+        g_free(cache);
+    }
+    check_apply_ranks();
+
+    return check_result();
+}
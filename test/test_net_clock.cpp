@@ -0,0 +1,215 @@
+#include "gst/gst.h"
+#include "gst/app/gstappsink.h"
+#include "gio/gio.h"
+#include "../NetClockSync.hpp"
+#include "../StreamSync.hpp"
+#include "../VideoScaler.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 多进程网络时钟同步（回环）：
+//   1. 本进程作为主节点发布时钟并选定 base time，启动 4 个节点子进程，每个节点的管道跟随网络时钟、
+//      appsink 按时钟同步；节点报告时钟偏移、呈现误差和第 kMark 帧的显示时刻（共同时钟）
+//   2. 各节点第 kMark 帧的显示时刻之差（呈现偏差）远小于一帧
+//   3. 2x2 节点各显示四分之一：crop_viewport 放大后的整幅画面在各节点上尺寸相同、边界相接
+// 用法: test_net_clock
+//       test_net_clock --node 序号 端口 base_time   （内部使用：节点进程）
+
+static const int kNodes = 4;
+static const int kFrames = 90;
+static const int kFps = 30;
+static const int kMark = 60;
+
+// 节点：跟随网络时钟播放，标准输出一行结果
+static int run_node(int index, int port, GstClockTime base_time)
+{
+    NetClockSync clock;
+    if (!clock.follow("127.0.0.1", port, base_time))
+        return 1;
+
+    std::string launch = "videotestsrc num-buffers=" + std::to_string(kFrames) + " pattern=" + std::to_string(index) +
+                         " ! video/x-raw,width=160,height=90,framerate=" + std::to_string(kFps) + "/1"
+                         " ! appsink name=sink sync=true";
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch(launch.c_str(), &error);
+    if (error)
+    {
+        std::cerr << "Failed to create node pipeline: " << error->message << std::endl;
+        g_error_free(error);
+        return 1;
+    }
+    GstElement *appsink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    clock.apply(pipeline);
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    // appsink 同步到时钟后才交出 sample，取出时刻即为呈现时刻
+    GstClockTime mark = GST_CLOCK_TIME_NONE;
+    for (int frame = 0; frame < kFrames; ++frame)
+    {
+        GstSample *sample = gst_app_sink_pull_sample(GST_APP_SINK(appsink));
+        if (!sample)
+            break;
+        clock.record_present(sample_running_time(sample));
+        if (frame == kMark)
+            mark = gst_clock_get_time(clock.clock());
+        gst_sample_unref(sample);
+    }
+
+    const PresentErrorStats &present = clock.present_errors();
+    std::cout << "node " << index << " offset " << clock.offset_ms() << " error_avg "
+              << (present.frames ? present.sum_ms / present.frames : 0.0) << " error_max " << present.max_ms
+              << " frames " << present.frames << " mark " << mark << std::endl;
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(appsink);
+    gst_object_unref(pipeline);
+    return 0;
+}
+
+struct NodeReport
+{
+    bool ok = false;
+    double offset_ms = 0.0;
+    double error_avg_ms = 0.0;
+    double error_max_ms = 0.0;
+    unsigned long long frames = 0;
+    unsigned long long mark = 0;
+};
+
+static void check_crops()
+{
+    // 1920x1080 的画面分给 2x2 个 960x540 的节点
+    const int window_width = 960, window_height = 540;
+    int full_width = -1, full_height = -1;
+    for (int row = 0; row < 2; ++row)
+    {
+        for (int col = 0; col < 2; ++col)
+        {
+            CropRect crop;
+            crop.x = col * 0.5f;
+            crop.y = row * 0.5f;
+            crop.width = 0.5f;
+            crop.height = 0.5f;
+            ScaleViewport view = letterbox_viewport(window_width, window_height, 1920.0 * crop.width, 1080.0 * crop.height);
+            check(view.x == 0 && view.y == 0 && view.width == window_width && view.height == window_height, "quarter fills the node window");
+            ScaleViewport full = crop_viewport(view, crop);
+            if (full_width < 0)
+            {
+                full_width = full.width;
+                full_height = full.height;
+            }
+            check(full.width == full_width && full.height == full_height, "every node scales the picture the same way");
+            // 视口原点在左下：右侧节点左移一个窗口宽，上方节点下移一个窗口高
+            check(full.x == -col * window_width && full.y == -(1 - row) * window_height, "crop lands on the node window");
+        }
+    }
+    check(full_width == 2 * window_width && full_height == 2 * window_height, "whole picture spans all nodes");
+
+    // 三列：各节点整幅画面的左边界依次相差一个窗口宽，没有缝隙或重叠
+    for (int col = 0; col < 3; ++col)
+    {
+        CropRect crop;
+        crop.x = col / 3.0f;
+        crop.width = 1.0f / 3.0f;
+        ScaleViewport view;
+        view.width = 1280;
+        view.height = 720;
+        ScaleViewport full = crop_viewport(view, crop);
+        check(std::abs(full.x + col * 1280) <= 1 && std::abs(full.width - 3840) <= 1, "three column split has no seams");
+    }
+
+    CropRect invalid;
+    invalid.x = 0.75f;
+    invalid.width = 0.5f;
+    check(!crop_is_valid(invalid), "crop outside the picture is rejected");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+    if (argc == 5 && strcmp(argv[1], "--node") == 0)
+        return run_node(std::atoi(argv[2]), std::atoi(argv[3]), (GstClockTime)std::strtoull(argv[4], nullptr, 10));
+
+    check_crops();
+
+    // 主节点：发布时钟，留 2 秒启动节点并完成同步
+    NetClockSync master;
+    if (!master.serve(0, 2 * GST_SECOND))
+    {
+        std::cout << "Failed to publish network clock" << std::endl;
+        return 1;
+    }
+    std::cout << "=== Network clock on 127.0.0.1:" << master.port() << ", " << kNodes << " node processes ===" << std::endl;
+
+    std::string port = std::to_string(master.port());
+    std::string base = std::to_string(master.base_time());
+    std::vector<GSubprocess *> nodes;
+    for (int i = 0; i < kNodes; ++i)
+    {
+        std::string index = std::to_string(i);
+        const gchar *node_argv[] = {argv[0], "--node", index.c_str(), port.c_str(), base.c_str(), nullptr};
+        GError *error = nullptr;
+        GSubprocess *node = g_subprocess_newv(node_argv, G_SUBPROCESS_FLAGS_STDOUT_PIPE, &error);
+        if (!node)
+        {
+            std::cout << "Failed to start node: " << error->message << std::endl;
+            g_error_free(error);
+            return 1;
+        }
+        nodes.push_back(node);
+    }
+
+    std::vector<NodeReport> reports(kNodes);
+    for (int i = 0; i < kNodes; ++i)
+    {
+        gchar *out = nullptr;
+        GError *error = nullptr;
+        if (g_subprocess_communicate_utf8(nodes[i], nullptr, nullptr, &out, nullptr, &error) && out)
+        {
+            int index = -1;
+            NodeReport &report = reports[i];
+            report.ok = sscanf(out, "node %d offset %lf error_avg %lf error_max %lf frames %llu mark %llu", &index,
+                               &report.offset_ms, &report.error_avg_ms, &report.error_max_ms, &report.frames, &report.mark) == 6 &&
+                        index == i && g_subprocess_get_if_exited(nodes[i]) && g_subprocess_get_exit_status(nodes[i]) == 0;
+        }
+        if (error)
+            g_error_free(error);
+        g_free(out);
+        g_object_unref(nodes[i]);
+    }
+
+    unsigned long long earliest = 0, latest = 0;
+    for (int i = 0; i < kNodes; ++i)
+    {
+        const NodeReport &report = reports[i];
+        check(report.ok, "node reported");
+        if (!report.ok)
+            continue;
+        std::cout << "node " << i << std::fixed << std::setprecision(3) << ": offset " << std::setw(7) << report.offset_ms
+                  << " ms, presentation error avg " << std::setw(7) << report.error_avg_ms << " ms, max "
+                  << std::setw(7) << report.error_max_ms << " ms over " << report.frames << " frames" << std::endl;
+        // 同一台机器上主从的内部时钟相同，偏移只来自测量误差
+        check(std::fabs(report.offset_ms) < 5.0, "loopback clock offset is small");
+        check(std::fabs(report.error_max_ms) < 20.0, "frames are presented on the shared clock");
+        check(report.frames == (unsigned long long)kFrames, "node played every frame");
+        if (!earliest || report.mark < earliest)
+            earliest = report.mark;
+        if (report.mark > latest)
+            latest = report.mark;
+    }
+    double skew_ms = (double)(latest - earliest) / GST_MSECOND;
+    std::cout << "presentation skew of frame " << kMark << " across nodes: " << skew_ms << " ms (frame "
+              << 1000.0 / kFps << " ms)" << std::endl;
+    check(skew_ms < 5.0, "nodes present the same frame together");
+
+    master.stop();
+    return check_result();
+}
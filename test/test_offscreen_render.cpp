@@ -0,0 +1,150 @@
+#include "glad/glad.h"
+#include "../OffscreenContext.hpp"
+#include "../gl_utils.hpp"
+#include "check.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// 无窗口渲染检查：在 EGL 离屏上下文中把每种着色器变体画进 FBO 再读回。
+// 颜色矩阵取单位矩阵，输出应等于采样到的 (Y, U, V)，用来确认各平面的采样方式。
+// 没有 EGL 或没有可用驱动时跳过（返回 0）。
+
+static GLuint make_texture(GLenum internal_format, GLenum format, int width, int height, const std::vector<uint8_t> &pixels)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return texture;
+}
+
+// 用 shader 画满 FBO，返回中心像素
+static void draw(VideoShader variant, const GLuint textures[], int count, int frame_width, uint8_t out[4])
+{
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    GLuint program = create_video_shader_program(variant);
+    check(program != 0, "shader compiles");
+    if (!program)
+        return;
+
+    for (int i = 0; i < count; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "colorMatrix"), 1, GL_TRUE, identity);
+    glUniform1i(glGetUniformLocation(program, "frameWidth"), frame_width);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glReadPixels(32, 32, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, out);
+    glUseProgram(0);
+    glDeleteProgram(program);
+}
+
+static bool near(const uint8_t pixel[4], int r, int g, int b)
+{
+    return std::abs(pixel[0] - r) <= 1 && std::abs(pixel[1] - g) <= 1 && std::abs(pixel[2] - b) <= 1;
+}
+
+int main()
+{
+    OffscreenContext context;
+    if (!context.create() || !context.make_current() || !gladLoadGLLoader((GLADloadproc)OffscreenContext::get_proc_address))
+    {
+        std::cout << "No offscreen GL context, skipped" << std::endl;
+        return 0;
+    }
+    load_gl_extensions((GLADloadproc)OffscreenContext::get_proc_address);
+    std::cout << "=== Offscreen render, " << context.kind() << ", " << glGetString(GL_RENDERER) << " ===" << std::endl;
+
+    // 64x64 的 FBO
+    const int size = 64;
+    GLuint target = 0, fbo = 0;
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    check(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "framebuffer complete");
+    glViewport(0, 0, size, size);
+
+    // 全屏四边形：位置 + 纹理坐标
+    static const float quad[16] = {-1, -1, 0, 0, 1, -1, 1, 0, 1, 1, 1, 1, -1, 1, 0, 1};
+    static const unsigned int quad_indices[6] = {0, 1, 2, 0, 2, 3};
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quad_indices), quad_indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    const int w = 16, h = 16;
+    const uint8_t y = 200, u = 60, v = 120;
+    uint8_t pixel[4] = {};
+
+    GLuint rgba = make_texture(GL_RGBA8, GL_RGBA, w, h, std::vector<uint8_t>((size_t)w * h * 4, 0));
+    {
+        std::vector<uint8_t> pixels((size_t)w * h * 4);
+        for (size_t i = 0; i < pixels.size(); i += 4)
+        {
+            pixels[i] = y;
+            pixels[i + 1] = u;
+            pixels[i + 2] = v;
+            pixels[i + 3] = 255;
+        }
+        glBindTexture(GL_TEXTURE_2D, rgba);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        draw(VideoShader::Rgba, &rgba, 1, w, pixel);
+        check(near(pixel, y, u, v), "RGBA");
+    }
+
+    GLuint i420[3] = {
+        make_texture(GL_R8, GL_RED, w, h, std::vector<uint8_t>((size_t)w * h, y)),
+        make_texture(GL_R8, GL_RED, w / 2, h / 2, std::vector<uint8_t>((size_t)w * h / 4, u)),
+        make_texture(GL_R8, GL_RED, w / 2, h / 2, std::vector<uint8_t>((size_t)w * h / 4, v))};
+    draw(VideoShader::I420, i420, 3, w, pixel);
+    check(near(pixel, y, u, v), "I420");
+
+    std::vector<uint8_t> uv((size_t)w * h / 2);
+    for (size_t i = 0; i < uv.size(); i += 2)
+    {
+        uv[i] = u;
+        uv[i + 1] = v;
+    }
+    GLuint nv12[2] = {i420[0], make_texture(GL_RG8, GL_RG, w / 2, h / 2, uv)};
+    draw(VideoShader::Nv12, nv12, 2, w, pixel);
+    check(near(pixel, y, u, v), "NV12");
+
+    std::vector<uint8_t> yuy2((size_t)w / 2 * h * 4);
+    for (size_t i = 0; i < yuy2.size(); i += 4)
+    {
+        yuy2[i] = y;
+        yuy2[i + 1] = u;
+        yuy2[i + 2] = y;
+        yuy2[i + 3] = v;
+    }
+    GLuint packed = make_texture(GL_RGBA8, GL_RGBA, w / 2, h, yuy2);
+    draw(VideoShader::Yuy2, &packed, 1, w, pixel);
+    check(near(pixel, y, u, v), "YUY2");
+
+    check(glGetError() == GL_NO_ERROR, "no GL errors");
+
+    return check_result();
+}
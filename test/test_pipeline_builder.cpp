@@ -0,0 +1,148 @@
+#include "gst/gst.h"
+#include "gst/video/video.h"
+#include "gst/app/gstappsink.h"
+#include "../PipelineBuilder.hpp"
+#include "check.hpp"
+
+#include <iostream>
+#include <string>
+
+// 管道构建器：
+//   1. 源类型识别与每种源的配置
+//   2. 测试源按配置构建、预卷，appsink 收到配置中的 caps；构建与预卷耗时被记录
+//   3. 工厂只查找一次，第二次构建不再查询注册表；缺少的元素和属性报告为错误
+//   4. 带 gst-launch 特殊字符的路径原样作为属性值
+//   5. decodebin 的动态 pad 在 pad-added 时链接（缺少 jpegenc 时跳过）
+
+static void check_source_kinds()
+{
+    check(source_kind("") == SourceKind::Test && source_kind("test") == SourceKind::Test, "test source");
+    check(source_kind("rtsp://camera/stream") == SourceKind::Rtsp, "rtsp source");
+    check(source_kind("https://example.com/a.webm") == SourceKind::Http, "http source");
+    check(source_kind("./test.webm") == SourceKind::File, "file source");
+    check(source_kind("test:ball") == SourceKind::Test && source_kind("test.webm") == SourceKind::File, "test pattern source");
+    check(source_profile(SourceKind::Rtsp).queue_buffers > 0, "rtsp profile limits queueing");
+    check(source_profile(SourceKind::File).demuxer.factory == "decodebin3", "file profile auto-plugs");
+}
+
+static GstElement *build_test_pipeline(PipelineTiming &timing)
+{
+    PipelineBuilder builder("test");
+    builder.add_profile(source_profile(SourceKind::Test), "");
+    builder.add(ElementSpec{"appsink", "sink", {{"sync", "false"}}});
+    std::cout << "Test pipeline: " << builder.description() << std::endl;
+    return builder.finish(timing);
+}
+
+static void check_test_profile()
+{
+    PipelineTiming timing;
+    GstElement *pipeline = build_test_pipeline(timing);
+    check(pipeline != nullptr, "test pipeline builds");
+    if (!pipeline)
+        return;
+    check(timing.elements == 4, "source, caps, queue and sink");
+
+    GstStateChangeReturn ret = PipelineBuilder::preroll(pipeline, 5 * GST_SECOND, timing);
+    check(ret == GST_STATE_CHANGE_SUCCESS && timing.preroll_ms >= 0.0, "test pipeline prerolls");
+    std::cout << "build " << timing.build_ms << " ms, preroll " << timing.preroll_ms << " ms" << std::endl;
+
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    GstSample *sample = sink ? gst_app_sink_try_pull_preroll(GST_APP_SINK(sink), GST_SECOND) : nullptr;
+    check(sample != nullptr, "preroll sample");
+    if (sample)
+    {
+        GstVideoInfo info;
+        check(gst_video_info_from_caps(&info, gst_sample_get_caps(sample)) && GST_VIDEO_INFO_WIDTH(&info) == 640 &&
+                  GST_VIDEO_INFO_HEIGHT(&info) == 480,
+              "profile caps reach the sink");
+        gst_sample_unref(sample);
+    }
+    if (sink)
+        gst_object_unref(sink);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    // 第二次构建全部命中工厂缓存
+    uint64_t misses = ElementFactoryCache::instance().misses();
+    pipeline = build_test_pipeline(timing);
+    check(pipeline && ElementFactoryCache::instance().misses() == misses, "factories are looked up once");
+    if (pipeline)
+        gst_object_unref(pipeline);
+}
+
+static void check_errors()
+{
+    PipelineTiming timing;
+    PipelineBuilder missing;
+    missing.add("videotestsrc");
+    check(!missing.add("no-such-element") && !missing.ok(), "missing element is an error");
+    check(!missing.add("fakesink"), "builder stops after the first error");
+    check(missing.finish(timing) == nullptr, "failed builder returns no pipeline");
+    std::cout << "error: " << missing.error() << std::endl;
+
+    PipelineBuilder property;
+    check(!property.add(ElementSpec{"videotestsrc", "", {{"no-such-property", "1"}}}), "unknown property is an error");
+
+    // 路径中的引号、空格和 "!" 不会被当成管道语法
+    const std::string path = "/tmp/a \"b\" ! c.webm";
+    SourceProfile profile;
+    profile.source = {"filesrc", "src"};
+    profile.location_property = "location";
+    profile.convert = false;
+    PipelineBuilder file;
+    file.add_profile(profile, path);
+    file.add("fakesink");
+    GstElement *pipeline = file.finish(timing);
+    check(pipeline != nullptr, "file pipeline builds");
+    if (pipeline)
+    {
+        GstElement *source = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+        gchar *location = nullptr;
+        if (source)
+        {
+            g_object_get(source, "location", &location, nullptr);
+            gst_object_unref(source);
+        }
+        check(location && path == location, "location is passed verbatim");
+        g_free(location);
+        gst_object_unref(pipeline);
+    }
+}
+
+static void check_dynamic_pads()
+{
+    if (!ElementFactoryCache::instance().find("jpegenc") || !ElementFactoryCache::instance().find("jpegdec"))
+    {
+        std::cout << "jpegenc/jpegdec not available, skipping dynamic pad check" << std::endl;
+        return;
+    }
+    PipelineTiming timing;
+    PipelineBuilder builder;
+    builder.add(ElementSpec{"videotestsrc", "", {{"num-buffers", "10"}}});
+    builder.add_caps("video/x-raw,width=320,height=240");
+    builder.add("jpegenc");
+    builder.add("decodebin");
+    builder.add("videoconvert");
+    builder.add(ElementSpec{"appsink", "sink", {{"sync", "false"}}});
+    GstElement *pipeline = builder.finish(timing);
+    check(pipeline != nullptr, "decodebin pipeline builds");
+    if (!pipeline)
+        return;
+    GstStateChangeReturn ret = PipelineBuilder::preroll(pipeline, 5 * GST_SECOND, timing);
+    check(ret == GST_STATE_CHANGE_SUCCESS, "decodebin pad linked on pad-added");
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+    std::cout << "=== Pipeline builder ===" << std::endl;
+    check_source_kinds();
+    check_test_profile();
+    check_errors();
+    check_dynamic_pads();
+
+    return check_result();
+}
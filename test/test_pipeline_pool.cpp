@@ -0,0 +1,161 @@
+#include "gst/gst.h"
+#include "gst/app/gstappsink.h"
+#include "../PipelinePool.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// 预热管道池：
+//   1. 放入的管道在池中预卷，取出时已预卷完成，置为 PLAYING 后第一帧就是预卷的那一帧
+//   2. 预热管道到第一帧的时间与重新构建的对比（只打印）
+//   3. 停到 READY 的管道放回池中从头重新预卷（切回旧源）
+//   4. 容量满时淘汰最早放入的，同一源替换，容量为 0 时不保留
+//   5. 预卷失败的管道不进池
+//   6. 池中积压了 ERROR 的管道取出时被释放（由调用者重建），放回池中时清掉上一次播放的消息
+
+static GstElement *build(int pattern, PipelineTiming &timing)
+{
+    PipelineBuilder builder("pool");
+    builder.add(ElementSpec{"videotestsrc", "", {{"pattern", std::to_string(pattern)}}});
+    builder.add_caps("video/x-raw,format=RGBA,width=320,height=240,framerate=30/1");
+    builder.add(ElementSpec{"appsink", "sink", {{"sync", "false"}, {"max-buffers", "1"}}});
+    return builder.finish(timing);
+}
+
+static std::string source_name(int pattern)
+{
+    return "pattern-" + std::to_string(pattern);
+}
+
+// 置为 PLAYING 到 appsink 收到第一帧的时间，first_pts 为这一帧的 PTS
+static double time_to_first_sample(GstElement *pipeline, GstClockTime &first_pts)
+{
+    auto start = std::chrono::steady_clock::now();
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    GstSample *sample = gst_app_sink_try_pull_sample(GST_APP_SINK(sink), 5 * GST_SECOND);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    first_pts = GST_CLOCK_TIME_NONE;
+    if (sample)
+    {
+        first_pts = GST_BUFFER_PTS(gst_sample_get_buffer(sample));
+        gst_sample_unref(sample);
+    }
+    gst_object_unref(sink);
+    return sample ? ms : -1.0;
+}
+
+static void check_warm_switch()
+{
+    PipelinePool pool(2);
+    PipelineTiming timing;
+    pool.put(source_name(0), build(0, timing), timing);
+    pool.put(source_name(1), build(1, timing), timing);
+    check(pool.size() == 2 && pool.contains(source_name(0)) && pool.contains(source_name(1)), "two pipelines warm");
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    bool prerolled = false;
+    PipelineTiming taken;
+    GstElement *warm = pool.take(source_name(1), 2 * GST_SECOND, taken, prerolled);
+    check(warm != nullptr && prerolled, "taken pipeline is prerolled");
+    check(!pool.contains(source_name(1)) && pool.size() == 1, "taken pipeline leaves the pool");
+    check(pool.take("pattern-unknown", GST_SECOND, taken, prerolled) == nullptr, "unknown source is not pooled");
+    if (!warm)
+        return;
+    GstClockTime first_pts;
+    double warm_ms = time_to_first_sample(warm, first_pts);
+    check(warm_ms >= 0.0, "warm pipeline delivers a frame");
+    check(first_pts == 0, "first frame is the prerolled frame");
+
+    PipelineTiming cold_timing;
+    auto cold_start = std::chrono::steady_clock::now();
+    GstElement *cold = build(2, cold_timing);
+    check(time_to_first_sample(cold, first_pts) >= 0.0, "cold pipeline delivers a frame");
+    double cold_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cold_start).count();
+    std::cout << "first frame: warm " << warm_ms << " ms, cold " << cold_ms << " ms (build " << cold_timing.build_ms << " ms)"
+              << std::endl;
+    gst_element_set_state(cold, GST_STATE_NULL);
+    gst_object_unref(cold);
+
+    // 切回：旧管道停到 READY 后放回池中，从头重新预卷
+    gst_element_set_state(warm, GST_STATE_READY);
+    pool.put(source_name(1), warm, taken);
+    warm = pool.take(source_name(1), 2 * GST_SECOND, taken, prerolled);
+    check(warm != nullptr, "recycled pipeline prerolls again");
+    if (warm)
+    {
+        check(time_to_first_sample(warm, first_pts) >= 0.0 && first_pts == 0, "recycled pipeline restarts");
+        gst_element_set_state(warm, GST_STATE_NULL);
+        gst_object_unref(warm);
+    }
+}
+
+static void check_capacity()
+{
+    PipelinePool pool(2);
+    PipelineTiming timing;
+    for (int i = 0; i < 3; ++i)
+        pool.put(source_name(i), build(i, timing), timing);
+    check(pool.size() == 2 && !pool.contains(source_name(0)), "oldest pipeline evicted");
+    pool.put(source_name(2), build(2, timing), timing);
+    check(pool.size() == 2 && pool.contains(source_name(1)), "same source replaced");
+    pool.set_capacity(1);
+    check(pool.size() == 1 && pool.contains(source_name(2)), "shrinking evicts");
+    pool.set_capacity(0);
+    pool.put(source_name(3), build(3, timing), timing);
+    check(pool.size() == 0, "zero capacity keeps nothing");
+}
+
+static void check_failure()
+{
+    PipelinePool pool(2);
+    PipelineTiming timing;
+    PipelineBuilder builder("missing");
+    builder.add(ElementSpec{"filesrc", "", {{"location", "/nonexistent/pipeline-pool.avi"}}});
+    builder.add("fakesink");
+    GstElement *pipeline = builder.finish(timing);
+    check(pipeline != nullptr, "missing-file pipeline builds");
+    if (pipeline)
+        pool.put("missing", pipeline, timing);
+    check(!pool.contains("missing"), "failed pre-roll is not pooled");
+}
+
+static void check_bus_messages()
+{
+    PipelinePool pool(2);
+    PipelineTiming timing;
+    GstElement *pipeline = build(0, timing);
+    GstBus *bus = gst_element_get_bus(pipeline);
+    gst_element_post_message(pipeline, gst_message_new_eos(GST_OBJECT(pipeline)));
+    pool.put(source_name(0), pipeline, timing);
+    bool prerolled = false;
+    pipeline = pool.take(source_name(0), 2 * GST_SECOND, timing, prerolled);
+    check(pipeline != nullptr, "pipeline with stale messages is taken");
+    check(!gst_bus_have_pending(bus), "taken pipeline has an empty bus");
+    gst_object_unref(bus);
+    if (!pipeline)
+        return;
+
+    // 预热期间出错：ERROR 积在总线上
+    pool.put(source_name(0), pipeline, timing);
+    GError *error = g_error_new_literal(GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ, "warm failure");
+    gst_element_post_message(pipeline, gst_message_new_error(GST_OBJECT(pipeline), error, nullptr));
+    g_error_free(error);
+    check(pool.take(source_name(0), 2 * GST_SECOND, timing, prerolled) == nullptr, "queued error forces a rebuild");
+    check(pool.size() == 0, "failed pipeline leaves the pool");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+    std::cout << "=== Pipeline pool ===" << std::endl;
+    check_warm_switch();
+    check_capacity();
+    check_failure();
+    check_bus_messages();
+
+    return check_result();
+}
@@ -0,0 +1,346 @@
+#include "../SharedFrameRing.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 共享内存帧环（只在 Linux 上构建）：
+//   1. memfd 的尺寸被封住，读端只读映射像素
+//   2. 读端子进程一边慢速读取一边检查内容：每帧完整（没有读到写了一半的槽位），序号递增，来不及读的帧被跳过
+//   3. 反压：读者持有全部可写槽位时写端等待，超时丢帧；读者释放后写端立即被唤醒
+//   4. 持有槽位的读端进程崩溃后，写端回收它的槽位
+//   4b. 没有持有槽位就退出的读端不会占满租约表（连接断开时写端回收，attach 找不到租约时读端回收）
+//   5. 写端被杀死：读端仍可读它持有的最后一帧，发现连接断开后重连到重启的写端继续接收
+
+static const size_t kFrameSize = 64 * 1024;
+
+static std::string socket_path(const char *name)
+{
+    return "/tmp/test_shared_frame_ring_" + std::to_string(getpid()) + "_" + name;
+}
+
+// 写一帧：每个字节都是 tag 与序号的组合，读端据此检查整帧一致
+static bool write_frame(SharedFrameRing &ring, uint8_t tag, int timeout_ms)
+{
+    uint8_t *data = ring.begin_write(kFrameSize, timeout_ms);
+    if (!data)
+        return false;
+    uint8_t value = (uint8_t)(ring.header()->published.load() + 1);
+    data[0] = tag;
+    memset(data + 1, value, kFrameSize - 1);
+    SharedFrameInfo info;
+    info.size = (uint32_t)kFrameSize;
+    info.n_planes = 1;
+    info.stride[0] = 256;
+    ring.commit_write(info, "video/x-raw,format=RGBA,width=64,height=256");
+    return true;
+}
+
+static bool frame_is_whole(const SharedFrameView &view)
+{
+    uint8_t value = (uint8_t)view.info->sequence;
+    for (size_t i = 1; i < kFrameSize; ++i)
+    {
+        if (view.data[i] != value)
+            return false;
+    }
+    return true;
+}
+
+static bool connect_retry(SharedFrameRing &ring, const std::string &path, int timeout_ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (ring.connect(path))
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+struct ReaderResult
+{
+    uint64_t acquired = 0;
+    uint64_t skipped = 0;
+    uint64_t torn = 0;
+    uint64_t out_of_order = 0;
+};
+
+// 子进程中的慢读者，结果写进管道
+static void slow_reader(const std::string &path, int result_fd)
+{
+    ReaderResult result;
+    SharedFrameRing ring;
+    if (connect_retry(ring, path, 2000))
+    {
+        uint64_t last = 0;
+        while (!ring.writer_gone())
+        {
+            if (!ring.wait_for_frame(50))
+                continue;
+            SharedFrameView view;
+            if (!ring.acquire_latest(view))
+                continue;
+            if (!frame_is_whole(view))
+                result.torn++;
+            if (view.info->sequence <= last)
+                result.out_of_order++;
+            last = view.info->sequence;
+            // 比写端慢：持有槽位期间写端继续写其他槽位
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+            if (!frame_is_whole(view))
+                result.torn++;
+            ring.release(view);
+        }
+        result.acquired = ring.reader_stats().acquired;
+        result.skipped = ring.reader_stats().skipped;
+    }
+    if (write(result_fd, &result, sizeof(result)) != (ssize_t)sizeof(result))
+        _exit(1);
+    _exit(0);
+}
+
+static void check_concurrent_readers()
+{
+    std::string path = socket_path("concurrent");
+    SharedFrameRing writer;
+    check(writer.create(kFrameSize, 4) && writer.listen(path), "create ring");
+
+    int seals = fcntl(writer.fd(), F_GET_SEALS);
+    check(seals >= 0 && (seals & F_SEAL_SHRINK) && (seals & F_SEAL_GROW) && (seals & F_SEAL_SEAL), "ring size is sealed");
+    check(ftruncate(writer.fd(), 4096) != 0, "sealed ring cannot shrink");
+
+    const int readers = 3;
+    int pipes[readers][2];
+    pid_t children[readers];
+    for (int i = 0; i < readers; ++i)
+    {
+        check(pipe(pipes[i]) == 0, "pipe");
+        children[i] = fork();
+        if (children[i] == 0)
+            slow_reader(path, pipes[i][1]);
+    }
+
+    // 写端每毫秒一帧，读端每帧持有 3ms
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < deadline)
+        writer.accept_readers();
+    int written = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        writer.accept_readers();
+        if (write_frame(writer, 'W', 100))
+            written++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(written == 1000, "writer never blocks with free slots");
+    // 关闭写端：读端看到连接断开后退出
+    uint64_t dropped = writer.header()->dropped.load();
+    writer.close();
+
+    for (int i = 0; i < readers; ++i)
+    {
+        ReaderResult result;
+        int status = 0;
+        waitpid(children[i], &status, 0);
+        bool ok = read(pipes[i][0], &result, sizeof(result)) == (ssize_t)sizeof(result);
+        close(pipes[i][0]);
+        close(pipes[i][1]);
+        check(ok && WIFEXITED(status) && WEXITSTATUS(status) == 0, "reader process finished");
+        std::cout << "reader " << i << ": " << result.acquired << " frames, " << result.skipped << " skipped, "
+                  << result.torn << " torn, " << result.out_of_order << " out of order" << std::endl;
+        check(result.acquired > 100, "reader received frames");
+        check(result.torn == 0, "frames are never torn");
+        check(result.out_of_order == 0, "sequence only moves forward");
+        check(result.skipped > 0, "slow reader skips to the latest frame");
+    }
+    std::cout << "writer: " << written << " frames, " << dropped << " dropped" << std::endl;
+}
+
+static void check_back_pressure_and_reclaim()
+{
+    SharedFrameRing writer;
+    check(writer.create(kFrameSize, 3), "create 3 slot ring");
+    SharedFrameRing first, second;
+    check(first.attach(dup(writer.fd())) && second.attach(dup(writer.fd())), "attach readers");
+
+    // 两个读者各持有一帧，第三个槽位是最新帧：没有可写的槽位
+    SharedFrameView a, b;
+    check(write_frame(writer, 'W', 0) && first.acquire_latest(a), "first reader holds a frame");
+    check(write_frame(writer, 'W', 0) && second.acquire_latest(b), "second reader holds a frame");
+    check(write_frame(writer, 'W', 0), "third slot is free");
+    check(a.slot != b.slot, "readers hold different slots");
+
+    auto start = std::chrono::steady_clock::now();
+    check(!write_frame(writer, 'W', 30), "writer times out while readers hold every slot");
+    double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    check(waited >= 25.0 && writer.header()->dropped.load() == 1, "back-pressure waits before dropping");
+
+    // 另一个线程释放后写端被唤醒
+    std::thread releaser([&]()
+                         {
+                             std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                             first.release(a); });
+    start = std::chrono::steady_clock::now();
+    check(write_frame(writer, 'W', 1000), "writer resumes after release");
+    waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    releaser.join();
+    std::cout << "back-pressure: resumed " << waited << " ms after waiting for a release" << std::endl;
+    check(waited < 200.0, "release wakes the writer");
+    second.release(b);
+
+    // 读端进程持有最新帧后崩溃
+    check(write_frame(writer, 'W', 0), "publish frame for crashing reader");
+    pid_t child = fork();
+    if (child == 0)
+    {
+        SharedFrameRing crashing;
+        SharedFrameView view;
+        _exit(crashing.attach(dup(writer.fd())) && crashing.acquire_latest(view) ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "crashing reader held a slot");
+    check(write_frame(writer, 'W', 0) && first.acquire_latest(a), "first reader holds the next frame");
+    check(write_frame(writer, 'W', 0) && second.acquire_latest(b), "second reader holds the latest frame");
+    check(write_frame(writer, 'W', 100), "slot of the crashed reader is reclaimed");
+    check(writer.header()->reclaimed.load() == 1, "one slot reclaimed");
+    first.release(a);
+    second.release(b);
+}
+
+// 子进程读端：连接（或直接映射）后不取帧就退出
+static bool attach_and_exit(SharedFrameRing &writer, const std::string &path)
+{
+    pid_t child = fork();
+    if (child == 0)
+    {
+        SharedFrameRing reader;
+        bool ok = path.empty() ? reader.attach(dup(writer.fd())) : connect_retry(reader, path, 1000);
+        _exit(ok ? 0 : 1);
+    }
+    // 连接时写端要在 accept_readers 中交出 memfd
+    int status = 0;
+    while (waitpid(child, &status, path.empty() ? 0 : WNOHANG) == 0)
+    {
+        writer.accept_readers();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void check_lease_reclaim()
+{
+    SharedFrameRing writer;
+    std::string path = socket_path("leases");
+    check(writer.create(kFrameSize, 3) && writer.listen(path), "create listening ring");
+
+    // 连接断开后写端回收租约
+    bool attached = true;
+    for (int i = 0; i < SHARED_RING_MAX_READERS + 4; ++i)
+        attached = attach_and_exit(writer, path) && attached;
+    check(attached, "more short-lived readers than leases connect");
+    writer.accept_readers();
+    int leased = 0;
+    for (const SharedReaderLease &lease : writer.header()->leases)
+        leased += lease.pid.load() != 0;
+    check(leased == 0, "dropped connections release their leases");
+
+    // 不经过套接字的读端：新读端 attach 时回收
+    attached = true;
+    for (int i = 0; i < SHARED_RING_MAX_READERS; ++i)
+        attached = attach_and_exit(writer, "") && attached;
+    check(attached, "direct readers attach");
+    SharedFrameRing late;
+    check(late.attach(dup(writer.fd())), "full lease table is reclaimed on attach");
+    late.close();
+    writer.close();
+}
+
+// 子进程中的写端：tag 标记是哪一次启动
+static void run_writer(const std::string &path, uint8_t tag)
+{
+    SharedFrameRing ring;
+    if (!ring.create(kFrameSize, 4) || !ring.listen(path))
+        _exit(1);
+    for (int i = 0; i < 2000; ++i)
+    {
+        ring.accept_readers();
+        write_frame(ring, tag, 50);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    _exit(0);
+}
+
+static void check_writer_restart()
+{
+    std::string path = socket_path("restart");
+    pid_t first_writer = fork();
+    if (first_writer == 0)
+        run_writer(path, 'A');
+
+    SharedFrameRing reader;
+    SharedFrameView held;
+    check(connect_retry(reader, path, 2000), "reader connects to the first writer");
+    for (int i = 0; i < 20 && !held.valid(); ++i)
+    {
+        if (reader.wait_for_frame(100))
+            reader.acquire_latest(held);
+    }
+    check(held.valid() && held.data[0] == 'A', "frame from the first writer");
+
+    // 写端崩溃：读端持有的帧仍然可读，连接断开被发现
+    kill(first_writer, SIGKILL);
+    waitpid(first_writer, nullptr, 0);
+    bool gone = false;
+    for (int i = 0; i < 50 && !gone; ++i)
+    {
+        gone = reader.writer_gone();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    check(gone, "reader notices the writer is gone");
+    check(held.valid() && held.data[0] == 'A' && frame_is_whole(held), "last frame survives the writer");
+    reader.release(held);
+
+    pid_t second_writer = fork();
+    if (second_writer == 0)
+        run_writer(path, 'B');
+    check(connect_retry(reader, path, 2000), "reader reconnects to the restarted writer");
+    int frames = 0;
+    for (int i = 0; i < 200 && frames < 10; ++i)
+    {
+        SharedFrameView view;
+        if (reader.wait_for_frame(100) && reader.acquire_latest(view))
+        {
+            check(view.data[0] == 'B' && frame_is_whole(view), "frames come from the new writer");
+            frames++;
+            reader.release(view);
+        }
+    }
+    check(frames == 10, "reader keeps receiving after the restart");
+    check(reader.reader_stats().connections == 2, "two connections");
+    reader.close();
+    kill(second_writer, SIGKILL);
+    waitpid(second_writer, nullptr, 0);
+    unlink(path.c_str());
+}
+
+int main()
+{
+    std::cout << "=== Shared frame ring, " << kFrameSize / 1024 << " KB frames ===" << std::endl;
+    check_concurrent_readers();
+    check_back_pressure_and_reclaim();
+    check_lease_reclaim();
+    check_writer_restart();
+
+    return check_result();
+}
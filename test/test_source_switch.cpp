@@ -0,0 +1,40 @@
+#include "../GstOpenGLPlayer.hpp"
+#include "check.hpp"
+
+#include <iostream>
+
+// 无窗口（EGL）播放中按帧数自动切换源：
+//   1. 三个 videotestsrc 图案循环切换，每个源显示 switch_every_frames 帧
+//   2. 切换次数与预期相符，每次都取到池中预热的管道
+//   3. 新源的帧上屏之后没有再出现旧源的帧
+// 需要 EGL 与 GStreamer 的 videotestsrc
+
+int main()
+{
+    std::cout << "=== Source switching (headless) ===" << std::endl;
+    const int frames = 300;
+    const int switch_every = 20;
+
+    PlayerOptions options;
+    options.headless = true;
+    options.headless_frames = frames;
+    options.prewarm_sources = {"test:ball", "test:smpte"};
+    options.pipeline_pool_size = 2;
+    options.switch_every_frames = switch_every;
+
+    GstOpenGLPlayer player(320, 240);
+    check(player.initialize("test", options), "headless player initializes");
+    player.run();
+
+    const SwitchStats &stats = player.switch_stats();
+    std::cout << "switches: " << stats.switches << " (" << stats.warm << " pre-warmed), avg "
+              << (stats.switches ? stats.total_ms / stats.switches : 0.0) << " ms, max " << stats.max_ms << " ms, "
+              << stats.stale << " stale frames" << std::endl;
+    // 每次切换到新源第一帧之前还会显示几帧旧画面，切换次数略少于 frames / switch_every
+    check(stats.switches >= (uint64_t)frames / switch_every / 2, "sources switch every N frames");
+    check(stats.switches <= (uint64_t)frames / switch_every, "no more switches than requested");
+    check(stats.warm == stats.switches, "every switch takes a pre-warmed pipeline");
+    check(stats.stale == 0, "no frame of an earlier source after the new one is shown");
+
+    return check_result();
+}
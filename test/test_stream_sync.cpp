@@ -0,0 +1,231 @@
+#include "gst/gst.h"
+#include "gst/app/gstappsink.h"
+#include "../StreamSync.hpp"
+#include "check.hpp"
+
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 多路同步播放：先录制 3 路同步的本地文件（相同的 30fps 时间戳，JPEG + AVI），再
+//   1. 各自的时钟、依次启动（间隔 150ms，模拟打开文件快慢不一）、各路显示最新到达的帧：测得的偏差约为启动间隔
+//   2. StreamSync 共用时钟与 base time，按共同运行时间选帧：每次绘制各路显示的帧 PTS 相同（逐帧对齐）
+// 缺少 jpegenc / avimux / avidemux / jpegdec 时跳过
+
+static const int kStreams = 3;
+static const int kFrames = 90;
+static const int kFps = 30;
+
+static bool run_to_eos(GstElement *pipeline)
+{
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    GstBus *bus = gst_element_get_bus(pipeline);
+    GstMessage *msg = gst_bus_timed_pop_filtered(bus, 20 * GST_SECOND, (GstMessageType)(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    bool ok = msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+    if (msg)
+        gst_message_unref(msg);
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    return ok;
+}
+
+static bool record(const std::string &path, int pattern)
+{
+    std::string launch = "videotestsrc num-buffers=" + std::to_string(kFrames) + " pattern=" + std::to_string(pattern) +
+                         " ! video/x-raw,width=320,height=180,framerate=" + std::to_string(kFps) + "/1"
+                         " ! jpegenc ! avimux ! filesink location=\"" + path + "\"";
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch(launch.c_str(), &error);
+    if (error)
+    {
+        std::cout << "Failed to create recorder: " << error->message << std::endl;
+        g_error_free(error);
+        return false;
+    }
+    bool ok = run_to_eos(pipeline);
+    gst_object_unref(pipeline);
+    return ok;
+}
+
+struct Player
+{
+    GstElement *pipeline = nullptr;
+    GstElement *appsink = nullptr;
+    SyncedSink synced;
+};
+
+static bool create_players(const std::vector<std::string> &paths, std::vector<Player> &players)
+{
+    for (const std::string &path : paths)
+    {
+        Player player;
+        std::string launch = "filesrc location=\"" + path + "\" ! avidemux ! jpegdec ! videoconvert ! "
+                             "video/x-raw,format=RGBA ! appsink name=sink";
+        GError *error = nullptr;
+        player.pipeline = gst_parse_launch(launch.c_str(), &error);
+        if (error)
+        {
+            std::cout << "Failed to create player: " << error->message << std::endl;
+            g_error_free(error);
+            return false;
+        }
+        player.appsink = gst_bin_get_by_name(GST_BIN(player.pipeline), "sink");
+        player.synced.appsink = GST_APP_SINK(player.appsink);
+        players.push_back(player);
+    }
+    return true;
+}
+
+static void destroy_players(std::vector<Player> &players)
+{
+    for (Player &player : players)
+    {
+        gst_element_set_state(player.pipeline, GST_STATE_NULL);
+        StreamSync::reset(player.synced);
+        gst_object_unref(player.appsink);
+        gst_object_unref(player.pipeline);
+    }
+    players.clear();
+}
+
+// 模拟 60Hz 的渲染循环，target 返回每次绘制的目标运行时间，返回各路显示过的帧数之和
+static uint64_t render(std::vector<Player> &players, StreamSync &sync, GstClockTime (*target)(const StreamSync &))
+{
+    uint64_t shown = 0;
+    gint64 deadline = g_get_monotonic_time() + (gint64)(kFrames / kFps + 3) * G_USEC_PER_SEC;
+    while (g_get_monotonic_time() < deadline)
+    {
+        bool any = false, finished = true;
+        std::vector<const SyncedSink *> sinks;
+        for (Player &player : players)
+        {
+            GstSample *sample = StreamSync::pull_due(player.synced, target(sync));
+            if (sample)
+            {
+                gst_sample_unref(sample);
+                shown++;
+                any = true;
+            }
+            if (player.synced.pending || !gst_app_sink_is_eos(player.synced.appsink))
+                finished = false;
+            sinks.push_back(&player.synced);
+        }
+        if (any)
+            sync.record_skew(sinks);
+        if (finished)
+            break;
+        g_usleep(G_USEC_PER_SEC / 60);
+    }
+    return shown;
+}
+
+// 不同步：各路显示已经到达的最新一帧
+static GstClockTime latest(const StreamSync &)
+{
+    return GST_CLOCK_TIME_NONE;
+}
+
+static GstClockTime common(const StreamSync &sync)
+{
+    return sync.running_time();
+}
+
+static void print_skew(const char *name, const SkewStats &skew, uint64_t shown)
+{
+    std::cout << std::left << std::setw(14) << name << std::fixed << std::setprecision(2)
+              << " skew avg=" << std::setw(7) << (skew.samples ? skew.sum_ms / skew.samples : 0.0) << "ms"
+              << " max=" << std::setw(7) << skew.max_ms << "ms"
+              << " off by a frame: " << skew.over_frame << "/" << skew.samples
+              << ", " << shown << " frames shown" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+    const char *required[] = {"jpegenc", "avimux", "avidemux", "jpegdec"};
+    for (const char *name : required)
+    {
+        GstElementFactory *factory = gst_element_factory_find(name);
+        if (!factory)
+        {
+            std::cout << "Missing " << name << ", skipped" << std::endl;
+            return 0;
+        }
+        gst_object_unref(factory);
+    }
+
+    std::vector<std::string> paths;
+    for (int i = 0; i < kStreams; ++i)
+    {
+        gchar *path = g_build_filename(g_get_tmp_dir(), ("stream_sync_" + std::to_string(i) + ".avi").c_str(), nullptr);
+        paths.push_back(path);
+        g_free(path);
+        if (!record(paths.back(), i))
+        {
+            std::cout << "Failed to record " << paths.back() << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "=== Synchronized playback, " << kStreams << " recordings of " << kFrames << " frames @ " << kFps << "fps ===" << std::endl;
+
+    // 1. 各自的时钟，依次启动
+    std::vector<Player> players;
+    check(create_players(paths, players), "create players");
+    StreamSync unsynced;
+    for (Player &player : players)
+    {
+        g_object_set(player.appsink, "sync", TRUE, "max-buffers", 1, "drop", TRUE, nullptr);
+        gst_element_set_state(player.pipeline, GST_STATE_PLAYING);
+        g_usleep(150 * 1000);
+    }
+    uint64_t shown = render(players, unsynced, latest);
+    print_skew("independent", unsynced.skew(), shown);
+    check(unsynced.skew().max_ms >= 100.0, "staggered independent pipelines drift apart");
+    destroy_players(players);
+
+    // 2. 共用时钟与 base time，按共同运行时间选帧
+    check(create_players(paths, players), "create players");
+    StreamSync sync;
+    std::vector<GstElement *> pipelines;
+    for (Player &player : players)
+    {
+        StreamSync::configure_appsink(player.appsink);
+        pipelines.push_back(player.pipeline);
+    }
+    check(sync.start(pipelines), "synchronized start");
+    GstClock *clock = gst_pipeline_get_clock(GST_PIPELINE(players[0].pipeline));
+    for (Player &player : players)
+    {
+        GstClock *own = gst_pipeline_get_clock(GST_PIPELINE(player.pipeline));
+        check(own == clock && own == sync.clock(), "pipelines share one clock");
+        check(gst_element_get_base_time(player.pipeline) == sync.base_time(), "pipelines share one base time");
+        if (own)
+            gst_object_unref(own);
+    }
+    if (clock)
+        gst_object_unref(clock);
+
+    shown = render(players, sync, common);
+    const SkewStats &skew = sync.skew();
+    print_skew("shared clock", skew, shown);
+    check(skew.samples > kFrames / 2, "skew measured on every new frame");
+    check(skew.over_frame == 0 && skew.max_ms < 1.0, "recordings stay frame-aligned");
+    uint64_t skipped = 0, pulled = 0, counted = 0;
+    for (Player &player : players)
+    {
+        skipped += player.synced.skipped;
+        pulled += player.synced.pulled;
+        counted += player.synced.shown;
+    }
+    check(shown + skipped == (uint64_t)kStreams * kFrames, "every frame is either shown or skipped as late");
+    check(pulled == (uint64_t)kStreams * kFrames && counted == shown, "per-stream counters match");
+    check(skipped <= (uint64_t)kStreams * kFrames / 10, "few frames skipped at 60Hz");
+    destroy_players(players);
+
+    for (const std::string &path : paths)
+        std::remove(path.c_str());
+
+    return check_result();
+}
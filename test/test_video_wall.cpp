@@ -0,0 +1,164 @@
+#include "glad/glad.h"
+#include "../OffscreenContext.hpp"
+#include "../VideoWall.hpp"
+#include "../gl_utils.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// 电视墙检查：
+//   1. 网格 / 固定网格 / 自定义布局的解析
+//   2. 离屏上下文中 N 路纯色层一次实例化绘制，每个格子中心是对应层的颜色，格子内按宽高比留黑边
+//   3. 重新初始化为 64 路后每帧一次绘制画出 64 个实例，最后一格显示第 63 层
+// 没有 EGL 时只做布局检查
+
+static bool same(float a, float b)
+{
+    return std::fabs(a - b) < 1e-4f;
+}
+
+static void check_layouts()
+{
+    std::vector<WallTile> tiles = wall_grid_layout(5);
+    check(tiles.size() == 5, "grid has one tile per stream");
+    check(same(tiles[0].width, 1.0f / 3) && same(tiles[0].height, 0.5f), "5 streams use a 3x2 grid");
+    check(same(tiles[4].x, 1.0f / 3) && same(tiles[4].y, 0.5f), "row-major order");
+
+    check(parse_wall_layout("4x4", 16, tiles) && tiles.size() == 16 && same(tiles[15].x, 0.75f), "fixed grid");
+    check(parse_wall_layout("2x1", 4, tiles) && tiles.size() == 2, "extra streams get no tile");
+    check(parse_wall_layout("0,0,0.75,1;0.75,0,0.25,0.5;0.75,0.5,0.25,0.5", 3, tiles) && tiles.size() == 3 &&
+              same(tiles[2].y, 0.5f) && same(tiles[0].width, 0.75f),
+          "custom layout");
+    check(!parse_wall_layout("0,0,1", 1, tiles), "incomplete rect is rejected");
+    check(!parse_wall_layout("0.5,0,0.75,1", 1, tiles), "rect outside the window is rejected");
+    check(!parse_wall_layout("0x3", 1, tiles), "empty grid is rejected");
+}
+
+static bool near(const uint8_t *pixel, int r, int g, int b)
+{
+    return std::abs(pixel[0] - r) <= 2 && std::abs(pixel[1] - g) <= 2 && std::abs(pixel[2] - b) <= 2;
+}
+
+static uint8_t layer_color(int layer, int channel)
+{
+    return (uint8_t)((layer * 37 + channel * 91 + 20) & 0xFF);
+}
+
+int main()
+{
+    check_layouts();
+
+    OffscreenContext context;
+    if (!context.create() || !context.make_current() || !gladLoadGLLoader((GLADloadproc)OffscreenContext::get_proc_address))
+    {
+        std::cout << "No offscreen GL context, GPU cases skipped" << std::endl;
+        return check_result();
+    }
+    load_gl_extensions((GLADloadproc)OffscreenContext::get_proc_address);
+    std::cout << "=== Video wall, " << glGetString(GL_RENDERER) << " ===" << std::endl;
+
+    // 400x200 目标，16:9 的层
+    const int target_width = 400, target_height = 200;
+    GLuint fbo = 0, color = 0;
+    glGenTextures(1, &color);
+    glBindTexture(GL_TEXTURE_2D, color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, target_width, target_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+
+    const int streams = 4, layer_width = 64, layer_height = 36;
+    VideoWall wall;
+    check(wall.init(streams, layer_width, layer_height), "wall init");
+
+    // 带行填充的纯色帧
+    const int stride = layer_width * 4 + 32;
+    std::vector<uint8_t> frame((size_t)stride * layer_height);
+    for (int layer = 0; layer < streams; ++layer)
+    {
+        for (int y = 0; y < layer_height; ++y)
+            for (int x = 0; x < layer_width; ++x)
+                for (int c = 0; c < 4; ++c)
+                    frame[(size_t)y * stride + x * 4 + c] = c == 3 ? 255 : layer_color(layer, c);
+        wall.upload_layer(layer, frame.data(), stride, GL_RGBA);
+    }
+
+    std::vector<uint8_t> pixels((size_t)target_width * target_height * 4);
+    auto read = [&]()
+    {
+        glReadPixels(0, 0, target_width, target_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    };
+    // 读回的第 0 行是帧缓冲底部，转换成布局坐标（原点左上）
+    auto at = [&](int x, int y) -> const uint8_t *
+    {
+        return pixels.data() + ((size_t)(target_height - 1 - y) * target_width + x) * 4;
+    };
+
+    // 2x2 网格：每格 200x100，16:9 的层放进 2:1 的格子左右留黑边
+    wall.draw(target_width, target_height);
+    read();
+    const int centers[4][2] = {{100, 50}, {300, 50}, {100, 150}, {300, 150}};
+    for (int i = 0; i < streams; ++i)
+        check(near(at(centers[i][0], centers[i][1]), layer_color(i, 0), layer_color(i, 1), layer_color(i, 2)), "tile shows its layer");
+    check(near(at(5, 50), 0, 0, 0) && near(at(395, 150), 0, 0, 0), "tiles are pillarboxed");
+
+    // 自定义布局：第 0 路占左半边，其余三路在右侧竖排
+    std::vector<WallTile> tiles;
+    check(parse_wall_layout("0,0,0.5,1;0.5,0,0.5,0.3333;0.5,0.3333,0.5,0.3333;0.5,0.6667,0.5,0.3333", streams, tiles), "parse custom layout");
+    wall.set_layout(tiles);
+    wall.draw(target_width, target_height);
+    read();
+    check(near(at(100, 100), layer_color(0, 0), layer_color(0, 1), layer_color(0, 2)), "large tile");
+    check(near(at(300, 33), layer_color(1, 0), layer_color(1, 1), layer_color(1, 2)), "top right tile");
+    check(near(at(300, 166), layer_color(3, 0), layer_color(3, 1), layer_color(3, 2)), "bottom right tile");
+    check(near(at(100, 5), 0, 0, 0), "large tile is letterboxed");
+
+    // 单个格子指定显示第 2 路（放大某一路）
+    WallTile focus;
+    focus.layer = 2;
+    wall.set_layout(std::vector<WallTile>(1, focus));
+    wall.draw(target_width, target_height);
+    read();
+    check(near(at(200, 100), layer_color(2, 0), layer_color(2, 1), layer_color(2, 2)), "tile selects its layer");
+
+    // 同一面墙重新初始化为 64 路：8x8 网格，每帧一次绘制画出全部 64 个实例
+    wall.destroy();
+    check(wall.init(64, layer_width, layer_height), "64 layer wall");
+    check(wall.layout().size() == 64, "re-init lays out a grid for the new layer count");
+    check(wall.stats().frames == 0 && wall.stats().layer_uploads == 0, "re-init resets the statistics");
+    wall.set_layout(wall_grid_layout(64));
+    for (int layer = 0; layer < 64; ++layer)
+    {
+        for (int y = 0; y < layer_height; ++y)
+            for (int x = 0; x < layer_width; ++x)
+                for (int c = 0; c < 4; ++c)
+                    frame[(size_t)y * stride + x * 4 + c] = c == 3 ? 255 : layer_color(layer, c);
+        wall.upload_layer(layer, frame.data(), stride, GL_RGBA);
+    }
+    const int wall_frames = 10;
+    for (int i = 0; i < wall_frames; ++i)
+    {
+        wall.draw(target_width, target_height);
+        check(wall.instance_count() == 64, "every frame draws all 64 tiles");
+    }
+    read();
+    const WallStats &stats = wall.stats();
+    check(stats.frames == wall_frames && stats.draw_calls == wall_frames, "one draw call per frame");
+    check(stats.layer_uploads == 64, "one upload per stream frame");
+    // 最后一格（右下角）显示第 63 层
+    const WallTile &last = wall.layout()[63];
+    int last_x = (int)((last.x + last.width / 2) * target_width);
+    int last_y = (int)((last.y + last.height / 2) * target_height);
+    check(near(at(last_x, last_y), layer_color(63, 0), layer_color(63, 1), layer_color(63, 2)), "tile 63 shows layer 63");
+    std::cout << "64 streams: " << stats.upload_total_us / stats.layer_uploads << "us per layer upload" << std::endl;
+    check(glGetError() == GL_NO_ERROR, "no GL errors");
+
+    wall.destroy();
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &color);
+
+    return check_result();
+}